@@ -0,0 +1,109 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of EEMD throughput as a function of the number of threads, for
+// both ways of summing the ensemble members to the output matrix, with OpenMP
+// and with the thread pool of the plan. Backends that libeemd was built
+// without are skipped. Usage:
+//
+//   eemd_scaling_benchmark [max_threads] [N]
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <gsl/gsl_math.h>
+const double pi = M_PI;
+
+#include "eemd.h"
+
+const unsigned int members_per_thread = 32;
+const unsigned int S_number = 4;
+const unsigned int num_siftings = 50;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 0;
+const int repeats = 3;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+	unsigned int max_threads = (argc > 1)? (unsigned int)atoi(argv[1]) : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	const size_t N = (argc > 2)? (size_t)atol(argv[2]) : 512;
+	if (max_threads < 1) {
+		max_threads = 1;
+	}
+	double* inp = malloc(N*sizeof(double));
+	for (size_t i=0; i<N; i++) {
+		inp[i] = sin(2*pi*i/50.0) + 0.5*sin(2*pi*i/7.0);
+	}
+	const size_t M = emd_num_imfs(N);
+	double* outp = malloc(M*N*sizeof(double));
+	const char* mode_names[] = {"locked", "private"};
+	const char* backend_names[] = {"openmp", "pool"};
+	printf("# N=%zu, %u ensemble members per thread\n", N, members_per_thread);
+	printf("# threads   backend   mode      seconds   members/s\n");
+	// Thread counts are powers of two, followed by max_threads
+	for (unsigned int threads=1; ; threads*=2) {
+		if (threads > max_threads) {
+			threads = max_threads;
+		}
+		const unsigned int ensemble_size = members_per_thread*threads;
+		for (int backend=EMD_THREADS_OPENMP; backend<=EMD_THREADS_POOL; backend++) {
+			for (int mode=EMD_ACCUMULATE_LOCKED; mode<=EMD_ACCUMULATE_PRIVATE; mode++) {
+				emd_plan_options options;
+				emd_plan_options_init(&options);
+				options.accumulation = (emd_accumulation_mode)mode;
+				options.threading = (emd_threading)backend;
+				emd_plan* plan = emd_plan_create_with_options(EMD_VARIANT_EEMD, N, M,
+						ensemble_size, threads, &options);
+				if (plan == NULL) {
+					continue;
+				}
+				double best = INFINITY;
+				for (int r=0; r<repeats; r++) {
+					const double start = now();
+					libeemd_error_code err = emd_plan_execute(plan, inp, outp,
+							noise_strength, S_number, num_siftings, rng_seed);
+					const double elapsed = now() - start;
+					if (err != EMD_SUCCESS) {
+						emd_report_if_error(err);
+						exit(1);
+					}
+					if (elapsed < best) {
+						best = elapsed;
+					}
+				}
+				printf("%9u   %-8s  %-8s %9.4f %11.1f\n", threads, backend_names[backend],
+						mode_names[mode], best, ensemble_size/best);
+				emd_plan_destroy(plan);
+			}
+		}
+		if (threads == max_threads) {
+			break;
+		}
+	}
+	free(inp); inp = NULL;
+	free(outp); outp = NULL;
+	return 0;
+}
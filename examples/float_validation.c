@@ -0,0 +1,184 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Validation of the single-precision decomposition against the double
+// precision one. Each test signal is decomposed with EMD, EEMD and CEEMDAN
+// in double precision and in single precision, with the ensemble sums in
+// both double and single precision. The program reports the largest and the
+// root-mean-square difference of the IMFs and of their sums, all relative to
+// the RMS of the signal, and the number of leading IMFs whose largest
+// difference is below 10^-3 of it, together with the time taken by both. A
+// fixed number of siftings is used, since with the S-number criterion a
+// rounding difference can change the number of siftings and therefore the
+// IMFs themselves. Usage:
+//
+//   float_validation [threads]
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+const double pi = M_PI;
+
+#include "eemd.h"
+
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned int ensemble_size = 32;
+const unsigned long int rng_seed = 0;
+const int repeats = 3;
+const double imf_tolerance = 1e-3;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static emd_plan* create_plan(emd_variant variant, size_t N, unsigned int E,
+		unsigned int threads, emd_precision precision, emd_precision sum_precision) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.precision = precision;
+	options.sum_precision = sum_precision;
+	emd_plan* plan = emd_plan_create_with_options(variant, N, 0, E, threads, &options);
+	if (plan == NULL) {
+		fprintf(stderr, "Creating a plan failed\n");
+		exit(1);
+	}
+	return plan;
+}
+
+static void check(libeemd_error_code err) {
+	if (err != EMD_SUCCESS) {
+		emd_report_if_error(err);
+		exit(1);
+	}
+}
+
+static void validate(const char* signal_name, double const* inp, size_t N,
+		const char* method_name, emd_variant variant, unsigned int E,
+		double noise, unsigned int threads) {
+	const size_t M = emd_num_imfs(N);
+	float* inpf = malloc(N*sizeof(float));
+	double* outp = malloc(M*N*sizeof(double));
+	float* outpf = malloc(M*N*sizeof(float));
+	double rms = 0;
+	for (size_t i=0; i<N; i++) {
+		inpf[i] = (float)inp[i];
+		rms += inp[i]*inp[i];
+	}
+	rms = sqrt(rms/N);
+	// Reference in double precision
+	emd_plan* plan = create_plan(variant, N, E, threads, EMD_PRECISION_DOUBLE, EMD_PRECISION_DOUBLE);
+	double t_double = INFINITY;
+	for (int r=0; r<repeats; r++) {
+		const double start = now();
+		check(emd_plan_execute(plan, inp, outp, noise, 0, num_siftings, rng_seed));
+		const double elapsed = now() - start;
+		if (elapsed < t_double) {
+			t_double = elapsed;
+		}
+	}
+	emd_plan_destroy(plan);
+	const emd_precision sum_precisions[] = {EMD_PRECISION_DOUBLE, EMD_PRECISION_FLOAT};
+	const char* sum_names[] = {"double", "float"};
+	for (int k=0; k<2; k++) {
+		plan = create_plan(variant, N, E, threads, EMD_PRECISION_FLOAT, sum_precisions[k]);
+		double t_float = INFINITY;
+		for (int r=0; r<repeats; r++) {
+			const double start = now();
+			check(emd_plan_execute_float(plan, inpf, outpf, noise, 0, num_siftings, rng_seed));
+			const double elapsed = now() - start;
+			if (elapsed < t_float) {
+				t_float = elapsed;
+			}
+		}
+		emd_plan_destroy(plan);
+		double max_err = 0;
+		double sq_err = 0;
+		size_t matching_imfs = M;
+		for (size_t m=0; m<M; m++) {
+			double max_imf_err = 0;
+			for (size_t i=0; i<N; i++) {
+				const double err = fabs(outpf[m*N+i] - outp[m*N+i]);
+				max_imf_err = (err > max_imf_err)? err : max_imf_err;
+				sq_err += err*err;
+			}
+			max_err = (max_imf_err > max_err)? max_imf_err : max_err;
+			if (max_imf_err > imf_tolerance*rms && matching_imfs == M) {
+				matching_imfs = m;
+			}
+		}
+		// The IMFs of EEMD add up to the signal plus the mean of the noise,
+		// so compare their sums to each other instead of to the signal
+		double max_sum_err = 0;
+		for (size_t i=0; i<N; i++) {
+			double sum = 0, sumf = 0;
+			for (size_t m=0; m<M; m++) {
+				sum += outp[m*N+i];
+				sumf += outpf[m*N+i];
+			}
+			const double err = fabs(sumf - sum);
+			max_sum_err = (err > max_sum_err)? err : max_sum_err;
+		}
+		printf("%-10s %-8s %-7s %11.3e %11.3e %11.3e %6zu/%-3zu %11.2f %11.2f %8.2f\n",
+				signal_name, method_name, sum_names[k], max_err/rms,
+				sqrt(sq_err/(M*N))/rms, max_sum_err/rms, matching_imfs, M,
+				1e3*t_double, 1e3*t_float, t_double/t_float);
+	}
+	free(outpf);
+	free(outp);
+	free(inpf);
+}
+
+int main(int argc, char** argv) {
+	const unsigned int threads = (argc > 1)? (unsigned int)atoi(argv[1]) : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	gsl_rng* r = gsl_rng_alloc(gsl_rng_mt19937);
+	printf("# %u threads, %u siftings, ensemble size %u\n", threads, num_siftings, ensemble_size);
+	printf("# signal   method   sums     max error   rms error   sum error  matching  double [ms]  float [ms]  speedup\n");
+	// A smooth signal with a trend
+	const size_t N1 = 4096;
+	double* tones = malloc(N1*sizeof(double));
+	for (size_t i=0; i<N1; i++) {
+		tones[i] = sin(2*pi*i/50.0) + 0.5*sin(2*pi*i/7.0) + 1e-3*i;
+	}
+	// A noisy sensor signal quantized to 24 bits
+	const size_t N2 = 65536;
+	double* sensor = malloc(N2*sizeof(double));
+	for (size_t i=0; i<N2; i++) {
+		const double x = 0.5*sin(2*pi*i/1000.0) + 0.1*sin(2*pi*i/37.0)
+			+ gsl_ran_gaussian(r, 0.05);
+		sensor[i] = round(x*(1 << 23))/(1 << 23);
+	}
+	validate("tones", tones, N1, "EMD", EMD_VARIANT_EEMD, 1, 0.0, threads);
+	validate("tones", tones, N1, "EEMD", EMD_VARIANT_EEMD, ensemble_size, noise_strength, threads);
+	validate("tones", tones, N1, "CEEMDAN", EMD_VARIANT_CEEMDAN, ensemble_size, noise_strength, threads);
+	validate("sensor", sensor, N2, "EMD", EMD_VARIANT_EEMD, 1, 0.0, threads);
+	validate("sensor", sensor, N2, "EEMD", EMD_VARIANT_EEMD, ensemble_size, noise_strength, threads);
+	validate("sensor", sensor, N2, "CEEMDAN", EMD_VARIANT_CEEMDAN, ensemble_size, noise_strength, threads);
+	free(sensor);
+	free(tones);
+	gsl_rng_free(r);
+	return 0;
+}
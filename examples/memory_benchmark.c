@@ -0,0 +1,137 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the peak memory used by plans. For white noise, which has an
+// extremum at about every third point, and for a smooth signal with few
+// extrema, EMD, EEMD and CEEMDAN plans are created and executed for signals
+// of 10^4 samples up to max_N. The program reports the size of the block of
+// the plan (emd_plan_workspace_size), which covers the worst case, and how
+// much the peak resident memory of the process grew while creating and
+// executing the plan, i.e., the memory that was actually touched, also per
+// thread and sample. Each measurement is made in a child process of its own,
+// since the peak resident memory of a process never decreases. Usage:
+//
+//   memory_benchmark [threads] [max_N]
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+const double pi = M_PI;
+
+#include "eemd.h"
+
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 0;
+
+// Peak resident memory of this process in bytes. Linux reports ru_maxrss in
+// kilobytes, macOS in bytes.
+static double peak_rss(void) {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	#ifdef __APPLE__
+	return (double)usage.ru_maxrss;
+	#else
+	return 1024.0*(double)usage.ru_maxrss;
+	#endif
+}
+
+static void measure(const char* signal_name, double const* inp, size_t N,
+		const char* method_name, emd_variant variant, unsigned int E,
+		double noise, unsigned int threads) {
+	fflush(stdout);
+	const pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		exit(1);
+	}
+	if (pid > 0) {
+		int status;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "Measuring %s %s N=%zu failed\n", signal_name, method_name, N);
+			exit(1);
+		}
+		return;
+	}
+	// The output is touched before the first measurement, so that only the
+	// memory of the plan is counted. It is not filled with zeros, since the
+	// compiler may replace that with calloc, which does not touch it.
+	const size_t M = emd_num_imfs(N);
+	double* outp = malloc(M*N*sizeof(double));
+	for (size_t i=0; i<M*N; i++) {
+		outp[i] = 1;
+	}
+	const size_t block = emd_plan_workspace_size(variant, N, 0, E, threads, NULL);
+	const double before = peak_rss();
+	emd_plan* plan = emd_plan_create(variant, N, 0, E, threads);
+	if (plan == NULL) {
+		fprintf(stderr, "Creating a plan failed\n");
+		_exit(1);
+	}
+	libeemd_error_code err = emd_plan_execute(plan, inp, outp, noise, 0, num_siftings, rng_seed);
+	if (err != EMD_SUCCESS) {
+		emd_report_if_error(err);
+		_exit(1);
+	}
+	const double touched = peak_rss() - before;
+	const unsigned int plan_threads = emd_plan_get_num_threads(plan);
+	emd_plan_destroy(plan);
+	printf("%-7s %10zu %-8s %7u %14.1f %14.1f %8.1f%% %14.1f\n",
+			signal_name, N, method_name, plan_threads, block/1048576.0,
+			touched/1048576.0, 100.0*touched/block,
+			touched/((double)plan_threads*N));
+	fflush(stdout);
+	free(outp);
+	_exit(0);
+}
+
+int main(int argc, char** argv) {
+	const unsigned int threads = (argc > 1)? (unsigned int)atoi(argv[1]) : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	const size_t max_N = (argc > 2)? (size_t)atol(argv[2]) : 1000000;
+	gsl_rng* r = gsl_rng_alloc(gsl_rng_mt19937);
+	double* white = malloc(max_N*sizeof(double));
+	double* smooth = malloc(max_N*sizeof(double));
+	for (size_t i=0; i<max_N; i++) {
+		white[i] = gsl_ran_gaussian(r, 1.0);
+		smooth[i] = sin(2*pi*i/5000.0) + 0.5*sin(2*pi*i/1300.0) + 1e-6*i;
+	}
+	printf("# %u threads, %u siftings, ensemble size 2*threads\n", threads, num_siftings);
+	printf("# signal         N method   threads    block [MiB]  touched [MiB]   touched  bytes/thread/sample\n");
+	for (size_t N=10000; N<=max_N; N*=10) {
+		double const* const signals[] = {white, smooth};
+		const char* signal_names[] = {"white", "smooth"};
+		for (int s=0; s<2; s++) {
+			measure(signal_names[s], signals[s], N, "EMD", EMD_VARIANT_EEMD, 1, 0.0, 1);
+			measure(signal_names[s], signals[s], N, "EEMD", EMD_VARIANT_EEMD, 2*threads, noise_strength, threads);
+			measure(signal_names[s], signals[s], N, "CEEMDAN", EMD_VARIANT_CEEMDAN, 2*threads, noise_strength, threads);
+		}
+	}
+	free(smooth);
+	free(white);
+	gsl_rng_free(r);
+	return 0;
+}
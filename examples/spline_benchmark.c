@@ -0,0 +1,147 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of emd_evaluate_spline against a reference implementation that
+// solves the spline coefficients with gsl_linalg_solve_tridiag, which is what
+// libeemd used to do. For a range of knot counts the program reports the time
+// per call of both implementations and the largest relative difference
+// between the spline values they produce.
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_linalg.h>
+
+#include "eemd.h"
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+// Reference not-a-knot spline evaluation using GSL for the tridiagonal solve
+static void reference_spline(double const* x, double const* y, size_t N,
+		double* spline_y, double* ws) {
+	const size_t n = N-1;
+	const size_t sys_size = N-2;
+	double* const c = ws;
+	double* const diag = c+N;
+	double* const supdiag = diag + sys_size;
+	double* const subdiag = supdiag + (sys_size-1);
+	double* const g = subdiag + (sys_size-1);
+	const double h_0 = x[1]-x[0];
+	const double h_1 = x[2]-x[1];
+	const double h_nm1 = x[n]-x[n-1];
+	const double h_nm2 = x[n-1]-x[n-2];
+	diag[0] = h_0 + 2*h_1;
+	supdiag[0] = h_1 - h_0;
+	g[0] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
+	for (size_t i=2; i<=n-2; i++) {
+		const double h_i = x[i+1] - x[i];
+		const double h_im1 = x[i] - x[i-1];
+		subdiag[i-2] = h_im1;
+		diag[i-1] = 2*(h_im1 + h_i);
+		supdiag[i-1] = h_i;
+		g[i-1] = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
+	}
+	subdiag[n-3] = h_nm2 - h_nm1;
+	diag[n-2] = 2*h_nm2 + h_nm1;
+	g[n-2] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]));
+	gsl_vector_view diag_vec = gsl_vector_view_array(diag, n-1);
+	gsl_vector_view supdiag_vec = gsl_vector_view_array(supdiag, n-2);
+	gsl_vector_view subdiag_vec = gsl_vector_view_array(subdiag, n-2);
+	gsl_vector_view g_vec = gsl_vector_view_array(g, n-1);
+	gsl_vector_view solution_vec = gsl_vector_view_array(c+1, n-1);
+	gsl_linalg_solve_tridiag(&diag_vec.vector, &supdiag_vec.vector,
+			&subdiag_vec.vector, &g_vec.vector, &solution_vec.vector);
+	c[0] = c[1] + (h_0/h_1)*(c[1]-c[2]);
+	c[n] = c[n-1] + (h_nm1/h_nm2)*(c[n-1]-c[n-2]);
+	const size_t max_j = (size_t)x[n];
+	size_t i = 0;
+	for (size_t j=0; j<=max_j; j++) {
+		if (j > x[i+1]) {
+			i++;
+		}
+		const double dx = j-x[i];
+		if (dx == 0) {
+			spline_y[j] = y[i];
+			continue;
+		}
+		const double h_i = x[i+1] - x[i];
+		const double b_i = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
+		const double d_i = (c[i+1]-c[i])/(3.0*h_i);
+		spline_y[j] = y[i] + dx*(b_i + dx*(c[i] + dx*d_i));
+	}
+}
+
+int main(void) {
+	const size_t knot_counts[] = {4, 8, 16, 64, 256, 1024, 4096, 16384, 65536, 262144};
+	const size_t num_counts = sizeof(knot_counts)/sizeof(knot_counts[0]);
+	gsl_rng* r = gsl_rng_alloc(gsl_rng_mt19937);
+	printf("#  knots   gsl [us/call]   libeemd [us/call]   speedup   max rel. diff\n");
+	for (size_t k=0; k<num_counts; k++) {
+		const size_t N = knot_counts[k];
+		double* x = malloc(N*sizeof(double));
+		double* y = malloc(N*sizeof(double));
+		// Knots at integer and half-integer points, as produced by
+		// emd_find_extrema
+		x[0] = 0;
+		y[0] = gsl_rng_uniform(r);
+		for (size_t i=1; i<N; i++) {
+			x[i] = x[i-1] + 1 + 0.5*(double)gsl_rng_uniform_int(r, 8);
+			y[i] = gsl_rng_uniform(r);
+		}
+		x[N-1] = ceil(x[N-1]);
+		const size_t num_points = (size_t)x[N-1] + 1;
+		double* ref = malloc(num_points*sizeof(double));
+		double* out = malloc(num_points*sizeof(double));
+		double* ws = malloc(5*N*sizeof(double));
+		// Repeat enough times to make the timing meaningful
+		const size_t repeats = 1 + 4000000/num_points;
+		double start = now();
+		for (size_t rep=0; rep<repeats; rep++) {
+			reference_spline(x, y, N, ref, ws);
+		}
+		const double t_gsl = (now() - start)/repeats;
+		start = now();
+		for (size_t rep=0; rep<repeats; rep++) {
+			libeemd_error_code err = emd_evaluate_spline(x, y, N, out, ws);
+			if (err != EMD_SUCCESS) {
+				emd_report_if_error(err);
+				exit(1);
+			}
+		}
+		const double t_emd = (now() - start)/repeats;
+		double max_diff = 0;
+		for (size_t j=0; j<num_points; j++) {
+			const double diff = fabs(out[j]-ref[j])/fmax(fabs(ref[j]), 1.0);
+			if (diff > max_diff) {
+				max_diff = diff;
+			}
+		}
+		printf("%8zu %15.3f %19.3f %9.2f %15.3g\n", N, 1e6*t_gsl, 1e6*t_emd, t_gsl/t_emd, max_diff);
+		free(ws); free(out); free(ref); free(y); free(x);
+	}
+	gsl_rng_free(r);
+	return 0;
+}
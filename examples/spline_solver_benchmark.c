@@ -0,0 +1,109 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the sequential and the partitioned solver for the envelope
+// splines when all threads sift a single signal together. For a range of
+// signal lengths the program extracts the first IMF of white noise with a
+// fixed number of siftings, once with the sequential solver and once with the
+// partitioned one, and reports the time per sifting iteration for both. The
+// knot count at which the partitioned solver becomes faster is a good value
+// for the parallel_solve_min_knots plan option. Usage:
+//
+//   spline_solver_benchmark [threads]
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <gsl/gsl_rng.h>
+
+#include "eemd.h"
+
+const unsigned int num_siftings = 10;
+const int repeats = 3;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+// Best time per sifting iteration for extracting the first IMF of inp
+static double time_sifting(double const* inp, size_t N, unsigned int threads,
+		size_t parallel_solve_min_knots, double* outp) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.parallel_sift_min_length = 1;
+	options.parallel_solve_min_knots = parallel_solve_min_knots;
+	emd_plan* plan = emd_plan_create_with_options(EMD_VARIANT_EEMD, N, 2, 1,
+			threads, &options);
+	if (plan == NULL) {
+		fprintf(stderr, "Creating a plan failed\n");
+		exit(1);
+	}
+	double best = INFINITY;
+	for (int r=0; r<repeats; r++) {
+		const double start = now();
+		libeemd_error_code err = emd_plan_execute(plan, inp, outp, 0.0, 0,
+				num_siftings, 0);
+		const double elapsed = now() - start;
+		if (err != EMD_SUCCESS) {
+			emd_report_if_error(err);
+			exit(1);
+		}
+		if (elapsed < best) {
+			best = elapsed;
+		}
+	}
+	emd_plan_destroy(plan);
+	return best/num_siftings;
+}
+
+int main(int argc, char** argv) {
+	unsigned int threads = (argc > 1)? (unsigned int)atoi(argv[1]) : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads < 2) {
+		threads = 2;
+	}
+	gsl_rng* r = gsl_rng_alloc(gsl_rng_mt19937);
+	printf("# %u threads\n", threads);
+	printf("#        N    knots   sequential [ms]   partitioned [ms]   speedup\n");
+	for (size_t N=1<<12; N<=(1<<24); N*=2) {
+		double* inp = malloc(N*sizeof(double));
+		double* outp = malloc(2*N*sizeof(double));
+		for (size_t i=0; i<N; i++) {
+			inp[i] = gsl_rng_uniform(r) - 0.5;
+		}
+		// The number of knots of the upper envelope in the first iteration
+		double* maxx = malloc((N/2+2)*sizeof(double));
+		double* maxy = malloc((N/2+2)*sizeof(double));
+		double* minx = malloc((N/2+2)*sizeof(double));
+		double* miny = malloc((N/2+2)*sizeof(double));
+		size_t num_max, num_min, num_zc;
+		emd_find_extrema(inp, N, maxx, maxy, &num_max, minx, miny, &num_min, &num_zc);
+		const double t_seq = time_sifting(inp, N, threads, 0, outp);
+		const double t_par = time_sifting(inp, N, threads, 1, outp);
+		printf("%10zu %8zu %17.3f %18.3f %9.2f\n", N, num_max, 1e3*t_seq,
+				1e3*t_par, t_seq/t_par);
+		free(miny); free(minx); free(maxy); free(maxx);
+		free(outp); free(inp);
+	}
+	gsl_rng_free(r);
+	return 0;
+}
@@ -16,19 +16,75 @@
  * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// Pinning threads to CPUs uses GNU extensions
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include "eemd.h"
 
-// If we are using OpenMP for parallel computation, we need locks to ensure
-// that the same output data is not written by several threads at the same
-// time.
-#ifdef _OPENMP
+// SIMD versions of some routines are selected at runtime based on the
+// instruction sets supported by the CPU. Define EEMD_SIMD=0 to always use the
+// plain C versions.
+#ifndef EEMD_SIMD
+#define EEMD_SIMD 1
+#endif
+#if EEMD_SIMD && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EEMD_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define EEMD_X86_SIMD 0
+#endif
+
+// Noise banks are loaded by mapping the file to memory where possible
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Plans can also use a pool of POSIX threads of their own instead of OpenMP.
+// The pool is built if pthreads are available, unless EEMD_THREAD_POOL is
+// defined as 0.
+#ifndef EEMD_THREAD_POOL
+#ifdef HAVE_PTHREAD_H
+#define EEMD_THREAD_POOL 1
+#else
+#define EEMD_THREAD_POOL 0
+#endif
+#endif
+#if EEMD_THREAD_POOL
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Threads of the pool can be pinned to CPUs, and memory placed on their NUMA
+// nodes, where the thread affinity can be set
+#if EEMD_THREAD_POOL && defined(HAVE_PTHREAD_ATTR_SETAFFINITY_NP)
+#define EEMD_NUMA 1
+#include <sched.h>
+#else
+#define EEMD_NUMA 0
+#endif
+
+// If we are using OpenMP or the thread pool for parallel computation, we need
+// locks to ensure that the same output data is not written by several threads
+// at the same time. With the pool the locks are pthread mutexes, which work
+// for both kinds of threads.
+#if EEMD_THREAD_POOL
+typedef pthread_mutex_t lock;
+inline static void init_lock(lock* l) { pthread_mutex_init(l, NULL); }
+inline static void destroy_lock(lock* l) { pthread_mutex_destroy(l); }
+inline static void get_lock(lock* l) { pthread_mutex_lock(l); }
+inline static void release_lock(lock* l) { pthread_mutex_unlock(l); }
+#elif defined(_OPENMP)
 typedef omp_lock_t lock;
 inline static void init_lock(lock* l) { omp_init_lock(l); }
 inline static void destroy_lock(lock* l) { omp_destroy_lock(l); }
 inline static void get_lock(lock* l) { omp_set_lock(l); }
 inline static void release_lock(lock* l) { omp_unset_lock(l); }
 #else
-// If we don't use OpenMP, we provide a dummy lock that does nothing. This
+// If we don't use threads, we provide a dummy lock that does nothing. This
 // avoids littering the code with too many #ifdefs for _OPENMP.
 typedef char lock;
 inline static void init_lock(__attribute__((unused)) lock* l) {}
@@ -68,6 +124,58 @@ inline static void array_mult(double* dest, size_t n, double val) {
 		dest[i] *= val;
 }
 
+// The layout of the IMFs of a signal in an output array: sample j of IMF m is
+// stored at output[m*imf_stride+j*sample_stride]. By default each IMF is a
+// contiguous row, i.e., imf_stride is N and sample_stride is one.
+typedef struct {
+	size_t imf_stride;
+	size_t sample_stride;
+} imf_layout;
+
+// Helper functions for working with the IMFs of a signal in any layout. The
+// values src[0..n-1] are added to or copied to samples j..j+n-1 of IMF m.
+inline static void imf_add(double const* src, size_t n, double* output,
+		imf_layout layout, size_t m, size_t j) {
+	double* const dest = output + m*layout.imf_stride + j*layout.sample_stride;
+	if (layout.sample_stride == 1) {
+		array_add(src, n, dest);
+		return;
+	}
+	for (size_t i=0; i<n; i++)
+		dest[i*layout.sample_stride] += src[i];
+}
+
+inline static void imf_copy(double const* src, size_t n, double* output,
+		imf_layout layout, size_t m, size_t j) {
+	double* const dest = output + m*layout.imf_stride + j*layout.sample_stride;
+	if (layout.sample_stride == 1) {
+		memcpy(dest, src, n*sizeof(double));
+		return;
+	}
+	for (size_t i=0; i<n; i++)
+		dest[i*layout.sample_stride] = src[i];
+}
+
+inline static void imfs_zero(double* output, size_t N, size_t M, imf_layout layout) {
+	if (layout.sample_stride == 1 && layout.imf_stride == N) {
+		memset(output, 0x00, M*N*sizeof(double));
+		return;
+	}
+	for (size_t m=0; m<M; m++)
+		for (size_t j=0; j<N; j++)
+			output[m*layout.imf_stride+j*layout.sample_stride] = 0;
+}
+
+inline static void imfs_mult(double* output, size_t N, size_t M, imf_layout layout, double val) {
+	if (layout.sample_stride == 1 && layout.imf_stride == N) {
+		array_mult(output, M*N, val);
+		return;
+	}
+	for (size_t m=0; m<M; m++)
+		for (size_t j=0; j<N; j++)
+			output[m*layout.imf_stride+j*layout.sample_stride] *= val;
+}
+
 // Helper function for extrapolating data at the ends. For a line passing
 // through (x0, y0), (x1, y1), and (x, y), return y for a given x.
 inline static double linear_extrapolate(double x0, double y0,
@@ -79,51 +187,187 @@ inline static double linear_extrapolate(double x0, double y0,
 // In the following part the necessary workspace memory structures for several
 // EMD operations are defined
 
+// Upper bound for the number of maxima (or minima) that emd_find_extrema
+// can find in data of length N. The interior extrema are detected at distinct
+// points 1..N-2 and maxima alternate with minima, so there are at most
+// (N-1)/2 interior maxima. The two end points are added to these.
+static inline size_t _max_num_extrema(size_t N) {
+	return N/2 + 2;
+}
+
+// The extrema are at integer points or, in the middle of a flat region, at
+// half-integer points. Inside sifting their positions, which are the knots
+// of the envelopes, are stored doubled as unsigned integers. Each plan picks
+// their width from its signal length: 32-bit integers, which take half the
+// memory of doubles, when the doubled positions fit in them, and 64-bit
+// integers otherwise, so that any signal that fits in memory can be
+// decomposed. Positions are computed as knot_pos and only narrowed when
+// stored. All positions and their differences are exact as doubles, so the
+// results are identical to computing with double positions.
+typedef uint64_t knot_pos;
+typedef int64_t knot_offset;
+
+// An array of positions, of 32-bit integers unless wide
+typedef struct {
+	void* p;
+	bool wide;
+} knot_array;
+
+// Whether a signal of length N needs 64-bit positions
+static inline bool _knots_wide(size_t N) {
+	return N > UINT32_MAX/2;
+}
+
+static inline size_t _knot_size(bool wide) {
+	return wide? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+static inline knot_pos _knot_get(knot_array a, size_t i) {
+	return a.wide? ((uint64_t const*)a.p)[i] : ((uint32_t const*)a.p)[i];
+}
+
+// A narrow array keeps the lowest 32 bits of v
+static inline void _knot_set(knot_array a, size_t i, knot_pos v) {
+	if (a.wide) {
+		((uint64_t*)a.p)[i] = v;
+	}
+	else {
+		((uint32_t*)a.p)[i] = (uint32_t)v;
+	}
+}
+
+// The part of a starting from position i
+static inline knot_array _knot_array_at(knot_array a, size_t i) {
+	knot_array b = {(char*)a.p + i*_knot_size(a.wide), a.wide};
+	return b;
+}
+
+// Largest N whose positions 0..N-1 fit in knot_pos when doubled
+#define EEMD_MAX_KNOT_N ((SIZE_MAX > UINT64_MAX/2)? (size_t)(UINT64_MAX/2) + 1 : SIZE_MAX)
+
+// Doubled position of the middle of a flat region of flat_counter steps
+// ending at point i
+static inline knot_pos _knot(size_t i, int flat_counter) {
+	return 2*(knot_pos)i - (knot_pos)flat_counter;
+}
+
+static inline double _knot_x(knot_pos p) {
+	return 0.5*(double)p;
+}
+
+// Distance between knots i and i+1
+static inline double _knot_h(knot_array p, size_t i) {
+	return 0.5*(double)(_knot_get(p, i+1)-_knot_get(p, i));
+}
+
+// All memory of a plan is carved from a single block. An arena hands out
+// consecutive pieces of the block, each aligned to EMD_WORKSPACE_ALIGNMENT
+// bytes from its start. An arena without a block only counts the bytes it
+// would hand out, so that the same code first measures the block and then
+// carves it. Such an arena returns NULL for every piece, and the functions
+// carving structures from it must not write anything then.
+typedef struct {
+	char* base;
+	size_t used;
+} arena;
+
+static inline void _arena_align(arena* a, size_t alignment) {
+	a->used = (a->used + alignment - 1)/alignment*alignment;
+}
+
+static inline void* _arena_alloc(arena* a, size_t size) {
+	_arena_align(a, EMD_WORKSPACE_ALIGNMENT);
+	void* p = (a->base != NULL)? a->base + a->used : NULL;
+	a->used += size;
+	return p;
+}
+
+// The linear systems for the spline coefficients of both envelopes are
+// solved together in a batch. The batch and its functions are defined with
+// the rest of the spline code.
+typedef struct spline_batch spline_batch;
+static spline_batch* _carve_spline_batch(arena* a, size_t capacity, size_t max_size);
+
 // For sifting we need arrays for storing the found extrema of the signal, and memory required
-// to form the spline envelopes
+// to form the spline envelopes. The envelopes themselves are never stored:
+// they are evaluated and subtracted from the signal on the fly, and at the
+// same time the extrema for the next iteration are found. That is why there
+// are two sets of arrays for the extrema.
 typedef struct {
 	// Number of samples in the signal
 	size_t N;
-	// Found extrema
-	double* restrict maxx;
+	// Found extrema, with positions doubled
+	knot_array maxx;
 	double* restrict maxy;
-	double* restrict minx;
+	knot_array minx;
 	double* restrict miny;
-	// Upper and lower envelope spline values
-	double* restrict maxspline;
-	double* restrict minspline;
-	// Extra memory required for spline evaluation
+	// Extrema found for the next iteration
+	knot_array next_maxx;
+	double* restrict next_maxy;
+	knot_array next_minx;
+	double* restrict next_miny;
+	// Extra memory required for spline evaluation. The upper envelope is
+	// computed at the start and the lower envelope at the end of it.
 	double* restrict spline_workspace;
+	size_t spline_workspace_size;
+	// Batch for solving the systems of the upper and lower envelopes
+	spline_batch* envelope_batch;
+	// The factorizations of the linear systems for the spline coefficients of
+	// the upper and lower envelopes are kept in the spline workspace. If the
+	// knots of an envelope are the same as in the previous iteration, which
+	// are then in next_maxx or next_minx, the factorization is reused. These
+	// are the numbers of knots of the factorizations, or zero if there is
+	// none.
+	size_t factored_num_max;
+	size_t factored_num_min;
+	// Statistics: the number of cubic envelopes computed and the number of
+	// those that reused the factorization, separately for the upper (0) and
+	// lower (1) envelopes
+	unsigned long long num_envelopes[2];
+	unsigned long long num_reused[2];
 } sifting_workspace;
 
-sifting_workspace* allocate_sifting_workspace(size_t N) {
-	sifting_workspace* w = malloc(sizeof(sifting_workspace));
+static sifting_workspace* _carve_sifting_workspace(arena* a, size_t N) {
+	sifting_workspace* w = _arena_alloc(a, sizeof(sifting_workspace));
+	const size_t max_extrema = _max_num_extrema(N);
+	const bool wide = _knots_wide(N);
+	knot_array positions[4];
+	double* values[4];
+	for (int k=0; k<4; k++) {
+		positions[k].p = _arena_alloc(a, max_extrema*_knot_size(wide));
+		positions[k].wide = wide;
+		values[k] = _arena_alloc(a, max_extrema*sizeof(double));
+	}
+	// An envelope through m extrema requires at most 6*m doubles, and both
+	// envelopes are needed at the same time. There are at most N+2 maxima and
+	// minima in total.
+	const size_t spline_workspace_size = 6*N+12;
+	double* spline_workspace = _arena_alloc(a, spline_workspace_size*sizeof(double));
+	spline_batch* envelope_batch = _carve_spline_batch(a, 2, max_extrema-2);
+	if (w == NULL) {
+		return NULL;
+	}
 	w->N = N;
-	w->maxx = malloc(N*sizeof(double));
-	w->maxy = malloc(N*sizeof(double));
-	w->minx = malloc(N*sizeof(double));
-	w->miny = malloc(N*sizeof(double));
-	w->maxspline = malloc(N*sizeof(double));
-	w->minspline = malloc(N*sizeof(double));
-	// Spline evaluation requires 5*m-10 doubles where m is the number of
-	// extrema. The worst case scenario is that every point is an extrema, so
-	// use m=N to be safe.
-	const size_t spline_workspace_size = (N > 2)? 5*N-10 : 0;
-	w->spline_workspace = malloc(spline_workspace_size*sizeof(double));
+	w->maxx = positions[0];
+	w->maxy = values[0];
+	w->minx = positions[1];
+	w->miny = values[1];
+	w->next_maxx = positions[2];
+	w->next_maxy = values[2];
+	w->next_minx = positions[3];
+	w->next_miny = values[3];
+	w->spline_workspace_size = spline_workspace_size;
+	w->spline_workspace = spline_workspace;
+	w->envelope_batch = envelope_batch;
+	w->factored_num_max = 0;
+	w->factored_num_min = 0;
+	for (int k=0; k<2; k++) {
+		w->num_envelopes[k] = 0;
+		w->num_reused[k] = 0;
+	}
 	return w;
 }
 
-void free_sifting_workspace(sifting_workspace* w) {
-	free(w->spline_workspace); w->spline_workspace = NULL;
-	free(w->minspline); w->minspline = NULL;
-	free(w->maxspline); w->maxspline = NULL;
-	free(w->miny); w->miny = NULL;
-	free(w->minx); w->minx = NULL;
-	free(w->maxy); w->maxy = NULL;
-	free(w->maxx); w->maxx = NULL;
-	free(w); w = NULL;
-}
-
 
 // For EMD we need space to do the sifting and somewhere to save the residual from the previous run.
 // We also leave room for an array of locks to protect multi-threaded EMD.
@@ -133,33 +377,33 @@ typedef struct {
 	double* restrict res;
 	// What is needed for sifting
 	sifting_workspace* restrict sift_w;
-	// A pointer for shared locks. These locks are used to make EMD thread-safe
-	// even when several threads run EMD with the same output matrix (we'll do
-	// this in EEMD).
-	lock** locks;
+	// A pointer for shared locks, one for each IMF. These locks are used to
+	// make EMD thread-safe even when several threads run EMD with the same
+	// output matrix (we'll do this in EEMD). If the output matrix is private
+	// to the thread, this is NULL and no locking is done.
+	lock* locks;
 } emd_workspace;
 
-emd_workspace* allocate_emd_workspace(size_t N) {
-	emd_workspace* w = malloc(sizeof(emd_workspace));
+static emd_workspace* _carve_emd_workspace(arena* a, size_t N) {
+	emd_workspace* w = _arena_alloc(a, sizeof(emd_workspace));
+	double* res = _arena_alloc(a, N*sizeof(double));
+	sifting_workspace* sift_w = _carve_sifting_workspace(a, N);
+	if (w == NULL) {
+		return NULL;
+	}
 	w->N = N;
-	w->res = malloc(N*sizeof(double));
-	w->sift_w = allocate_sifting_workspace(N);
+	w->res = res;
+	w->sift_w = sift_w;
 	w->locks = NULL; // The locks are assumed to be allocated and freed independently
 	return w;
 }
 
-void free_emd_workspace(emd_workspace* w) {
-	free_sifting_workspace(w->sift_w);
-	free(w->res); w->res = NULL;
-	free(w); w = NULL;
-}
-
 
 // EEMD needs a random number generator in addition to emd_workspace. We also need a place to store
 // the member of the ensemble (input signal + realization of noise) to be worked on.
 typedef struct {
 	size_t N;
-	// The random number generator
+	// The random number generator, only allocated for EMD_RNG_MT19937
 	gsl_rng* r;
 	// The ensemble member signal
 	double* restrict x;
@@ -167,12 +411,42 @@ typedef struct {
 	emd_workspace* restrict emd_w;
 } eemd_workspace;
 
-eemd_workspace* allocate_eemd_workspace(size_t N) {
-	eemd_workspace* w = malloc(sizeof(eemd_workspace));
+// The random number generator is not carved from the arena but allocated by
+// GSL, so r is left NULL
+static eemd_workspace* _carve_eemd_workspace(arena* a, size_t N) {
+	eemd_workspace* w = _arena_alloc(a, sizeof(eemd_workspace));
+	double* x = _arena_alloc(a, N*sizeof(double));
+	emd_workspace* emd_w = _carve_emd_workspace(a, N);
+	if (w == NULL) {
+		return NULL;
+	}
 	w->N = N;
-	w->r = gsl_rng_alloc(gsl_rng_mt19937);
-	w->x = malloc(N*sizeof(double));
-	w->emd_w = allocate_emd_workspace(N);
+	w->r = NULL;
+	w->x = x;
+	w->emd_w = emd_w;
+	return w;
+}
+
+// A workspace of its own, outside of any plan, is carved from a block
+// starting with the workspace itself. The random number generator is only
+// allocated for EMD_RNG_MT19937, since Philox keeps no state. Returns NULL if
+// memory allocation fails.
+eemd_workspace* allocate_eemd_workspace(size_t N, emd_rng_type rng) {
+	arena a = {NULL, 0};
+	_carve_eemd_workspace(&a, N);
+	a.base = malloc(a.used);
+	if (a.base == NULL) {
+		return NULL;
+	}
+	a.used = 0;
+	eemd_workspace* w = _carve_eemd_workspace(&a, N);
+	if (rng == EMD_RNG_MT19937) {
+		w->r = gsl_rng_alloc(gsl_rng_mt19937);
+		if (w->r == NULL) {
+			free(w);
+			return NULL;
+		}
+	}
 	return w;
 }
 
@@ -181,16 +455,441 @@ void set_rng_seed(eemd_workspace* w, unsigned long int rng_seed) {
 }
 
 void free_eemd_workspace(eemd_workspace* w) {
-	free_emd_workspace(w->emd_w);
-	free(w->x); w->x = NULL;
-	gsl_rng_free(w->r); w->r = NULL;
+	if (w->r != NULL) {
+		gsl_rng_free(w->r); w->r = NULL;
+	}
 	free(w); w = NULL;
 }
 
+// The counter-based random number generator Philox4x32-10 as described in:
+//   J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw,
+//   Parallel Random Numbers: As Easy as 1, 2, 3,
+//   Proc. Int. Conf. for High Performance Computing, Networking, Storage and
+//   Analysis (SC11), 2011
+//
+// The 128-bit counter ctr is replaced by the corresponding random output.
+static inline void _philox4x32_10(uint32_t ctr[4], uint32_t key0, uint32_t key1) {
+	for (int round=0; round<10; round++) {
+		const uint64_t p0 = (uint64_t)0xD2511F53u*ctr[0];
+		const uint64_t p1 = (uint64_t)0xCD9E8D57u*ctr[2];
+		const uint32_t c1 = ctr[1];
+		const uint32_t c3 = ctr[3];
+		ctr[0] = (uint32_t)(p1 >> 32) ^ c1 ^ key0;
+		ctr[1] = (uint32_t)p1;
+		ctr[2] = (uint32_t)(p0 >> 32) ^ c3 ^ key1;
+		ctr[3] = (uint32_t)p0;
+		key0 += 0x9E3779B9u;
+		key1 += 0xBB67AE85u;
+	}
+}
+
+// Gaussian white noise is generated from the Philox output in blocks of 16
+// samples. Counter j = 8*b+l (0 <= l < 8) gives samples 16*b+l and 16*b+8+l
+// of block b, so that SIMD versions can process 4 or 8 consecutive counters
+// at a time and store the results contiguously. Each Philox output gives two
+// 52-bit uniform random numbers, which are transformed with the Box-Muller
+// method. Unlike the polar method used by GSL, there is no rejection, so that
+// any block can be generated directly from its index.
+//
+// The logarithm, sine and cosine are computed with the polynomial
+// approximations of fdlibm instead of calling the C library, so that the
+// scalar and SIMD versions give exactly the same results. For the same reason
+// the compiler must not fuse multiplications and additions in these
+// routines, which it would otherwise do when FMA (included in AVX-512) is
+// available.
+#if defined(__GNUC__) && !defined(__clang__)
+#define _NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define _NO_FP_CONTRACT
+#endif
+#define _LN2_HI 6.93147180369123816490e-01
+#define _LN2_LO 1.90821492927058770002e-10
+#define _LG1 6.666666666666735130e-01
+#define _LG2 3.999999999940941908e-01
+#define _LG3 2.857142874366239149e-01
+#define _LG4 2.222219843214978396e-01
+#define _LG5 1.818357216161805012e-01
+#define _LG6 1.531383769920937332e-01
+#define _LG7 1.479819860511658591e-01
+#define _S1 -1.66666666666666324348e-01
+#define _S2 8.33333333332248946124e-03
+#define _S3 -1.98412698298579493134e-04
+#define _S4 2.75573137070700676789e-06
+#define _S5 -2.50507602534068634195e-08
+#define _S6 1.58969099521155010221e-10
+#define _C1 4.16666666666666019037e-02
+#define _C2 -1.38888888888741095749e-03
+#define _C3 2.48015872894767294178e-05
+#define _C4 -2.75573143513906633035e-07
+#define _C5 2.08757232129817482790e-09
+#define _C6 -1.13596475577881948265e-11
+#define _TWO_PI 6.28318530717958647693
+// Bit patterns used for converting integers to doubles and back
+#define _ONE_BITS UINT64_C(0x3ff0000000000000)
+#define _TWO_POW_52_BITS UINT64_C(0x4330000000000000)
+#define _TWO_POW_52 4503599627370496.0
+#define _ROUND_MAGIC 6755399441055744.0
+// log(x) is computed as k*log(2)+log(z) with z in [sqrt(2)/2, sqrt(2))
+#define _LOG_OFFSET (_ONE_BITS - UINT64_C(0x3fe6a09e667f3bcd))
+
+static inline double _bits_to_double(uint64_t b) {
+	double d;
+	memcpy(&d, &b, sizeof(double));
+	return d;
+}
+
+static inline uint64_t _double_to_bits(double d) {
+	uint64_t b;
+	memcpy(&b, &d, sizeof(double));
+	return b;
+}
+
+// Natural logarithm of a positive normal number x
+_NO_FP_CONTRACT
+static inline double _noise_log(double x) {
+	const uint64_t ix = _double_to_bits(x);
+	const uint64_t biased_k = (ix + _LOG_OFFSET) >> 52;
+	const double k = (_bits_to_double(biased_k | _TWO_POW_52_BITS) - _TWO_POW_52) - 1023.0;
+	const double f = _bits_to_double(ix - (biased_k << 52) + _ONE_BITS) - 1.0;
+	const double s = f/(2.0+f);
+	const double z = s*s;
+	const double w = z*z;
+	const double t1 = w*(_LG2+w*(_LG4+w*_LG6));
+	const double t2 = z*(_LG1+w*(_LG3+w*(_LG5+w*_LG7)));
+	const double R = t2+t1;
+	const double hfsq = 0.5*f*f;
+	return k*_LN2_HI - ((hfsq - (s*(hfsq+R) + k*_LN2_LO)) - f);
+}
+
+// Cosine and sine of 2*pi*u for u in [0, 1). The angle is reduced exactly to
+// 2*pi*t + q*pi/2 with |t| <= 1/8.
+_NO_FP_CONTRACT
+static inline void _noise_sincos(double u, double* restrict c, double* restrict s) {
+	const double q = (4.0*u + _ROUND_MAGIC) - _ROUND_MAGIC;
+	const double a = (u - 0.25*q)*_TWO_PI;
+	const double z = a*a;
+	const double sin_a = a + z*a*(_S1 + z*(_S2+z*(_S3+z*(_S4+z*(_S5+z*_S6)))));
+	const double r = z*(_C1+z*(_C2+z*(_C3+z*(_C4+z*(_C5+z*_C6)))));
+	const double hz = 0.5*z;
+	const double w = 1.0-hz;
+	const double cos_a = w + (((1.0-w)-hz) + z*r);
+	const bool swap = (q == 1.0 || q == 3.0);
+	*c = swap? sin_a : cos_a;
+	*s = swap? cos_a : sin_a;
+	if (q == 1.0 || q == 2.0) {
+		*c = -*c;
+	}
+	if (q == 2.0 || q == 3.0) {
+		*s = -*s;
+	}
+}
+
+// Block b of Gaussian white noise (zero mean, unit variance) for the ensemble
+// member with the given stream number
+_NO_FP_CONTRACT
+static void _philox_gaussian_block(uint64_t stream, uint64_t b, double z[16]) {
+	for (unsigned int l=0; l<8; l++) {
+		const uint64_t j = 8*b+l;
+		uint32_t ctr[4] = {(uint32_t)j, (uint32_t)(j >> 32), 0, 0};
+		_philox4x32_10(ctr, (uint32_t)stream, (uint32_t)(stream >> 32));
+		// u1 is in (0, 1] so that the logarithm is finite, u2 is in [0, 1)
+		const double u1 = 2.0 - _bits_to_double(((uint64_t)ctr[0] << 20 | ctr[1] >> 12) | _ONE_BITS);
+		const double u2 = _bits_to_double(((uint64_t)ctr[2] << 20 | ctr[3] >> 12) | _ONE_BITS) - 1.0;
+		const double r = sqrt(-2.0*_noise_log(u1));
+		double c, s;
+		_noise_sincos(u2, &c, &s);
+		z[l] = r*c;
+		z[l+8] = r*s;
+	}
+}
+
+// Store base+sigma*noise (or just sigma*noise if base is NULL) to out for
+// samples i_start <= i < N, where i_start is a multiple of 16
+_NO_FP_CONTRACT
+static void _philox_gaussian_fill_scalar(uint64_t stream, double sigma,
+		double const* restrict base, double* restrict out, size_t i_start, size_t N) {
+	for (size_t i=i_start; i<N; i+=16) {
+		double z[16];
+		_philox_gaussian_block(stream, i/16, z);
+		const size_t n = (N-i < 16)? N-i : 16;
+		for (size_t k=0; k<n; k++) {
+			out[i+k] = (base != NULL)? base[i+k] + sigma*z[k] : sigma*z[k];
+		}
+	}
+}
+
+#if EEMD_X86_SIMD
+// SIMD versions of _philox_gaussian_block, which directly store
+// base+sigma*noise (or just sigma*noise if base is NULL) to out for all
+// complete blocks. They return the number of samples generated. The 32-bit
+// Philox words are kept in 64-bit lanes so that _mm*_mul_epu32 gives the full
+// products.
+__attribute__((target("avx2"))) _NO_FP_CONTRACT
+static size_t _philox_gaussian_fill_avx2(uint64_t stream, double sigma,
+		double const* restrict base, double* restrict out, size_t N) {
+	const __m256i mask32 = _mm256_set1_epi64x(0xffffffff);
+	const __m256i one_bits = _mm256_set1_epi64x((long long)_ONE_BITS);
+	const __m256i sign_bit = _mm256_set1_epi64x((long long)UINT64_C(0x8000000000000000));
+	const __m256i log_offset = _mm256_set1_epi64x((long long)_LOG_OFFSET);
+	const __m256i two_pow_52_bits = _mm256_set1_epi64x((long long)_TWO_POW_52_BITS);
+	const __m256d two_pow_52 = _mm256_set1_pd(_TWO_POW_52);
+	const __m256d round_magic = _mm256_set1_pd(_ROUND_MAGIC);
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d two = _mm256_set1_pd(2.0);
+	const __m256d half = _mm256_set1_pd(0.5);
+	const __m256d sigma_v = _mm256_set1_pd(sigma);
+	#define SET(x) _mm256_set1_pd(x)
+	#define ADD(x, y) _mm256_add_pd(x, y)
+	#define SUB(x, y) _mm256_sub_pd(x, y)
+	#define MUL(x, y) _mm256_mul_pd(x, y)
+	const size_t num_blocks = N/16;
+	for (size_t b=0; b<num_blocks; b++) {
+		for (unsigned int half_block=0; half_block<2; half_block++) {
+			const uint64_t j = 8*b+4*half_block;
+			__m256i c0 = _mm256_and_si256(_mm256_add_epi64(_mm256_set1_epi64x((long long)j),
+						_mm256_set_epi64x(3, 2, 1, 0)), mask32);
+			__m256i c1 = _mm256_set1_epi64x((long long)(j >> 32));
+			// The high word of j+l may differ from that of j only if the low
+			// word wraps around, which cannot happen since j is a multiple of 4
+			__m256i c2 = _mm256_setzero_si256();
+			__m256i c3 = _mm256_setzero_si256();
+			uint32_t key0 = (uint32_t)stream;
+			uint32_t key1 = (uint32_t)(stream >> 32);
+			for (int round=0; round<10; round++) {
+				const __m256i p0 = _mm256_mul_epu32(c0, _mm256_set1_epi64x(0xD2511F53));
+				const __m256i p1 = _mm256_mul_epu32(c2, _mm256_set1_epi64x(0xCD9E8D57));
+				c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1),
+						_mm256_set1_epi64x(key0));
+				c1 = _mm256_and_si256(p1, mask32);
+				c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3),
+						_mm256_set1_epi64x(key1));
+				c3 = _mm256_and_si256(p0, mask32);
+				key0 += 0x9E3779B9u;
+				key1 += 0xBB67AE85u;
+			}
+			const __m256d u1 = SUB(two, _mm256_castsi256_pd(_mm256_or_si256(_mm256_or_si256(
+								_mm256_slli_epi64(c0, 20), _mm256_srli_epi64(c1, 12)), one_bits)));
+			const __m256d u2 = SUB(_mm256_castsi256_pd(_mm256_or_si256(_mm256_or_si256(
+								_mm256_slli_epi64(c2, 20), _mm256_srli_epi64(c3, 12)), one_bits)), one);
+			// Logarithm, as in _noise_log
+			const __m256i ix = _mm256_castpd_si256(u1);
+			const __m256i biased_k = _mm256_srli_epi64(_mm256_add_epi64(ix, log_offset), 52);
+			const __m256d k = SUB(SUB(_mm256_castsi256_pd(_mm256_or_si256(biased_k, two_pow_52_bits)),
+						two_pow_52), SET(1023.0));
+			const __m256d f = SUB(_mm256_castsi256_pd(_mm256_add_epi64(_mm256_sub_epi64(ix,
+								_mm256_slli_epi64(biased_k, 52)), one_bits)), one);
+			const __m256d s = _mm256_div_pd(f, ADD(two, f));
+			__m256d z = MUL(s, s);
+			__m256d w = MUL(z, z);
+			__m256d t1 = SET(_LG6);
+			t1 = ADD(SET(_LG4), MUL(w, t1));
+			t1 = MUL(w, ADD(SET(_LG2), MUL(w, t1)));
+			__m256d t2 = SET(_LG7);
+			t2 = ADD(SET(_LG5), MUL(w, t2));
+			t2 = ADD(SET(_LG3), MUL(w, t2));
+			t2 = MUL(z, ADD(SET(_LG1), MUL(w, t2)));
+			const __m256d R = ADD(t2, t1);
+			const __m256d hfsq = MUL(MUL(half, f), f);
+			const __m256d log_u1 = SUB(MUL(k, SET(_LN2_HI)), SUB(SUB(hfsq, ADD(MUL(s, ADD(hfsq, R)),
+								MUL(k, SET(_LN2_LO)))), f));
+			const __m256d r = _mm256_sqrt_pd(MUL(SET(-2.0), log_u1));
+			// Sine and cosine, as in _noise_sincos
+			const __m256d q = SUB(ADD(MUL(SET(4.0), u2), round_magic), round_magic);
+			const __m256d a = MUL(SUB(u2, MUL(SET(0.25), q)), SET(_TWO_PI));
+			z = MUL(a, a);
+			__m256d ps = SET(_S6);
+			ps = ADD(SET(_S5), MUL(z, ps));
+			ps = ADD(SET(_S4), MUL(z, ps));
+			ps = ADD(SET(_S3), MUL(z, ps));
+			ps = ADD(SET(_S2), MUL(z, ps));
+			const __m256d sin_a = ADD(a, MUL(MUL(z, a), ADD(SET(_S1), MUL(z, ps))));
+			__m256d rc = SET(_C6);
+			rc = ADD(SET(_C5), MUL(z, rc));
+			rc = ADD(SET(_C4), MUL(z, rc));
+			rc = ADD(SET(_C3), MUL(z, rc));
+			rc = ADD(SET(_C2), MUL(z, rc));
+			rc = MUL(z, ADD(SET(_C1), MUL(z, rc)));
+			const __m256d hz = MUL(half, z);
+			w = SUB(one, hz);
+			const __m256d cos_a = ADD(w, ADD(SUB(SUB(one, w), hz), MUL(z, rc)));
+			const __m256d q1 = _mm256_cmp_pd(q, one, _CMP_EQ_OQ);
+			const __m256d q2 = _mm256_cmp_pd(q, two, _CMP_EQ_OQ);
+			const __m256d q3 = _mm256_cmp_pd(q, SET(3.0), _CMP_EQ_OQ);
+			const __m256d swap = _mm256_or_pd(q1, q3);
+			__m256d c = _mm256_blendv_pd(cos_a, sin_a, swap);
+			__m256d sn = _mm256_blendv_pd(sin_a, cos_a, swap);
+			c = _mm256_xor_pd(c, _mm256_and_pd(_mm256_or_pd(q1, q2), _mm256_castsi256_pd(sign_bit)));
+			sn = _mm256_xor_pd(sn, _mm256_and_pd(_mm256_or_pd(q2, q3), _mm256_castsi256_pd(sign_bit)));
+			__m256d z0 = MUL(sigma_v, MUL(r, c));
+			__m256d z1 = MUL(sigma_v, MUL(r, sn));
+			const size_t i0 = 16*b+4*half_block;
+			if (base != NULL) {
+				z0 = ADD(_mm256_loadu_pd(base+i0), z0);
+				z1 = ADD(_mm256_loadu_pd(base+i0+8), z1);
+			}
+			_mm256_storeu_pd(out+i0, z0);
+			_mm256_storeu_pd(out+i0+8, z1);
+		}
+	}
+	#undef SET
+	#undef ADD
+	#undef SUB
+	#undef MUL
+	return 16*num_blocks;
+}
+
+__attribute__((target("avx512f"))) _NO_FP_CONTRACT
+static size_t _philox_gaussian_fill_avx512(uint64_t stream, double sigma,
+		double const* restrict base, double* restrict out, size_t N) {
+	const __m512i mask32 = _mm512_set1_epi64(0xffffffff);
+	const __m512i one_bits = _mm512_set1_epi64((long long)_ONE_BITS);
+	const __m512i sign_bit = _mm512_set1_epi64((long long)UINT64_C(0x8000000000000000));
+	const __m512i log_offset = _mm512_set1_epi64((long long)_LOG_OFFSET);
+	const __m512i two_pow_52_bits = _mm512_set1_epi64((long long)_TWO_POW_52_BITS);
+	const __m512d two_pow_52 = _mm512_set1_pd(_TWO_POW_52);
+	const __m512d round_magic = _mm512_set1_pd(_ROUND_MAGIC);
+	const __m512d one = _mm512_set1_pd(1.0);
+	const __m512d two = _mm512_set1_pd(2.0);
+	const __m512d half = _mm512_set1_pd(0.5);
+	const __m512d sigma_v = _mm512_set1_pd(sigma);
+	#define SET(x) _mm512_set1_pd(x)
+	#define ADD(x, y) _mm512_add_pd(x, y)
+	#define SUB(x, y) _mm512_sub_pd(x, y)
+	#define MUL(x, y) _mm512_mul_pd(x, y)
+	#define NEG_IF(x, m) _mm512_castsi512_pd(_mm512_mask_xor_epi64(_mm512_castpd_si512(x), \
+				m, _mm512_castpd_si512(x), sign_bit))
+	const size_t num_blocks = N/16;
+	for (size_t b=0; b<num_blocks; b++) {
+		const uint64_t j = 8*b;
+		__m512i c0 = _mm512_and_si512(_mm512_add_epi64(_mm512_set1_epi64((long long)j),
+					_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0)), mask32);
+		// The high word of j+l may differ from that of j only if the low word
+		// wraps around, which cannot happen since j is a multiple of 8
+		__m512i c1 = _mm512_set1_epi64((long long)(j >> 32));
+		__m512i c2 = _mm512_setzero_si512();
+		__m512i c3 = _mm512_setzero_si512();
+		uint32_t key0 = (uint32_t)stream;
+		uint32_t key1 = (uint32_t)(stream >> 32);
+		for (int round=0; round<10; round++) {
+			const __m512i p0 = _mm512_mul_epu32(c0, _mm512_set1_epi64(0xD2511F53));
+			const __m512i p1 = _mm512_mul_epu32(c2, _mm512_set1_epi64(0xCD9E8D57));
+			c0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c1),
+					_mm512_set1_epi64(key0));
+			c1 = _mm512_and_si512(p1, mask32);
+			c2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c3),
+					_mm512_set1_epi64(key1));
+			c3 = _mm512_and_si512(p0, mask32);
+			key0 += 0x9E3779B9u;
+			key1 += 0xBB67AE85u;
+		}
+		const __m512d u1 = SUB(two, _mm512_castsi512_pd(_mm512_or_si512(_mm512_or_si512(
+							_mm512_slli_epi64(c0, 20), _mm512_srli_epi64(c1, 12)), one_bits)));
+		const __m512d u2 = SUB(_mm512_castsi512_pd(_mm512_or_si512(_mm512_or_si512(
+							_mm512_slli_epi64(c2, 20), _mm512_srli_epi64(c3, 12)), one_bits)), one);
+		// Logarithm, as in _noise_log
+		const __m512i ix = _mm512_castpd_si512(u1);
+		const __m512i biased_k = _mm512_srli_epi64(_mm512_add_epi64(ix, log_offset), 52);
+		const __m512d k = SUB(SUB(_mm512_castsi512_pd(_mm512_or_si512(biased_k, two_pow_52_bits)),
+					two_pow_52), SET(1023.0));
+		const __m512d f = SUB(_mm512_castsi512_pd(_mm512_add_epi64(_mm512_sub_epi64(ix,
+							_mm512_slli_epi64(biased_k, 52)), one_bits)), one);
+		const __m512d s = _mm512_div_pd(f, ADD(two, f));
+		__m512d z = MUL(s, s);
+		__m512d w = MUL(z, z);
+		__m512d t1 = SET(_LG6);
+		t1 = ADD(SET(_LG4), MUL(w, t1));
+		t1 = MUL(w, ADD(SET(_LG2), MUL(w, t1)));
+		__m512d t2 = SET(_LG7);
+		t2 = ADD(SET(_LG5), MUL(w, t2));
+		t2 = ADD(SET(_LG3), MUL(w, t2));
+		t2 = MUL(z, ADD(SET(_LG1), MUL(w, t2)));
+		const __m512d R = ADD(t2, t1);
+		const __m512d hfsq = MUL(MUL(half, f), f);
+		const __m512d log_u1 = SUB(MUL(k, SET(_LN2_HI)), SUB(SUB(hfsq, ADD(MUL(s, ADD(hfsq, R)),
+							MUL(k, SET(_LN2_LO)))), f));
+		const __m512d r = _mm512_sqrt_pd(MUL(SET(-2.0), log_u1));
+		// Sine and cosine, as in _noise_sincos
+		const __m512d q = SUB(ADD(MUL(SET(4.0), u2), round_magic), round_magic);
+		const __m512d a = MUL(SUB(u2, MUL(SET(0.25), q)), SET(_TWO_PI));
+		z = MUL(a, a);
+		__m512d ps = SET(_S6);
+		ps = ADD(SET(_S5), MUL(z, ps));
+		ps = ADD(SET(_S4), MUL(z, ps));
+		ps = ADD(SET(_S3), MUL(z, ps));
+		ps = ADD(SET(_S2), MUL(z, ps));
+		const __m512d sin_a = ADD(a, MUL(MUL(z, a), ADD(SET(_S1), MUL(z, ps))));
+		__m512d rc = SET(_C6);
+		rc = ADD(SET(_C5), MUL(z, rc));
+		rc = ADD(SET(_C4), MUL(z, rc));
+		rc = ADD(SET(_C3), MUL(z, rc));
+		rc = ADD(SET(_C2), MUL(z, rc));
+		rc = MUL(z, ADD(SET(_C1), MUL(z, rc)));
+		const __m512d hz = MUL(half, z);
+		w = SUB(one, hz);
+		const __m512d cos_a = ADD(w, ADD(SUB(SUB(one, w), hz), MUL(z, rc)));
+		const __mmask8 q1 = _mm512_cmp_pd_mask(q, one, _CMP_EQ_OQ);
+		const __mmask8 q2 = _mm512_cmp_pd_mask(q, two, _CMP_EQ_OQ);
+		const __mmask8 q3 = _mm512_cmp_pd_mask(q, SET(3.0), _CMP_EQ_OQ);
+		const __mmask8 swap = q1 | q3;
+		__m512d c = _mm512_mask_blend_pd(swap, cos_a, sin_a);
+		__m512d sn = _mm512_mask_blend_pd(swap, sin_a, cos_a);
+		c = NEG_IF(c, q1 | q2);
+		sn = NEG_IF(sn, q2 | q3);
+		__m512d z0 = MUL(sigma_v, MUL(r, c));
+		__m512d z1 = MUL(sigma_v, MUL(r, sn));
+		const size_t i0 = 16*b;
+		if (base != NULL) {
+			z0 = ADD(_mm512_loadu_pd(base+i0), z0);
+			z1 = ADD(_mm512_loadu_pd(base+i0+8), z1);
+		}
+		_mm512_storeu_pd(out+i0, z0);
+		_mm512_storeu_pd(out+i0+8, z1);
+	}
+	#undef SET
+	#undef ADD
+	#undef SUB
+	#undef MUL
+	#undef NEG_IF
+	return 16*num_blocks;
+}
+#endif
+
+// Generate N samples of Gaussian white noise with standard deviation sigma for
+// the ensemble member with the given stream number. If base is not NULL, the
+// noise is added to base. The result is stored to out.
+static void _generate_noise(eemd_workspace* restrict w, emd_rng_type rng,
+		unsigned long int stream, double sigma, double const* restrict base,
+		double* restrict out, size_t N) {
+	if (rng == EMD_RNG_MT19937) {
+		set_rng_seed(w, stream);
+		if (base != NULL) {
+			for (size_t i=0; i<N; i++) {
+				out[i] = base[i] + gsl_ran_gaussian(w->r, sigma);
+			}
+		}
+		else {
+			for (size_t i=0; i<N; i++) {
+				out[i] = gsl_ran_gaussian(w->r, sigma);
+			}
+		}
+		return;
+	}
+	size_t done = 0;
+	#if EEMD_X86_SIMD
+	if (__builtin_cpu_supports("avx512f")) {
+		done = _philox_gaussian_fill_avx512(stream, sigma, base, out, N);
+	}
+	else if (__builtin_cpu_supports("avx2")) {
+		done = _philox_gaussian_fill_avx2(stream, sigma, base, out, N);
+	}
+	#endif
+	_philox_gaussian_fill_scalar(stream, sigma, base, out, done, N);
+}
+
 // Forward declaration of a helper function used internally for making a single
 // EMD run with a preallocated workspace
 static libeemd_error_code _emd(double* restrict input, emd_workspace* restrict w,
-		double* restrict output, size_t M,
+		double* restrict output, imf_layout layout, size_t M,
 		unsigned int S_number, unsigned int num_siftings);
 
 // Forward declaration of a helper function for applying the sifting procedure to
@@ -200,662 +899,5406 @@ static libeemd_error_code _sift(double* restrict input, sifting_workspace*
 		restrict w, unsigned int S_number, unsigned int num_siftings, unsigned int*
 		sift_counter);
 
-// Forward declaration of a helper function for parameter validation shared by functions eemd and ceemdan
-static inline libeemd_error_code _validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings);
+// Forward declarations of the same for single-precision data. The IMFs are
+// added to a sum matrix of floats or doubles.
+static libeemd_error_code _emd_float(float* restrict input, float* restrict res,
+		sifting_workspace* restrict w, emd_precision sum_precision,
+		void* restrict sum, size_t M, unsigned int S_number,
+		unsigned int num_siftings);
+static libeemd_error_code _sift_float(float* restrict input, sifting_workspace*
+		restrict w, unsigned int S_number, unsigned int num_siftings, unsigned int*
+		sift_counter);
+static inline void _add_to_sum(float const* restrict src, size_t n,
+		emd_precision sum_precision, void* restrict sum, size_t offset);
 
-// Main EEMD decomposition routine definition
-libeemd_error_code eemd(double const* restrict input, size_t N,
-		double* restrict output, size_t M,
-		unsigned int ensemble_size, double noise_strength, unsigned int
-		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
-	gsl_set_error_handler_off();
-	// Validate parameters
-	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
-	if (validation_result != EMD_SUCCESS) {
-		return validation_result;
-	}
-	// For empty data we have nothing to do
-	if (N == 0) {
-		return EMD_SUCCESS;
-	}
-	if (M == 0) {
-		M = emd_num_imfs(N);
-	}
-	// The noise standard deviation is noise_strength times the standard deviation of input data
-	const double noise_sigma = (noise_strength != 0)? gsl_stats_sd(input, 1, N)*noise_strength : 0;
-	// Initialize output data to zero
-	memset(output, 0x00, M*N*sizeof(double));
-	// Each thread gets a separate workspace if we are using OpenMP
-	eemd_workspace** ws = NULL;
-	// The locks are shared among all threads
-	lock** locks;
-	// Don't start unnecessary threads if the ensemble is small
-	#ifdef _OPENMP
-	if (omp_get_num_threads() > (int)ensemble_size) {
-		omp_set_num_threads(ensemble_size);
-	}
+// Forward declaration of a helper function for a single sifting iteration with
+// the extrema of input already found and stored in the workspace
+static libeemd_error_code _sift_once(double* restrict input,
+		sifting_workspace* restrict w, size_t num_max, size_t num_min,
+		bool find_next, size_t* next_num_max, size_t* next_num_min,
+		size_t* next_num_zc);
+static void _find_extrema(double const* restrict x, size_t N,
+		knot_array maxx, double* restrict maxy, size_t* nmax,
+		knot_array minx, double* restrict miny, size_t* nmin,
+		size_t* nzc);
+
+// Helper function for making the extrema found for the next sifting iteration
+// the current ones
+static inline void _swap_extrema(sifting_workspace* restrict w) {
+	knot_array tmp_x;
+	double* tmp_y;
+	tmp_x = w->maxx; w->maxx = w->next_maxx; w->next_maxx = tmp_x;
+	tmp_y = w->maxy; w->maxy = w->next_maxy; w->next_maxy = tmp_y;
+	tmp_x = w->minx; w->minx = w->next_minx; w->next_minx = tmp_x;
+	tmp_y = w->miny; w->miny = w->next_miny; w->next_miny = tmp_y;
+}
+
+// For very long signals with only a few ensemble members, the threads of a
+// team can sift a single signal together. The workspace and the functions for
+// this are defined after the sequential versions.
+typedef struct sifting_team sifting_team;
+static sifting_team* _carve_sifting_team(arena* a, size_t N, size_t num_chunks,
+		size_t parallel_solve_min_knots);
+static size_t _sifting_team_num_chunks(sifting_team const* team);
+static sifting_workspace* _sifting_team_workspace(sifting_team* team);
+
+// Forward declaration of a helper function that must be called by all threads
+// of a team for sifting input in the same way as _sift
+static libeemd_error_code _sift_team(double* restrict input, sifting_team*
+		restrict team, unsigned int S_number, unsigned int num_siftings,
+		unsigned int* sift_counter);
+
+// Forward declaration of a helper function that must be called by all threads
+// of a team for extracting all IMFs from input in the same way as _emd. The
+// IMFs are added to output without locking, and res must be shared by the
+// team.
+static libeemd_error_code _emd_team(double* restrict input, double* restrict res,
+		sifting_team* restrict team, double* restrict output, imf_layout layout,
+		size_t M, unsigned int S_number, unsigned int num_siftings);
+
+// Start of chunk c when n elements are divided into num_chunks contiguous
+// chunks of (almost) equal size
+static inline size_t _chunk_start(size_t n, size_t num_chunks, size_t c) {
+	return c*(n/num_chunks) + ((c < n%num_chunks)? c : n%num_chunks);
+}
+
+// Number of blocks of CEEMDAN ensemble members per worker of a pool. The
+// workers steal whole blocks, and each block has partial IMFs of its own, so
+// more blocks balance the load better but take more memory.
+static const unsigned int pool_blocks_per_worker = 4;
+
+typedef struct thread_pool thread_pool;
+#if EEMD_THREAD_POOL
+// A persistent pool of worker threads for executing plans without OpenMP.
+// Worker 0 is the thread that runs the pool, and the other workers are
+// threads that wait for work for the whole lifetime of the pool. The work is
+// always a loop over items 0..num_items-1 calling the same task for each.
+// Every worker starts with a contiguous range of the items and takes them
+// from the front of its range. A worker whose range is empty steals the back
+// half of the range of another worker that still has items left, trying the
+// workers on its own NUMA node first. A task gets the number of the worker
+// calling it, so that it can use the workspace of that worker.
+typedef void (*pool_task)(void* context, unsigned int worker, size_t item);
+
+typedef struct {
+	thread_pool* pool;
+	unsigned int id;
+	pthread_t thread;
+	// The CPU the worker is pinned to, or -1, and the other workers in the
+	// order in which it tries to steal from them
+	int cpu;
+	unsigned int* victims;
+	// Items next..end-1 are still to be done by this worker, unless they are
+	// stolen by another one
+	pthread_mutex_t mutex;
+	size_t next;
+	size_t end;
+} pool_worker;
+
+struct thread_pool {
+	unsigned int num_workers;
+	pool_worker* workers;
+	// The current loop, its generation number, and the number of threads
+	// still working on it, protected by mutex
+	pthread_mutex_t mutex;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	unsigned long int generation;
+	unsigned int num_busy;
+	bool shutdown;
+	bool steal;
+	pool_task task;
+	void* context;
+	#if EEMD_NUMA
+	// The CPUs the thread running the pool was allowed to run on before it
+	// was pinned for the current execution
+	cpu_set_t saved_affinity;
 	#endif
-	unsigned int ensemble_counter = 0;
-	// The following section is executed in parallel
-	libeemd_error_code emd_err = EMD_SUCCESS;
-	#pragma omp parallel
-	{
-		#ifdef _OPENMP
-		const int num_threads = omp_get_num_threads();
-		const int thread_id = omp_get_thread_num();
-		#if EEMD_DEBUG >= 1
-		#pragma omp single
-		fprintf(stderr, "Using %d thread(s) with OpenMP.\n", num_threads);
-		#endif
-		#else
-		const int num_threads = 1;
-		const int thread_id = 0;
-		#endif
-		#pragma omp single
-		{
-			ws = malloc(num_threads*sizeof(eemd_workspace*));
-			locks = malloc(M*sizeof(lock*));
-			for (size_t i=0; i<M; i++) {
-				locks[i] = malloc(sizeof(lock));
-				init_lock(locks[i]);
-			}
+};
+
+// Helper function for stealing the back half of the items left to another
+// worker. Returns false if all other workers are out of items.
+static bool _pool_steal(pool_worker* restrict self) {
+	thread_pool* const pool = self->pool;
+	for (unsigned int k=0; k+1<pool->num_workers; k++) {
+		pool_worker* const victim = &pool->workers[self->victims[k]];
+		pthread_mutex_lock(&victim->mutex);
+		const size_t left = victim->end - victim->next;
+		const size_t end = victim->end;
+		victim->end -= (left+1)/2;
+		pthread_mutex_unlock(&victim->mutex);
+		if (left > 0) {
+			// Nobody steals from an empty range, so our own range can be
+			// replaced without a race
+			pthread_mutex_lock(&self->mutex);
+			self->next = end - (left+1)/2;
+			self->end = end;
+			pthread_mutex_unlock(&self->mutex);
+			return true;
 		}
-		// Each thread allocates its own workspace
-		ws[thread_id] = allocate_eemd_workspace(N);
-		eemd_workspace* w = ws[thread_id];
-		// All threads share the same array of locks
-		w->emd_w->locks = locks;
-		// Loop over all ensemble members, dividing them among the threads
-		#pragma omp for
-		for (size_t en_i=0; en_i<ensemble_size; en_i++) {
-			// Check if an error has occured in other threads
-			#pragma omp flush(emd_err)
-			if (emd_err != EMD_SUCCESS) {
-				continue;
-			}
-			// Initialize ensemble member as input data + noise
-			if (noise_strength == 0.0) {
-				array_copy(input, N, w->x);
-			}
-			else {
-				// set rng seed based on ensemble member to ensure
-				// reproducibility even in a multithreaded case
-				set_rng_seed(w, rng_seed+en_i);
-				for (size_t i=0; i<N; i++) {
-					w->x[i] = input[i] + gsl_ran_gaussian(w->r, noise_sigma);
-				}
-			}
-			// Extract IMFs with EMD
-			emd_err = _emd(w->x, w->emd_w, output, M, S_number, num_siftings);
-			#pragma omp flush(emd_err)
-			#pragma omp atomic
-			ensemble_counter++;
-			#if EEMD_DEBUG >= 1
-			fprintf(stderr, "Ensemble iteration %u/%u done.\n", ensemble_counter, ensemble_size);
-			#endif
+	}
+	return false;
+}
+
+// Helper function for doing items until there are none left to any worker
+static void _pool_work(pool_worker* restrict self) {
+	thread_pool* const pool = self->pool;
+	for (;;) {
+		pthread_mutex_lock(&self->mutex);
+		const bool found = (self->next < self->end);
+		const size_t item = self->next;
+		if (found) {
+			self->next++;
 		}
-		// Free resources
-		free_eemd_workspace(w);
-		#pragma omp single
-		{
-			free(ws); ws = NULL;
-			for (size_t i=0; i<M; i++) {
-				destroy_lock(locks[i]);
-				free(locks[i]);
-			}
-			free(locks); locks = NULL;
+		pthread_mutex_unlock(&self->mutex);
+		if (found) {
+			pool->task(pool->context, self->id, item);
+		}
+		else if (!pool->steal || !_pool_steal(self)) {
+			return;
 		}
-	} // End of parallel block
-	if (emd_err != EMD_SUCCESS) {
-		return emd_err;
 	}
-	// Divide output data by the ensemble size to get the average
-	if (ensemble_size != 1) {
-		const double one_per_ensemble_size = 1.0/ensemble_size;
-		array_mult(output, N*M, one_per_ensemble_size);
+}
+
+static void* _pool_thread(void* arg) {
+	pool_worker* const self = arg;
+	thread_pool* const pool = self->pool;
+	unsigned long int generation = 0;
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while (pool->generation == generation && !pool->shutdown) {
+			pthread_cond_wait(&pool->start, &pool->mutex);
+		}
+		if (pool->shutdown) {
+			break;
+		}
+		generation = pool->generation;
+		pthread_mutex_unlock(&pool->mutex);
+		_pool_work(self);
+		pthread_mutex_lock(&pool->mutex);
+		pool->num_busy--;
+		if (pool->num_busy == 0) {
+			pthread_cond_signal(&pool->done);
+		}
 	}
-	return EMD_SUCCESS;
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
 }
 
-// Main CEEMDAN decomposition routine definition
-libeemd_error_code ceemdan(double const* restrict input, size_t N,
-		double* restrict output, size_t M,
-		unsigned int ensemble_size, double noise_strength, unsigned int
-		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
-	gsl_set_error_handler_off();
-	// Validate parameters
-	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
-	if (validation_result != EMD_SUCCESS) {
-		return validation_result;
+// Helper function for running a loop whose items have been divided among the
+// workers
+static void _pool_start(thread_pool* restrict pool, bool steal, pool_task task,
+		void* context) {
+	pthread_mutex_lock(&pool->mutex);
+	pool->task = task;
+	pool->context = context;
+	pool->steal = steal;
+	pool->num_busy = pool->num_workers-1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->mutex);
+	_pool_work(&pool->workers[0]);
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->num_busy > 0) {
+		pthread_cond_wait(&pool->done, &pool->mutex);
 	}
-	// For empty data we have nothing to do
-	if (N == 0) {
-		return EMD_SUCCESS;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+// Run task for items 0..num_items-1 with all workers of the pool, returning
+// when all of them are done
+static void _pool_run(thread_pool* restrict pool, size_t num_items,
+		pool_task task, void* context) {
+	const unsigned int num_workers = pool->num_workers;
+	for (unsigned int t=0; t<num_workers; t++) {
+		pool_worker* const worker = &pool->workers[t];
+		pthread_mutex_lock(&worker->mutex);
+		worker->next = _chunk_start(num_items, num_workers, t);
+		worker->end = _chunk_start(num_items, num_workers, t+1);
+		pthread_mutex_unlock(&worker->mutex);
 	}
-	// For M == 1 the only "IMF" is the residual
-	if (M == 1) {
-		memcpy(output, input, N*sizeof(double));
-		return EMD_SUCCESS;
+	_pool_start(pool, true, task, context);
+}
+
+// Run task once on each worker t, with t as the item. Nothing is stolen, so
+// this is used for touching memory first on the worker that will use it.
+static void _pool_run_each(thread_pool* restrict pool, pool_task task,
+		void* context) {
+	for (unsigned int t=0; t<pool->num_workers; t++) {
+		pool_worker* const worker = &pool->workers[t];
+		pthread_mutex_lock(&worker->mutex);
+		worker->next = t;
+		worker->end = t+1;
+		pthread_mutex_unlock(&worker->mutex);
 	}
-	if (M == 0) {
-		M = emd_num_imfs(N);
+	_pool_start(pool, false, task, context);
+}
+
+// The thread running a pool with pinned workers is pinned to the CPU of
+// worker 0 between _pool_enter and _pool_leave, and then returned to the CPUs
+// it was allowed to run on before
+static void _pool_enter(thread_pool* restrict pool) {
+	#if EEMD_NUMA
+	if (pool->workers[0].cpu >= 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(pool->workers[0].cpu, &set);
+		pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &pool->saved_affinity);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
 	}
-	const double one_per_ensemble_size = 1.0/ensemble_size;
-	// Initialize output data to zero
-	memset(output, 0x00, M*N*sizeof(double));
-	// Each thread gets a separate workspace if we are using OpenMP
-	eemd_workspace** ws = NULL;
-	// All threads need to write to the same row of the output matrix
-	// so we need only one shared lock
-	lock* output_lock = malloc(sizeof(lock));
-	init_lock(output_lock);
-	// The threads also share the same precomputed noise
-	double* noises = malloc(ensemble_size*N*sizeof(double));
-	// Since we need to decompose this noise by EMD, we also need arrays for storing
-	// the residuals
-	double* noise_residuals = malloc(ensemble_size*N*sizeof(double));
-	// Don't start unnecessary threads if the ensemble is small
-	#ifdef _OPENMP
-	if (omp_get_num_threads() > (int)ensemble_size) {
-		omp_set_num_threads(ensemble_size);
+	#else
+	(void)pool;
+	#endif
+}
+
+static void _pool_leave(thread_pool* restrict pool) {
+	#if EEMD_NUMA
+	if (pool->workers[0].cpu >= 0) {
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &pool->saved_affinity);
 	}
+	#else
+	(void)pool;
 	#endif
-	int num_threads;
-	// The following section is executed in parallel
-	#pragma omp parallel
-	{
-		#ifdef _OPENMP
-		num_threads = omp_get_num_threads();
-		const int thread_id = omp_get_thread_num();
-		#if EEMD_DEBUG >= 1
-		#pragma omp single
-		fprintf(stderr, "Using %d thread(s) with OpenMP.\n", num_threads);
-		#endif
-		#else
-		num_threads = 1;
-		const int thread_id = 0;
-		#endif
-		#pragma omp single
-		{
-			ws = malloc(num_threads*sizeof(eemd_workspace*));
+}
+
+static void _pool_destroy(thread_pool* pool) {
+	if (pool == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&pool->mutex);
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->mutex);
+	for (unsigned int t=1; t<pool->num_workers; t++) {
+		pthread_join(pool->workers[t].thread, NULL);
+	}
+	for (unsigned int t=0; t<pool->num_workers; t++) {
+		pthread_mutex_destroy(&pool->workers[t].mutex);
+		free(pool->workers[t].victims);
+	}
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->mutex);
+	free(pool->workers);
+	free(pool);
+}
+
+// Start a pool of num_workers workers, i.e., num_workers-1 new threads. If
+// 'cpus' is not NULL, worker t is pinned to CPU cpus[t] on NUMA node
+// nodes[t]. Returns NULL if memory allocation or starting a thread fails.
+static thread_pool* _pool_create(unsigned int num_workers, int const* cpus,
+		unsigned int const* nodes) {
+	thread_pool* pool = malloc(sizeof(thread_pool));
+	if (pool == NULL) {
+		return NULL;
+	}
+	pool->workers = malloc(num_workers*sizeof(pool_worker));
+	if (pool->workers == NULL) {
+		free(pool);
+		return NULL;
+	}
+	pool->num_workers = num_workers;
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->generation = 0;
+	pool->num_busy = 0;
+	pool->shutdown = false;
+	pool->steal = true;
+	pool->task = NULL;
+	pool->context = NULL;
+	for (unsigned int t=0; t<num_workers; t++) {
+		pool_worker* const worker = &pool->workers[t];
+		worker->pool = pool;
+		worker->id = t;
+		worker->cpu = (cpus != NULL)? cpus[t] : -1;
+		pthread_mutex_init(&worker->mutex, NULL);
+		worker->next = 0;
+		worker->end = 0;
+		// The workers after this one in a cyclic order, first those on the
+		// same node
+		worker->victims = malloc(num_workers*sizeof(unsigned int));
+		unsigned int num_victims = 0;
+		for (int same_node=1; same_node>=0; same_node--) {
+			for (unsigned int k=1; k<num_workers && worker->victims != NULL; k++) {
+				const unsigned int v = (t+k)%num_workers;
+				if ((nodes == NULL || nodes[v] == nodes[t]) == (bool)same_node) {
+					worker->victims[num_victims++] = v;
+				}
+			}
+		}
+		bool started = (worker->victims != NULL);
+		if (started && t > 0) {
+			pthread_attr_t attr;
+			pthread_attr_init(&attr);
+			#if EEMD_NUMA
+			if (worker->cpu >= 0) {
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				CPU_SET(worker->cpu, &set);
+				pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &set);
+			}
+			#endif
+			started = (pthread_create(&worker->thread, &attr, _pool_thread, worker) == 0);
+			pthread_attr_destroy(&attr);
+		}
+		if (!started) {
+			// Only workers 0..t-1 have to be stopped
+			pthread_mutex_destroy(&worker->mutex);
+			free(worker->victims);
+			pool->num_workers = t;
+			_pool_destroy(pool);
+			return NULL;
+		}
+	}
+	return pool;
+}
+#endif
+
+// Forward declaration of a helper function for parameter validation shared by functions eemd and ceemdan
+static inline libeemd_error_code _validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings);
+// Forward declaration of a helper function for the error to return when
+// creating a plan for validated parameters fails
+static inline libeemd_error_code _plan_creation_error(size_t N);
+
+// What a thread remembers between the EEMD ensemble members it works on: its
+// private accumulation buffer (or NULL), the signal whose members are summed
+// there and how many, and the noise standard deviation, which depends only on
+// the signal, for the signal it worked on last
+typedef struct {
+	double* acc;
+	size_t acc_signal;
+	unsigned int acc_count;
+	size_t sigma_signal;
+	double noise_sigma;
+} eemd_thread_state;
+
+// A plan holds everything that EEMD or CEEMDAN needs for decomposing signals
+// of a fixed length: one eemd_workspace for each thread, the locks protecting
+// the output matrices and, for CEEMDAN, the precomputed noise and its
+// residuals. All of this memory, including the plan itself, is carved from a
+// single block when the plan is created, so that executing the plan does not
+// allocate anything. Only the threads of the pool and the Mersenne Twisters
+// of EMD_RNG_MT19937 are allocated separately.
+struct emd_plan {
+	emd_variant variant;
+	size_t N;
+	size_t M;
+	unsigned int ensemble_size;
+	unsigned int num_threads;
+	// Random number generator for the added noise
+	emd_rng_type rng;
+	// Workspaces for each thread
+	eemd_workspace** ws;
+	// EEMD: one lock for each row of the output matrix. When decomposing a
+	// batch of signals, signal s uses the set of M locks starting at
+	// locks[(s % num_lock_sets)*M].
+	size_t num_lock_sets;
+	lock* locks;
+	// EEMD: private buffers to which threads sum their ensemble members
+	// before adding them to the shared output matrix
+	emd_accumulation_mode accumulation;
+	unsigned int flush_interval;
+	unsigned int num_accumulators;
+	double** accumulators;
+	// CEEMDAN: signals are decomposed in groups of ceemdan_group_size
+	// signals, so that there are enough ensemble members to keep all threads
+	// busy even if the ensemble is small. Each signal in a group has a
+	// residual and its standard deviation shared among all threads, and each
+	// ensemble member has its own white noise and residual of the noise. Each
+	// thread sums the modes it extracts to its own partial IMFs for all
+	// signals in the group. With the thread pool, the members of a group are
+	// instead split into num_partials fixed blocks, each summed in order to
+	// partial IMFs of its own, so that the sums do not depend on which worker
+	// extracted which member. Only the first num_resident_members members of a
+	// group keep their noise (two modes of it) in memory. The others
+	// regenerate it to per-thread scratch space.
+	size_t ceemdan_group_size;
+	size_t num_resident_members;
+	double* noises;
+	double* noise_residuals;
+	double** noise_scratch;
+	double* res;
+	double* res_sd;
+	unsigned int num_partials;
+	double** partial_imfs;
+	// Workspace for sifting a single signal with all threads, or NULL if the
+	// signals are too short for that
+	bool use_sift_team;
+	size_t parallel_solve_min_knots;
+	sifting_team* sift_team;
+	// Single-precision plans: each thread has its ensemble member and its
+	// residual as floats, and a buffer for summing its IMFs in sum_precision
+	// (M*N elements for EEMD, N for CEEMDAN). CEEMDAN keeps two modes and
+	// the residual of the noise of every ensemble member as floats, and the
+	// residual of the signal. The double-precision buffers above are not
+	// allocated, except for the workspaces of the threads.
+	emd_precision precision;
+	emd_precision sum_precision;
+	float** float_signals;
+	void** float_sums;
+	float* float_noises;
+	float* float_res;
+	// Plans using the thread pool: the pool, whose worker t uses workspace t,
+	// and what each worker remembers between EEMD ensemble members. NULL for
+	// plans using OpenMP.
+	emd_threading threading;
+	thread_pool* pool;
+	eemd_thread_state* pool_states;
+	// Plans placing memory on NUMA nodes: the node of each worker of the
+	// pool, where the memory that worker t carves for itself starts
+	// (worker_regions[t]) and ends (worker_regions[t+1]), and for EEMD, a
+	// buffer for summing the ensemble members of a single signal on each node
+	// and the locks protecting its rows
+	emd_numa_mode numa;
+	unsigned int num_nodes;
+	unsigned int* worker_nodes;
+	char** worker_regions;
+	double** node_sums;
+	lock* node_locks;
+	// The block the plan was carved from as it was allocated, and the
+	// function for freeing it. The block is NULL if it was given by the
+	// caller.
+	void* block;
+	void (*deallocate)(void* ptr, void* context);
+	void* allocator_context;
+};
+
+// Threads are taken from OpenMP if libeemd is built with it, and otherwise
+// from the thread pool if that is built
+#if !defined(_OPENMP) && EEMD_THREAD_POOL
+static const emd_threading default_threading = EMD_THREADS_POOL;
+#else
+static const emd_threading default_threading = EMD_THREADS_OPENMP;
+#endif
+
+// Default number of threads for the given backend, used for plans created
+// with num_threads=0 and by the batch routines. Inside a parallel region of
+// the caller this is one, so that libeemd does not add threads of its own to
+// the threads of the caller. This is decided only by querying the OpenMP
+// runtime, never by changing its settings.
+static unsigned int _default_num_threads(emd_threading threading) {
+	(void)threading;
+	#ifdef _OPENMP
+	if (omp_in_parallel()) {
+		return 1;
+	}
+	#endif
+	#if EEMD_THREAD_POOL
+	if (threading == EMD_THREADS_POOL) {
+		const long n = sysconf(_SC_NPROCESSORS_ONLN);
+		return (n > 0)? (unsigned int)n : 1;
+	}
+	#endif
+	#ifdef _OPENMP
+	return (unsigned int)omp_get_max_threads();
+	#else
+	return 1;
+	#endif
+}
+
+#if EEMD_NUMA
+// Helper function for reading a list of CPUs or nodes such as "0-3,8,10-11"
+// from the file at path to set. Returns false if the file cannot be read.
+static bool _read_id_list(char const* path, cpu_set_t* set) {
+	FILE* f = fopen(path, "r");
+	if (f == NULL) {
+		return false;
+	}
+	CPU_ZERO(set);
+	int first;
+	while (fscanf(f, "%d", &first) == 1) {
+		int last = first;
+		int c = fgetc(f);
+		if (c == '-') {
+			if (fscanf(f, "%d", &last) != 1) {
+				break;
+			}
+			c = fgetc(f);
+		}
+		for (int i=first; i<=last && i<CPU_SETSIZE; i++) {
+			CPU_SET(i, set);
+		}
+		if (c != ',') {
+			break;
+		}
+	}
+	fclose(f);
+	return true;
+}
+
+// Helper function for choosing the CPU cpus[t] and the NUMA node nodes[t] of
+// each worker t of a pinned thread pool. The CPUs the calling thread is
+// allowed to run on are grouped by their nodes, CPUs on no node forming one
+// more node, and the workers are divided among the nodes in contiguous blocks
+// of (almost) equal size. Within a node the workers take the CPUs in order,
+// starting over if there are more workers than CPUs. Returns the number of
+// nodes used, or zero if the allowed CPUs cannot be read.
+static unsigned int _numa_placement(unsigned int num_workers, int* restrict cpus,
+		unsigned int* restrict nodes) {
+	cpu_set_t allowed;
+	if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &allowed) != 0
+			|| CPU_COUNT(&allowed) == 0) {
+		return 0;
+	}
+	// The allowed CPUs in the order of their nodes, and where the CPUs of
+	// each node start in that order
+	int cpu_order[CPU_SETSIZE];
+	size_t node_start[CPU_SETSIZE+2];
+	size_t num_cpus = 0;
+	unsigned int num_nodes = 0;
+	cpu_set_t placed;
+	CPU_ZERO(&placed);
+	cpu_set_t online;
+	const bool have_nodes = _read_id_list("/sys/devices/system/node/online", &online);
+	for (int node=0; node<=CPU_SETSIZE; node++) {
+		cpu_set_t node_cpus;
+		if (node < CPU_SETSIZE) {
+			char path[64];
+			snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+			if (!have_nodes || !CPU_ISSET(node, &online) || !_read_id_list(path, &node_cpus)) {
+				continue;
+			}
+		}
+		else {
+			// The allowed CPUs that were not found on any node
+			CPU_XOR(&node_cpus, &allowed, &placed);
+		}
+		node_start[num_nodes] = num_cpus;
+		for (int c=0; c<CPU_SETSIZE; c++) {
+			if (CPU_ISSET(c, &node_cpus) && CPU_ISSET(c, &allowed) && !CPU_ISSET(c, &placed)) {
+				CPU_SET(c, &placed);
+				cpu_order[num_cpus++] = c;
+			}
+		}
+		if (num_cpus > node_start[num_nodes]) {
+			num_nodes++;
+		}
+	}
+	node_start[num_nodes] = num_cpus;
+	for (unsigned int k=0; k<num_nodes; k++) {
+		const size_t first_worker = _chunk_start(num_workers, num_nodes, k);
+		const size_t end_worker = _chunk_start(num_workers, num_nodes, k+1);
+		const size_t cpus_on_node = node_start[k+1] - node_start[k];
+		for (size_t t=first_worker; t<end_worker; t++) {
+			cpus[t] = cpu_order[node_start[k] + (t-first_worker)%cpus_on_node];
+			nodes[t] = k;
+		}
+	}
+	return num_nodes;
+}
+
+#endif
+
+// Alignment of the memory of each worker and node of a plan, and of the
+// block it is allocated from: a page for plans placing memory on NUMA nodes,
+// so that no page is shared by two nodes
+static size_t _plan_region_alignment(emd_plan const* plan) {
+	#if EEMD_NUMA
+	if (plan->numa == EMD_NUMA_LOCAL) {
+		const long page_size = sysconf(_SC_PAGESIZE);
+		if (page_size > EMD_WORKSPACE_ALIGNMENT) {
+			return (size_t)page_size;
+		}
+	}
+	#else
+	(void)plan;
+	#endif
+	return EMD_WORKSPACE_ALIGNMENT;
+}
+
+// Whether a plan sums the ensemble members of a single EEMD signal on each
+// NUMA node first. This is done if every thread has a private buffer that is
+// never flushed before the end.
+static bool _plan_has_node_sums(emd_plan const* plan) {
+	return plan->numa == EMD_NUMA_LOCAL && plan->variant == EMD_VARIANT_EEMD
+		&& plan->num_accumulators == plan->num_threads && plan->flush_interval == 0;
+}
+
+// Helper function for carving the memory that worker (or thread) t of a plan
+// uses alone: its workspace, its EEMD summation buffer, its CEEMDAN partial
+// modes and noise scratch space, and its single-precision buffers. The arrays
+// of pointers to these must already be carved. Which of them are needed is
+// decided by the parameters of the plan, since the pointers are all NULL
+// when the plan is only measured.
+static void _plan_layout_worker(emd_plan* plan, unsigned int t, arena* a) {
+	const size_t N = plan->N;
+	eemd_workspace* w = _carve_eemd_workspace(a, N);
+	if (plan->ws != NULL) {
+		plan->ws[t] = w;
+	}
+	if (plan->precision == EMD_PRECISION_FLOAT) {
+		const size_t sum_elem_size = (plan->sum_precision == EMD_PRECISION_DOUBLE)?
+			sizeof(double) : sizeof(float);
+		const size_t sum_size = (plan->variant == EMD_VARIANT_EEMD)? plan->M*N : N;
+		float* signal = _arena_alloc(a, 2*N*sizeof(float));
+		void* sum = _arena_alloc(a, sum_size*sum_elem_size);
+		if (plan->float_signals != NULL) {
+			plan->float_signals[t] = signal;
+			plan->float_sums[t] = sum;
+		}
+	}
+	else if (plan->variant == EMD_VARIANT_EEMD) {
+		if (t < plan->num_accumulators) {
+			double* acc = _arena_alloc(a, plan->M*N*sizeof(double));
+			if (plan->accumulators != NULL) {
+				plan->accumulators[t] = acc;
+			}
+		}
+	}
+	else {
+		// The partial IMFs of the blocks of members the worker starts with
+		const size_t first = _chunk_start(plan->num_partials, plan->num_threads, t);
+		const size_t end = _chunk_start(plan->num_partials, plan->num_threads, t+1);
+		for (size_t p=first; p<end; p++) {
+			double* partial_imf = _arena_alloc(a, plan->ceemdan_group_size*N*sizeof(double));
+			if (plan->partial_imfs != NULL) {
+				plan->partial_imfs[p] = partial_imf;
+			}
+		}
+		if (plan->num_resident_members < plan->ceemdan_group_size*plan->ensemble_size) {
+			double* scratch = _arena_alloc(a, 2*N*sizeof(double));
+			if (plan->noise_scratch != NULL) {
+				plan->noise_scratch[t] = scratch;
+			}
+		}
+	}
+}
+
+// Helper function for laying out the memory of a plan with the parameters
+// given by params: the plan itself, then everything shared by its threads,
+// the memory of each thread and finally the EEMD summation buffers of the
+// NUMA nodes. Returns the plan carved from the block of the arena, or NULL
+// if the arena only measures. For plans placing memory on NUMA nodes, the
+// memory of each worker is only reserved here, to be carved and first
+// touched by the worker itself.
+static emd_plan* _plan_layout(emd_plan const* params, arena* a) {
+	emd_plan measured;
+	emd_plan* const carved = _arena_alloc(a, sizeof(emd_plan));
+	emd_plan* const plan = (carved != NULL)? carved : &measured;
+	*plan = *params;
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	const unsigned int num_threads = plan->num_threads;
+	const bool numa = (plan->numa == EMD_NUMA_LOCAL);
+	const bool node_sums = _plan_has_node_sums(plan);
+	const size_t region_alignment = _plan_region_alignment(plan);
+	plan->ws = _arena_alloc(a, num_threads*sizeof(eemd_workspace*));
+	if (plan->threading == EMD_THREADS_POOL) {
+		plan->pool_states = _arena_alloc(a, num_threads*sizeof(eemd_thread_state));
+	}
+	if (numa) {
+		plan->worker_nodes = _arena_alloc(a, num_threads*sizeof(unsigned int));
+		plan->worker_regions = _arena_alloc(a, (num_threads+1)*sizeof(char*));
+	}
+	if (plan->precision == EMD_PRECISION_FLOAT) {
+		plan->float_signals = _arena_alloc(a, num_threads*sizeof(float*));
+		plan->float_sums = _arena_alloc(a, num_threads*sizeof(void*));
+		if (plan->variant == EMD_VARIANT_CEEMDAN) {
+			plan->float_noises = _arena_alloc(a, 3*(size_t)plan->ensemble_size*N*sizeof(float));
+			plan->float_res = _arena_alloc(a, N*sizeof(float));
+		}
+	}
+	else if (plan->variant == EMD_VARIANT_EEMD) {
+		plan->locks = _arena_alloc(a, plan->num_lock_sets*M*sizeof(lock));
+		if (plan->num_accumulators > 0) {
+			plan->accumulators = _arena_alloc(a, plan->num_accumulators*sizeof(double*));
+		}
+		if (node_sums) {
+			plan->node_sums = _arena_alloc(a, plan->num_nodes*sizeof(double*));
+			plan->node_locks = _arena_alloc(a, plan->num_nodes*M*sizeof(lock));
+		}
+	}
+	else {
+		const size_t group_size = plan->ceemdan_group_size;
+		plan->partial_imfs = _arena_alloc(a, plan->num_partials*sizeof(double*));
+		plan->noises = _arena_alloc(a, 2*plan->num_resident_members*N*sizeof(double));
+		plan->noise_residuals = _arena_alloc(a, plan->num_resident_members*N*sizeof(double));
+		if (plan->num_resident_members < group_size*plan->ensemble_size) {
+			plan->noise_scratch = _arena_alloc(a, num_threads*sizeof(double*));
+		}
+		plan->res = _arena_alloc(a, group_size*N*sizeof(double));
+		plan->res_sd = _arena_alloc(a, group_size*sizeof(double));
+	}
+	if (plan->use_sift_team) {
+		plan->sift_team = _carve_sifting_team(a, N, num_threads,
+				plan->parallel_solve_min_knots);
+	}
+	for (unsigned int t=0; t<num_threads; t++) {
+		if (numa) {
+			// Only measure the memory of the worker here, which also sets
+			// its pointers to NULL until the worker carves it
+			_arena_align(a, region_alignment);
+			if (plan->worker_regions != NULL) {
+				plan->worker_regions[t] = a->base + a->used;
+			}
+			arena reserved = {NULL, 0};
+			_plan_layout_worker(plan, t, &reserved);
+			a->used += reserved.used;
+		}
+		else {
+			_plan_layout_worker(plan, t, a);
+		}
+	}
+	if (numa) {
+		_arena_align(a, region_alignment);
+		if (plan->worker_regions != NULL) {
+			plan->worker_regions[num_threads] = a->base + a->used;
+		}
+	}
+	if (node_sums) {
+		for (unsigned int k=0; k<plan->num_nodes; k++) {
+			_arena_align(a, region_alignment);
+			double* sum = _arena_alloc(a, M*N*sizeof(double));
+			if (plan->node_sums != NULL) {
+				plan->node_sums[k] = sum;
+			}
+		}
+	}
+	return carved;
+}
+
+#if EEMD_NUMA
+// Helper function for a worker of a plan placing memory on NUMA nodes, for
+// carving its own workspace and buffers from the memory reserved for it.
+// Only the worker itself touches this memory, so its pages are placed on the
+// node of the worker as they are first used, unless the memory was already
+// touched before the plan was created. The first worker of each node also
+// touches the EEMD summation buffer of the node, which must start from zero.
+static void _numa_place_worker(void* context, unsigned int worker,
+		__attribute__((unused)) size_t item) {
+	emd_plan* const plan = context;
+	arena a = {plan->worker_regions[worker], 0};
+	_plan_layout_worker(plan, worker, &a);
+	const unsigned int node = plan->worker_nodes[worker];
+	if (plan->node_sums != NULL && (worker == 0 || plan->worker_nodes[worker-1] != node)) {
+		memset(plan->node_sums[node], 0x00, plan->M*plan->N*sizeof(double));
+	}
+}
+#endif
+
+void emd_plan_options_init(emd_plan_options* options) {
+	options->accumulation = EMD_ACCUMULATE_PRIVATE;
+	options->accumulation_memory_limit = 256*1024*1024;
+	options->flush_interval = 0;
+	options->rng = EMD_RNG_PHILOX;
+	options->noise_memory_limit = 0;
+	options->parallel_sift_min_length = 1024*1024;
+	options->parallel_solve_min_knots = 32*1024;
+	options->precision = EMD_PRECISION_DOUBLE;
+	options->sum_precision = EMD_PRECISION_DOUBLE;
+	options->threading = default_threading;
+	options->numa = EMD_NUMA_NONE;
+	options->workspace = NULL;
+	options->workspace_size = 0;
+	options->allocate = NULL;
+	options->deallocate = NULL;
+	options->allocator_context = NULL;
+}
+
+// Helper function for checking the parameters of a plan and deciding
+// everything about it that does not depend on where its memory is: the
+// number of threads and which buffers it needs and how large they are. All
+// pointers of the plan are set to NULL. For plans placing memory on NUMA
+// nodes, the CPU and the node of each worker are stored to the newly
+// allocated arrays *cpus and *nodes, which the caller must free. Returns
+// false if the parameters are invalid or the placement fails.
+static bool _plan_parameters(emd_plan* plan, emd_variant variant, size_t N,
+		size_t M, unsigned int ensemble_size, unsigned int num_threads,
+		emd_plan_options const* options, int** cpus, unsigned int** nodes) {
+	*cpus = NULL;
+	*nodes = NULL;
+	if (variant != EMD_VARIANT_EEMD && variant != EMD_VARIANT_CEEMDAN) {
+		return false;
+	}
+	if (ensemble_size < 1 || N > EEMD_MAX_KNOT_N) {
+		return false;
+	}
+	if (options->accumulation != EMD_ACCUMULATE_LOCKED && options->accumulation != EMD_ACCUMULATE_PRIVATE) {
+		return false;
+	}
+	if (options->rng != EMD_RNG_PHILOX && options->rng != EMD_RNG_MT19937) {
+		return false;
+	}
+	if ((options->precision != EMD_PRECISION_DOUBLE && options->precision != EMD_PRECISION_FLOAT)
+			|| (options->sum_precision != EMD_PRECISION_DOUBLE && options->sum_precision != EMD_PRECISION_FLOAT)) {
+		return false;
+	}
+	if (options->threading != EMD_THREADS_OPENMP && options->threading != EMD_THREADS_POOL) {
+		return false;
+	}
+	const bool use_pool = (options->threading == EMD_THREADS_POOL);
+	#if !EEMD_THREAD_POOL
+	if (use_pool) {
+		return false;
+	}
+	#endif
+	if (options->numa != EMD_NUMA_NONE && options->numa != EMD_NUMA_LOCAL) {
+		return false;
+	}
+	const bool numa = (options->numa == EMD_NUMA_LOCAL);
+	if (numa && (!use_pool || !EEMD_NUMA)) {
+		return false;
+	}
+	if (M == 0) {
+		M = emd_num_imfs(N);
+	}
+	const bool single_precision = (options->precision == EMD_PRECISION_FLOAT);
+	if (use_pool && single_precision) {
+		return false;
+	}
+	const bool long_signal = (options->parallel_sift_min_length != 0
+			&& N >= options->parallel_sift_min_length && !single_precision
+			&& !use_pool);
+	if (use_pool) {
+		#if EEMD_THREAD_POOL
+		// The pool never sifts a signal with several threads, so more
+		// threads than ensemble members would be idle
+		if (num_threads == 0) {
+			num_threads = _default_num_threads(EMD_THREADS_POOL);
+			if (num_threads > ensemble_size) {
+				num_threads = ensemble_size;
+			}
+		}
+		#endif
+	}
+	else {
+		#ifdef _OPENMP
+		if (num_threads == 0) {
+			// Don't start unnecessary threads if the ensemble is small, unless
+			// the signal is long enough to be sifted by several threads
+			num_threads = _default_num_threads(EMD_THREADS_OPENMP);
+			if (num_threads > ensemble_size && !long_signal) {
+				num_threads = ensemble_size;
+			}
+		}
+		#else
+		num_threads = 1;
+		#endif
+	}
+	plan->variant = variant;
+	plan->N = N;
+	plan->M = M;
+	plan->ensemble_size = ensemble_size;
+	plan->num_threads = num_threads;
+	plan->ws = NULL;
+	plan->num_lock_sets = 0;
+	plan->locks = NULL;
+	plan->accumulation = options->accumulation;
+	plan->flush_interval = options->flush_interval;
+	plan->rng = options->rng;
+	plan->num_accumulators = 0;
+	plan->accumulators = NULL;
+	plan->ceemdan_group_size = 0;
+	plan->num_partials = 0;
+	plan->partial_imfs = NULL;
+	plan->res_sd = NULL;
+	plan->num_resident_members = 0;
+	plan->noises = NULL;
+	plan->noise_residuals = NULL;
+	plan->noise_scratch = NULL;
+	plan->res = NULL;
+	plan->use_sift_team = false;
+	plan->parallel_solve_min_knots = options->parallel_solve_min_knots;
+	plan->sift_team = NULL;
+	plan->precision = options->precision;
+	plan->sum_precision = options->sum_precision;
+	plan->float_signals = NULL;
+	plan->float_sums = NULL;
+	plan->float_noises = NULL;
+	plan->float_res = NULL;
+	plan->threading = options->threading;
+	plan->pool = NULL;
+	plan->pool_states = NULL;
+	plan->numa = options->numa;
+	plan->num_nodes = 1;
+	plan->worker_nodes = NULL;
+	plan->worker_regions = NULL;
+	plan->node_sums = NULL;
+	plan->node_locks = NULL;
+	plan->block = NULL;
+	plan->deallocate = NULL;
+	plan->allocator_context = NULL;
+	#if EEMD_NUMA
+	if (numa) {
+		*cpus = malloc(num_threads*sizeof(int));
+		*nodes = malloc(num_threads*sizeof(unsigned int));
+		if (*cpus == NULL || *nodes == NULL) {
+			return false;
+		}
+		plan->num_nodes = _numa_placement(num_threads, *cpus, *nodes);
+		if (plan->num_nodes == 0) {
+			return false;
+		}
+	}
+	#endif
+	if (single_precision) {
+		return true;
+	}
+	plan->use_sift_team = (long_signal && num_threads > 1 && N > num_threads);
+	if (variant == EMD_VARIANT_EEMD) {
+		// Threads working on different signals of a batch rarely need the
+		// same set of locks if there is one set per thread
+		plan->num_lock_sets = num_threads;
+		// Private accumulation buffers are useless for plain EMD, since then
+		// each signal is worked on by a single thread anyway. Otherwise give a
+		// buffer to as many threads as the memory limit allows.
+		if (options->accumulation == EMD_ACCUMULATE_PRIVATE && ensemble_size > 1 && M*N > 0) {
+			const size_t buffer_size = M*N*sizeof(double);
+			const size_t limit = options->accumulation_memory_limit;
+			plan->num_accumulators = num_threads;
+			if (limit != 0 && limit/buffer_size < num_threads) {
+				plan->num_accumulators = (unsigned int)(limit/buffer_size);
+			}
+		}
+	}
+	else {
+		// Instead of locking the output matrix, the threads sum their modes
+		// to private buffers, which are added together after each mode. The
+		// threads also share the same noise, with separate slots for the
+		// current and the next mode. Since we need to decompose this noise by
+		// EMD, we also need arrays for storing the residuals. Keep as many
+		// members in memory as the memory limit allows.
+		const size_t group_size = (num_threads + ensemble_size - 1)/ensemble_size;
+		plan->ceemdan_group_size = group_size;
+		const size_t num_members = group_size*ensemble_size;
+		// A pool of a single worker has nobody to steal its members
+		plan->num_partials = num_threads;
+		if (options->threading == EMD_THREADS_POOL && num_threads > 1) {
+			plan->num_partials = (num_members < pool_blocks_per_worker*num_threads)?
+				(unsigned int)num_members : pool_blocks_per_worker*num_threads;
+		}
+		const size_t member_size = 3*N*sizeof(double);
+		const size_t limit = options->noise_memory_limit;
+		plan->num_resident_members = num_members;
+		if (limit != 0 && member_size != 0 && limit/member_size < num_members) {
+			plan->num_resident_members = limit/member_size;
+		}
+	}
+	return true;
+}
+
+size_t emd_plan_workspace_size(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads,
+		emd_plan_options const* options) {
+	emd_plan_options default_options;
+	if (options == NULL) {
+		emd_plan_options_init(&default_options);
+		options = &default_options;
+	}
+	emd_plan params;
+	int* cpus;
+	unsigned int* nodes;
+	const bool valid = _plan_parameters(&params, variant, N, M, ensemble_size,
+			num_threads, options, &cpus, &nodes);
+	free(cpus);
+	free(nodes);
+	if (!valid) {
+		return 0;
+	}
+	arena a = {NULL, 0};
+	_plan_layout(&params, &a);
+	return a.used;
+}
+
+emd_plan* emd_plan_create(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads) {
+	return emd_plan_create_with_options(variant, N, M, ensemble_size,
+			num_threads, NULL);
+}
+
+// Helper function for creating the plan of eemd, ceemdan and their batch and
+// float variants. These keep reseeding a Mersenne Twister for each ensemble
+// member, so that they give the same results as libeemd 1.4 and earlier.
+// For the same reason they never use the partitioned spline solver, whose
+// results depend on the number of threads. Single precision plans cannot use the thread pool, which is the default in
+// builds without OpenMP, so they always use OpenMP, which then runs on a
+// single thread.
+static emd_plan* _create_routine_plan(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads,
+		emd_precision precision) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.rng = EMD_RNG_MT19937;
+	options.precision = precision;
+	options.parallel_solve_min_knots = 0;
+	if (precision == EMD_PRECISION_FLOAT) {
+		options.threading = EMD_THREADS_OPENMP;
+	}
+	return emd_plan_create_with_options(variant, N, M, ensemble_size,
+			num_threads, &options);
+}
+
+// Helper functions for allocating the block of a plan when the caller gives
+// no allocator. The arrays of a plan are sized for the worst case, such as an
+// extremum at every other point, but sifting only touches them up to the
+// numbers of extrema actually found. Large blocks are therefore mapped
+// without reserving swap space for them, so that memory is committed page by
+// page as it is first touched and grows with the signals instead of being
+// accounted for the worst case up front. The length of the mapping, or zero
+// for a block from malloc, is stored in front of the block.
+#ifndef EEMD_LAZY_BLOCK_MIN_SIZE
+#define EEMD_LAZY_BLOCK_MIN_SIZE (1024*1024)
+#endif
+
+static void* _default_allocate(size_t size, __attribute__((unused)) void* context) {
+	const size_t length = size + EMD_WORKSPACE_ALIGNMENT;
+	char* mem = NULL;
+	#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MAP_NORESERVE)
+	if (size >= EEMD_LAZY_BLOCK_MIN_SIZE) {
+		void* mapping = mmap(NULL, length, PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+		if (mapping == MAP_FAILED) {
+			return NULL;
+		}
+		mem = mapping;
+		*(size_t*)mem = length;
+		return mem + EMD_WORKSPACE_ALIGNMENT;
+	}
+	#endif
+	mem = malloc(length);
+	if (mem == NULL) {
+		return NULL;
+	}
+	*(size_t*)mem = 0;
+	return mem + EMD_WORKSPACE_ALIGNMENT;
+}
+
+static void _default_deallocate(void* ptr, __attribute__((unused)) void* context) {
+	char* const mem = (char*)ptr - EMD_WORKSPACE_ALIGNMENT;
+	const size_t length = *(size_t*)mem;
+	#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MAP_NORESERVE)
+	if (length != 0) {
+		munmap(mem, length);
+		return;
+	}
+	#endif
+	(void)length;
+	free(mem);
+}
+
+emd_plan* emd_plan_create_with_options(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads,
+		emd_plan_options const* options) {
+	emd_plan_options default_options;
+	if (options == NULL) {
+		emd_plan_options_init(&default_options);
+		options = &default_options;
+	}
+	emd_plan params;
+	int* cpus;
+	unsigned int* nodes;
+	if (!_plan_parameters(&params, variant, N, M, ensemble_size, num_threads,
+				options, &cpus, &nodes)) {
+		free(cpus);
+		free(nodes);
+		return NULL;
+	}
+	arena a = {NULL, 0};
+	_plan_layout(&params, &a);
+	const size_t size = a.used;
+	char* block = NULL;
+	if (options->workspace != NULL) {
+		// The regions of the workers must start at aligned addresses, which
+		// for NUMA placement means whole pages
+		if (options->workspace_size < size
+				|| (uintptr_t)options->workspace % _plan_region_alignment(&params) != 0) {
+			free(cpus);
+			free(nodes);
+			return NULL;
+		}
+		a.base = options->workspace;
+	}
+	else {
+		// Allocate enough for aligning the start of the block
+		const size_t alignment = _plan_region_alignment(&params);
+		block = (options->allocate != NULL)?
+			options->allocate(size + alignment - 1, options->allocator_context) :
+			_default_allocate(size + alignment - 1, NULL);
+		if (block == NULL) {
+			free(cpus);
+			free(nodes);
+			return NULL;
+		}
+		a.base = block + (alignment - (uintptr_t)block%alignment)%alignment;
+	}
+	a.used = 0;
+	emd_plan* plan = _plan_layout(&params, &a);
+	plan->block = block;
+	if (block != NULL) {
+		plan->deallocate = (options->allocate != NULL)? options->deallocate : _default_deallocate;
+		plan->allocator_context = options->allocator_context;
+	}
+	if (plan->locks != NULL) {
+		for (size_t i=0; i<plan->num_lock_sets*plan->M; i++) {
+			init_lock(&plan->locks[i]);
+		}
+	}
+	if (plan->node_locks != NULL) {
+		for (size_t i=0; i<plan->num_nodes*plan->M; i++) {
+			init_lock(&plan->node_locks[i]);
+		}
+	}
+	if (nodes != NULL) {
+		memcpy(plan->worker_nodes, nodes, plan->num_threads*sizeof(unsigned int));
+	}
+	free(nodes);
+	#if EEMD_THREAD_POOL
+	if (plan->threading == EMD_THREADS_POOL) {
+		plan->pool = _pool_create(plan->num_threads, cpus, plan->worker_nodes);
+	}
+	#endif
+	free(cpus);
+	if (plan->threading == EMD_THREADS_POOL && plan->pool == NULL) {
+		emd_plan_destroy(plan);
+		return NULL;
+	}
+	#if EEMD_NUMA
+	if (plan->numa == EMD_NUMA_LOCAL) {
+		_pool_enter(plan->pool);
+		_pool_run_each(plan->pool, _numa_place_worker, plan);
+		_pool_leave(plan->pool);
+	}
+	#endif
+	if (plan->rng == EMD_RNG_MT19937) {
+		for (unsigned int t=0; t<plan->num_threads; t++) {
+			plan->ws[t]->r = gsl_rng_alloc(gsl_rng_mt19937);
+			if (plan->ws[t]->r == NULL) {
+				emd_plan_destroy(plan);
+				return NULL;
+			}
+		}
+	}
+	return plan;
+}
+
+unsigned int emd_plan_get_num_threads(emd_plan const* plan) {
+	return plan->num_threads;
+}
+
+// Helper for summing the statistics of a sifting workspace to stats, and
+// optionally resetting them
+static void _sifting_workspace_stats(sifting_workspace* restrict w,
+		emd_plan_stats* restrict stats, bool reset) {
+	for (int k=0; k<2; k++) {
+		if (stats != NULL) {
+			stats->envelopes += w->num_envelopes[k];
+			stats->reused_factorizations += w->num_reused[k];
+		}
+		if (reset) {
+			w->num_envelopes[k] = 0;
+			w->num_reused[k] = 0;
+		}
+	}
+}
+
+void emd_plan_get_stats(emd_plan const* plan, emd_plan_stats* stats) {
+	stats->envelopes = 0;
+	stats->reused_factorizations = 0;
+	for (unsigned int thread_id=0; thread_id<plan->num_threads; thread_id++) {
+		_sifting_workspace_stats(plan->ws[thread_id]->emd_w->sift_w, stats, false);
+	}
+	if (plan->sift_team != NULL) {
+		_sifting_workspace_stats(_sifting_team_workspace(plan->sift_team), stats, false);
+	}
+}
+
+void emd_plan_reset_stats(emd_plan* plan) {
+	for (unsigned int thread_id=0; thread_id<plan->num_threads; thread_id++) {
+		_sifting_workspace_stats(plan->ws[thread_id]->emd_w->sift_w, NULL, true);
+	}
+	if (plan->sift_team != NULL) {
+		_sifting_workspace_stats(_sifting_team_workspace(plan->sift_team), NULL, true);
+	}
+}
+
+void emd_plan_destroy(emd_plan* plan) {
+	if (plan == NULL) {
+		return;
+	}
+	#if EEMD_THREAD_POOL
+	_pool_destroy(plan->pool); plan->pool = NULL;
+	#endif
+	if (plan->locks != NULL) {
+		for (size_t i=0; i<plan->num_lock_sets*plan->M; i++) {
+			destroy_lock(&plan->locks[i]);
+		}
+	}
+	if (plan->node_locks != NULL) {
+		for (size_t i=0; i<plan->num_nodes*plan->M; i++) {
+			destroy_lock(&plan->node_locks[i]);
+		}
+	}
+	for (unsigned int thread_id=0; thread_id<plan->num_threads; thread_id++) {
+		eemd_workspace* const w = plan->ws[thread_id];
+		if (w != NULL && w->r != NULL) {
+			gsl_rng_free(w->r); w->r = NULL;
+		}
+	}
+	// The plan itself is in the block, so nothing of it can be used after
+	// the block is freed
+	if (plan->block != NULL && plan->deallocate != NULL) {
+		plan->deallocate(plan->block, plan->allocator_context);
+	}
+}
+
+size_t emd_plan_num_imfs(emd_plan const* plan) {
+	return plan->M;
+}
+
+// A bank of precomputed noise modes for CEEMDAN. For ensemble member i and
+// mode k < M, modes[(i*M+k)*N] holds the N samples of the noise used for
+// that mode, and sds[i*M+k] its standard deviation. The data is either
+// allocated or mapped from a file.
+struct emd_noise_bank {
+	size_t N;
+	size_t M;
+	unsigned int ensemble_size;
+	unsigned int S_number;
+	unsigned int num_siftings;
+	unsigned long int rng_seed;
+	emd_rng_type rng;
+	double const* modes;
+	double const* sds;
+	void* storage;
+	size_t storage_size;
+	bool mapped;
+};
+
+// Files written by emd_noise_bank_save start with this header, followed by
+// the modes and the standard deviations. The byte order marker detects files
+// written on a machine with different endianness.
+#define _NOISE_BANK_MAGIC "EEMDNB01"
+typedef struct {
+	char magic[8];
+	uint64_t byte_order;
+	uint64_t N;
+	uint64_t M;
+	uint64_t ensemble_size;
+	uint64_t S_number;
+	uint64_t num_siftings;
+	uint64_t rng_seed;
+	uint64_t rng;
+} _noise_bank_header;
+
+// Size in bytes of the data of a bank, or SIZE_MAX if it would overflow
+static size_t _noise_bank_data_size(uint64_t N, uint64_t M, uint64_t ensemble_size) {
+	const size_t max = SIZE_MAX/sizeof(double);
+	if (N >= max || (M != 0 && ensemble_size > max/M)
+			|| (ensemble_size*M != 0 && N+1 > max/(ensemble_size*M))) {
+		return SIZE_MAX;
+	}
+	return (size_t)(ensemble_size*M*(N+1))*sizeof(double);
+}
+
+// Allocate a bank and memory for its data
+static emd_noise_bank* _allocate_noise_bank(size_t N, size_t M, unsigned int ensemble_size) {
+	emd_noise_bank* bank = malloc(sizeof(emd_noise_bank));
+	if (bank == NULL) {
+		return NULL;
+	}
+	bank->N = N;
+	bank->M = M;
+	bank->ensemble_size = ensemble_size;
+	bank->storage_size = _noise_bank_data_size(N, M, ensemble_size);
+	bank->storage = malloc(bank->storage_size);
+	bank->mapped = false;
+	if (bank->storage == NULL && bank->storage_size != 0) {
+		free(bank);
+		return NULL;
+	}
+	bank->modes = bank->storage;
+	bank->sds = bank->modes + ensemble_size*M*N;
+	return bank;
+}
+
+emd_noise_bank* emd_noise_bank_create(size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed, emd_rng_type rng,
+		unsigned int num_threads) {
+	gsl_set_error_handler_off();
+	if (ensemble_size < 1 || (S_number == 0 && num_siftings == 0)
+			|| N > EEMD_MAX_KNOT_N) {
+		return NULL;
+	}
+	if (rng != EMD_RNG_PHILOX && rng != EMD_RNG_MT19937) {
+		return NULL;
+	}
+	if (M == 0) {
+		M = emd_num_imfs(N);
+	}
+	#ifdef _OPENMP
+	if (num_threads == 0) {
+		num_threads = _default_num_threads(EMD_THREADS_OPENMP);
+	}
+	if (num_threads > ensemble_size) {
+		num_threads = ensemble_size;
+	}
+	#else
+	num_threads = 1;
+	#endif
+	emd_noise_bank* bank = _allocate_noise_bank(N, M, ensemble_size);
+	if (bank == NULL) {
+		return NULL;
+	}
+	bank->S_number = S_number;
+	bank->num_siftings = num_siftings;
+	bank->rng_seed = rng_seed;
+	bank->rng = rng;
+	double* const modes = bank->storage;
+	double* const sds = modes + ensemble_size*M*N;
+	eemd_workspace** ws = malloc(num_threads*sizeof(eemd_workspace*));
+	if (ws == NULL) {
+		emd_noise_bank_destroy(bank);
+		return NULL;
+	}
+	for (unsigned int t=0; t<num_threads; t++) {
+		ws[t] = allocate_eemd_workspace(N, rng);
+		if (ws[t] == NULL) {
+			for (unsigned int u=0; u<t; u++) {
+				free_eemd_workspace(ws[u]);
+			}
+			free(ws);
+			emd_noise_bank_destroy(bank);
+			return NULL;
+		}
+	}
+	libeemd_error_code emd_err = EMD_SUCCESS;
+	// Each ensemble member is computed independently, in the same way as in
+	// _ceemdan_execute
+	#pragma omp parallel num_threads(num_threads)
+	{
+		#ifdef _OPENMP
+		const int thread_id = omp_get_thread_num();
+		#else
+		const int thread_id = 0;
+		#endif
+		eemd_workspace* w = ws[thread_id];
+		double* const noise_residual = w->x;
+		unsigned int sift_counter = 0;
+		#pragma omp for schedule(dynamic)
+		for (unsigned int i=0; i<ensemble_size; i++) {
+			#pragma omp flush(emd_err)
+			if (emd_err != EMD_SUCCESS || N == 0) {
+				continue;
+			}
+			double* noise = &modes[(size_t)i*M*N];
+			_generate_noise(w, rng, rng_seed+i, 1.0, NULL, noise, N);
+			sds[(size_t)i*M] = gsl_stats_sd(noise, 1, N);
+			if (M > 1) {
+				array_copy(noise, N, noise_residual);
+			}
+			for (size_t k=1; k<M; k++) {
+				noise += N;
+				array_copy(noise_residual, N, noise);
+				const libeemd_error_code sift_err = _sift(noise, w->emd_w->sift_w,
+						S_number, num_siftings, &sift_counter);
+				if (sift_err != EMD_SUCCESS) {
+					emd_err = sift_err;
+					#pragma omp flush(emd_err)
+					break;
+				}
+				array_sub(noise, N, noise_residual);
+				sds[(size_t)i*M+k] = gsl_stats_sd(noise, 1, N);
+			}
+		}
+	}
+	for (unsigned int t=0; t<num_threads; t++) {
+		free_eemd_workspace(ws[t]);
+	}
+	free(ws);
+	if (emd_err != EMD_SUCCESS) {
+		emd_noise_bank_destroy(bank);
+		return NULL;
+	}
+	return bank;
+}
+
+libeemd_error_code emd_noise_bank_save(emd_noise_bank const* bank, char const* filename) {
+	_noise_bank_header header;
+	memcpy(header.magic, _NOISE_BANK_MAGIC, sizeof(header.magic));
+	header.byte_order = UINT64_C(0x0102030405060708);
+	header.N = bank->N;
+	header.M = bank->M;
+	header.ensemble_size = bank->ensemble_size;
+	header.S_number = bank->S_number;
+	header.num_siftings = bank->num_siftings;
+	header.rng_seed = bank->rng_seed;
+	header.rng = (uint64_t)bank->rng;
+	const size_t data_size = _noise_bank_data_size(bank->N, bank->M, bank->ensemble_size);
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL) {
+		return EMD_FILE_ERROR;
+	}
+	bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+	ok = ok && (data_size == 0 || fwrite(bank->modes, data_size, 1, file) == 1);
+	ok = (fclose(file) == 0) && ok;
+	return ok? EMD_SUCCESS : EMD_FILE_ERROR;
+}
+
+emd_noise_bank* emd_noise_bank_load(char const* filename) {
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+	_noise_bank_header header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+			|| memcmp(header.magic, _NOISE_BANK_MAGIC, sizeof(header.magic)) != 0
+			|| header.byte_order != UINT64_C(0x0102030405060708)
+			|| header.ensemble_size < 1 || header.ensemble_size > UINT_MAX
+			|| header.S_number > UINT_MAX || header.num_siftings > UINT_MAX
+			|| (header.rng != EMD_RNG_PHILOX && header.rng != EMD_RNG_MT19937)) {
+		fclose(file);
+		return NULL;
+	}
+	const size_t data_size = _noise_bank_data_size(header.N, header.M, header.ensemble_size);
+	if (data_size == SIZE_MAX) {
+		fclose(file);
+		return NULL;
+	}
+	emd_noise_bank* bank = malloc(sizeof(emd_noise_bank));
+	if (bank == NULL) {
+		fclose(file);
+		return NULL;
+	}
+	bank->N = header.N;
+	bank->M = header.M;
+	bank->ensemble_size = (unsigned int)header.ensemble_size;
+	bank->S_number = (unsigned int)header.S_number;
+	bank->num_siftings = (unsigned int)header.num_siftings;
+	bank->rng_seed = (unsigned long int)header.rng_seed;
+	bank->rng = (emd_rng_type)header.rng;
+	bank->storage = NULL;
+	bank->mapped = false;
+	#ifdef HAVE_SYS_MMAN_H
+	// Map the whole file read-only, so that the data is paged in on demand
+	// and shared between processes using the same bank. Files that are too
+	// short are read normally, which then fails.
+	bank->storage_size = sizeof(header) + data_size;
+	const int fd = open(filename, O_RDONLY);
+	struct stat file_status;
+	if (fd != -1 && data_size != 0 && fstat(fd, &file_status) == 0
+			&& (uint64_t)file_status.st_size >= (uint64_t)bank->storage_size) {
+		void* mapping = mmap(NULL, bank->storage_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapping != MAP_FAILED) {
+			bank->storage = mapping;
+			bank->mapped = true;
+			bank->modes = (double const*)((char const*)mapping + sizeof(header));
+		}
+	}
+	if (fd != -1) {
+		close(fd);
+	}
+	#endif
+	if (!bank->mapped) {
+		bank->storage_size = data_size;
+		bank->storage = malloc(data_size);
+		if ((bank->storage == NULL && data_size != 0)
+				|| (data_size != 0 && fread(bank->storage, data_size, 1, file) != 1)) {
+			free(bank->storage);
+			free(bank);
+			fclose(file);
+			return NULL;
+		}
+		bank->modes = bank->storage;
+	}
+	fclose(file);
+	bank->sds = bank->modes + bank->ensemble_size*bank->M*bank->N;
+	return bank;
+}
+
+void emd_noise_bank_destroy(emd_noise_bank* bank) {
+	if (bank == NULL) {
+		return;
+	}
+	#ifdef HAVE_SYS_MMAN_H
+	if (bank->mapped) {
+		munmap(bank->storage, bank->storage_size);
+		bank->storage = NULL;
+	}
+	#endif
+	free(bank->storage); bank->storage = NULL;
+	free(bank); bank = NULL;
+}
+
+// The input signals of a plan execution. Sample i of signal s is
+// scale*data[s*signal_stride+i*sample_stride], where data holds samples of the
+// given type, so that fixed-point or interleaved data is converted to
+// contiguous doubles only when it is read.
+typedef enum {
+	SAMPLE_DOUBLE,
+	SAMPLE_INT16,
+	SAMPLE_INT32
+} sample_type;
+
+typedef struct {
+	sample_type type;
+	void const* data;
+	size_t sample_stride;
+	size_t signal_stride;
+	double scale;
+} signal_source;
+
+// Helper function for reading sample i of signal s
+static inline double _signal_sample(signal_source const* restrict src,
+		size_t s, size_t i) {
+	const size_t k = s*src->signal_stride + i*src->sample_stride;
+	switch (src->type) {
+		case SAMPLE_INT16:
+			return src->scale*((int16_t const*)src->data)[k];
+		case SAMPLE_INT32:
+			return src->scale*((int32_t const*)src->data)[k];
+		default:
+			return ((double const*)src->data)[k];
+	}
+}
+
+// Helper function for storing the N samples of signal s to dest
+static void _load_signal(signal_source const* restrict src, size_t s,
+		size_t N, double* restrict dest) {
+	const double scale = src->scale;
+	const size_t stride = src->sample_stride;
+	if (stride != 1) {
+		for (size_t i=0; i<N; i++) {
+			dest[i] = _signal_sample(src, s, i);
+		}
+		return;
+	}
+	switch (src->type) {
+		case SAMPLE_DOUBLE:
+			array_copy((double const*)src->data + s*src->signal_stride, N, dest);
+			break;
+		case SAMPLE_INT16: {
+			int16_t const* const x = (int16_t const*)src->data + s*src->signal_stride;
+			for (size_t i=0; i<N; i++) {
+				dest[i] = scale*x[i];
+			}
+			break;
+		}
+		case SAMPLE_INT32: {
+			int32_t const* const x = (int32_t const*)src->data + s*src->signal_stride;
+			for (size_t i=0; i<N; i++) {
+				dest[i] = scale*x[i];
+			}
+			break;
+		}
+	}
+}
+
+// Helper function for computing the standard deviation of signal s. Doubles
+// are handed to gsl_stats_sd, and fixed-point samples are scaled one at a time
+// in the same algorithm as it uses.
+static double _signal_sd(signal_source const* restrict src, size_t s,
+		size_t N) {
+	if (src->type == SAMPLE_DOUBLE) {
+		return gsl_stats_sd((double const*)src->data + s*src->signal_stride,
+				src->sample_stride, N);
+	}
+	long double running_mean = 0;
+	for (size_t i=0; i<N; i++) {
+		running_mean += (_signal_sample(src, s, i) - running_mean)/(i+1);
+	}
+	const double mean = (double)running_mean;
+	long double running_variance = 0;
+	for (size_t i=0; i<N; i++) {
+		const long double delta = _signal_sample(src, s, i) - mean;
+		running_variance += (delta*delta - running_variance)/(i+1);
+	}
+	const double variance = (double)running_variance;
+	return sqrt(variance*((double)N/(double)(N-1)));
+}
+
+// Helper function for initializing an ensemble member as signal s plus the
+// noise of the given stream. Samples that are not contiguous doubles are
+// first converted to the residual array of the workspace, which _emd
+// overwrites anyway, so that _generate_noise always gets the signal as its
+// base and the results are the same for all input types and layouts.
+static void _noisy_signal(eemd_workspace* restrict w, emd_rng_type rng,
+		unsigned long int stream, double sigma, signal_source const* restrict src,
+		size_t s, double* restrict out, size_t N) {
+	double const* base = (double const*)src->data + s*src->signal_stride;
+	if (src->type != SAMPLE_DOUBLE || src->sample_stride != 1) {
+		_load_signal(src, s, N, w->emd_w->res);
+		base = w->emd_w->res;
+	}
+	_generate_noise(w, rng, stream, sigma, base, out, N);
+}
+
+// Forward declarations of the routines doing the actual work when a plan is
+// executed
+static libeemd_error_code _eemd_execute(emd_plan* restrict plan,
+		signal_source const* restrict input, size_t num_signals,
+		double* restrict output, size_t output_stride, imf_layout layout,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed);
+static libeemd_error_code _ceemdan_execute(emd_plan* restrict plan,
+		signal_source const* restrict input, size_t num_signals,
+		double* restrict output, size_t output_stride, imf_layout layout,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed,
+		emd_noise_bank const* restrict bank);
+
+// Helper function for validating the parameters and executing a plan for
+// double precision with any type of input samples
+static libeemd_error_code _execute_plan(emd_plan* plan,
+		signal_source const* restrict input, size_t num_signals,
+		double* restrict output, size_t output_stride, imf_layout layout,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	gsl_set_error_handler_off();
+	if (plan->precision != EMD_PRECISION_DOUBLE) {
+		return EMD_PRECISION_MISMATCH;
+	}
+	// Validate parameters
+	libeemd_error_code validation_result = _validate_eemd_parameters(plan->ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	// For empty data we have nothing to do
+	if (plan->N == 0 || num_signals == 0) {
+		return EMD_SUCCESS;
+	}
+	if (plan->variant == EMD_VARIANT_CEEMDAN) {
+		return _ceemdan_execute(plan, input, num_signals, output,
+				output_stride, layout, noise_strength, S_number, num_siftings,
+				rng_seed, NULL);
+	}
+	return _eemd_execute(plan, input, num_signals, output,
+			output_stride, layout, noise_strength, S_number, num_siftings,
+			rng_seed);
+}
+
+libeemd_error_code emd_plan_execute(emd_plan* plan,
+		double const* restrict input, double* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	return emd_plan_execute_batch(plan, input, 1, plan->N, output,
+			plan->M*plan->N, noise_strength, S_number, num_siftings, rng_seed);
+}
+
+libeemd_error_code emd_plan_execute_batch(emd_plan* plan,
+		double const* restrict input, size_t num_signals, size_t input_stride,
+		double* restrict output, size_t output_stride,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	const signal_source src = {SAMPLE_DOUBLE, input, 1, input_stride, 1.0};
+	const imf_layout layout = {plan->N, 1};
+	return _execute_plan(plan, &src, num_signals, output, output_stride,
+			layout, noise_strength, S_number, num_siftings, rng_seed);
+}
+
+libeemd_error_code emd_plan_execute_strided(emd_plan* plan,
+		double const* restrict input, emd_input_layout const* input_layout,
+		size_t num_signals, double* restrict output,
+		emd_output_layout const* output_layout, double noise_strength,
+		unsigned int S_number, unsigned int num_siftings,
+		unsigned long int rng_seed) {
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	signal_source src = {SAMPLE_DOUBLE, input, 1, N, 1.0};
+	if (input_layout != NULL) {
+		src.sample_stride = input_layout->sample_stride;
+		src.signal_stride = input_layout->signal_stride;
+	}
+	imf_layout layout = {N, 1};
+	size_t output_stride = M*N;
+	if (output_layout != NULL) {
+		layout.imf_stride = output_layout->imf_stride;
+		layout.sample_stride = output_layout->sample_stride;
+		output_stride = output_layout->signal_stride;
+	}
+	return _execute_plan(plan, &src, num_signals, output, output_stride,
+			layout, noise_strength, S_number, num_siftings, rng_seed);
+}
+
+libeemd_error_code emd_plan_execute_int16(emd_plan* plan,
+		int16_t const* restrict input, double scale, double* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	const signal_source src = {SAMPLE_INT16, input, 1, plan->N, scale};
+	const imf_layout layout = {plan->N, 1};
+	return _execute_plan(plan, &src, 1, output, plan->M*plan->N, layout,
+			noise_strength, S_number, num_siftings, rng_seed);
+}
+
+libeemd_error_code emd_plan_execute_int32(emd_plan* plan,
+		int32_t const* restrict input, double scale, double* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	const signal_source src = {SAMPLE_INT32, input, 1, plan->N, scale};
+	const imf_layout layout = {plan->N, 1};
+	return _execute_plan(plan, &src, 1, output, plan->M*plan->N, layout,
+			noise_strength, S_number, num_siftings, rng_seed);
+}
+
+libeemd_error_code emd_plan_execute_with_noise_bank(emd_plan* plan,
+		emd_noise_bank const* bank, double const* restrict input,
+		double* restrict output, double noise_strength) {
+	return emd_plan_execute_batch_with_noise_bank(plan, bank, input, 1, plan->N,
+			output, plan->M*plan->N, noise_strength);
+}
+
+libeemd_error_code emd_plan_execute_batch_with_noise_bank(emd_plan* plan,
+		emd_noise_bank const* bank, double const* restrict input,
+		size_t num_signals, size_t input_stride, double* restrict output,
+		size_t output_stride, double noise_strength) {
+	gsl_set_error_handler_off();
+	if (plan->precision != EMD_PRECISION_DOUBLE) {
+		return EMD_PRECISION_MISMATCH;
+	}
+	if (plan->variant != EMD_VARIANT_CEEMDAN || bank->N != plan->N
+			|| bank->M < plan->M || bank->ensemble_size != plan->ensemble_size) {
+		return EMD_INCOMPATIBLE_NOISE_BANK;
+	}
+	// Validate parameters
+	libeemd_error_code validation_result = _validate_eemd_parameters(plan->ensemble_size,
+			noise_strength, bank->S_number, bank->num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	// For empty data we have nothing to do
+	if (plan->N == 0 || num_signals == 0) {
+		return EMD_SUCCESS;
+	}
+	const signal_source src = {SAMPLE_DOUBLE, input, 1, input_stride, 1.0};
+	const imf_layout layout = {plan->N, 1};
+	return _ceemdan_execute(plan, &src, num_signals, output,
+			output_stride, layout, noise_strength, bank->S_number, bank->num_siftings,
+			bank->rng_seed, bank);
+}
+
+// Main EEMD decomposition routine definition
+libeemd_error_code eemd(double const* restrict input, size_t N,
+		double* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	// Validate parameters
+	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	// For empty data we have nothing to do
+	if (N == 0) {
+		return EMD_SUCCESS;
+	}
+	emd_plan* plan = _create_routine_plan(EMD_VARIANT_EEMD, N, M, ensemble_size, 0,
+			EMD_PRECISION_DOUBLE);
+	if (plan == NULL) {
+		return _plan_creation_error(N);
+	}
+	libeemd_error_code err = emd_plan_execute(plan, input, output, noise_strength, S_number, num_siftings, rng_seed);
+	emd_plan_destroy(plan);
+	return err;
+}
+
+// Batch EEMD routine definition
+libeemd_error_code eemd_batch(double const* restrict input, size_t
+		num_signals, size_t input_stride, size_t N,
+		double* restrict output, size_t output_stride, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	// Validate parameters
+	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	// For empty data we have nothing to do
+	if (N == 0 || num_signals == 0) {
+		return EMD_SUCCESS;
+	}
+	emd_plan* plan = _create_routine_plan(EMD_VARIANT_EEMD, N, M, ensemble_size,
+			_default_num_threads(default_threading), EMD_PRECISION_DOUBLE);
+	if (plan == NULL) {
+		return _plan_creation_error(N);
+	}
+	libeemd_error_code err = emd_plan_execute_batch(plan, input, num_signals, input_stride, output, output_stride, noise_strength, S_number, num_siftings, rng_seed);
+	emd_plan_destroy(plan);
+	return err;
+}
+
+// Helper function for adding a private accumulation buffer to an output
+// matrix, row by row using the locks for that matrix. The buffer is zeroed
+// afterwards so that it can be used again.
+static void _flush_accumulator(emd_plan const* restrict plan, double* restrict acc,
+		double* restrict output, imf_layout layout, lock* locks) {
+	const size_t N = plan->N;
+	for (size_t imf_i=0; imf_i<plan->M; imf_i++) {
+		get_lock(&locks[imf_i]);
+		imf_add(acc+N*imf_i, N, output, layout, imf_i, 0);
+		release_lock(&locks[imf_i]);
+	}
+	memset(acc, 0x00, plan->M*N*sizeof(double));
+}
+
+// Helper function for summing num_buffers matrices of M IMFs of length N to
+// output with a pairwise tree reduction. This is called by all threads of a
+// parallel region, which divide the matrices into blocks so that each block
+// is reduced by a single thread.
+static void _tree_reduce(double* const* buffers, unsigned int num_buffers,
+		size_t N, size_t M, double* restrict output, imf_layout layout) {
+	const size_t n = M*N;
+	const size_t block_size = 4096;
+	const size_t num_blocks = (n + block_size - 1)/block_size;
+	#pragma omp for
+	for (size_t b=0; b<num_blocks; b++) {
+		const size_t start = b*block_size;
+		const size_t len = (n-start < block_size)? n-start : block_size;
+		for (unsigned int stride=1; stride<num_buffers; stride*=2) {
+			for (unsigned int t=0; t+stride<num_buffers; t+=2*stride) {
+				array_add(buffers[t+stride]+start, len, buffers[t]+start);
+			}
+		}
+		// Copy the block to the output one IMF at a time
+		for (size_t k=start; k<start+len; ) {
+			const size_t m = k/N;
+			const size_t j = k%N;
+			const size_t count = (start+len-k < N-j)? start+len-k : N-j;
+			imf_copy(buffers[0]+k, count, output, layout, m, j);
+			k += count;
+		}
+	}
+}
+
+// Sums over the threads or NUMA nodes are divided among the threads in blocks
+// of this many samples
+static const size_t sum_block_size = 4096;
+
+// The parameters of an EEMD execution shared by all ensemble members
+typedef struct {
+	emd_plan* plan;
+	signal_source const* input;
+	double* output;
+	size_t output_stride;
+	imf_layout layout;
+	double noise_strength;
+	unsigned int S_number;
+	unsigned int num_siftings;
+	unsigned long int rng_seed;
+} eemd_job;
+
+static void _eemd_thread_state_init(eemd_thread_state* restrict st,
+		emd_plan const* restrict plan, unsigned int thread_id) {
+	st->acc = (thread_id < plan->num_accumulators)? plan->accumulators[thread_id] : NULL;
+	st->acc_signal = (size_t)(-1);
+	st->acc_count = 0;
+	st->sigma_signal = (size_t)(-1);
+	st->noise_sigma = 0;
+	if (st->acc != NULL) {
+		memset(st->acc, 0x00, plan->M*plan->N*sizeof(double));
+	}
+}
+
+// Helper function for initializing work item 'item' (a pair of a signal and
+// an ensemble member) to ensemble member x of workspace w as input data +
+// noise
+static void _eemd_member_input(eemd_job const* restrict job,
+		eemd_workspace* restrict w, eemd_thread_state* restrict st,
+		size_t item, double* restrict x) {
+	emd_plan const* const plan = job->plan;
+	const size_t N = plan->N;
+	const size_t s = item/plan->ensemble_size;
+	if (job->noise_strength == 0.0) {
+		_load_signal(job->input, s, N, x);
+	}
+	else {
+		// The noise standard deviation is noise_strength times the
+		// standard deviation of input data
+		if (st->sigma_signal != s) {
+			st->noise_sigma = _signal_sd(job->input, s, N)*job->noise_strength;
+			st->sigma_signal = s;
+		}
+		// The random stream depends on the signal and ensemble member
+		// to ensure reproducibility even in a multithreaded case
+		_noisy_signal(w, plan->rng, job->rng_seed+item, st->noise_sigma,
+				job->input, s, x, N);
+	}
+}
+
+// Helper function for extracting the IMFs of one work item with the
+// workspace w, either to the private buffer of the thread or directly to the
+// output matrix using the locks reserved for its signal
+static libeemd_error_code _eemd_member(eemd_job const* restrict job,
+		eemd_workspace* restrict w, eemd_thread_state* restrict st,
+		size_t item) {
+	emd_plan const* const plan = job->plan;
+	const size_t M = plan->M;
+	const size_t s = item/plan->ensemble_size;
+	_eemd_member_input(job, w, st, item, w->x);
+	double* target = job->output+s*job->output_stride;
+	imf_layout target_layout = job->layout;
+	if (st->acc != NULL) {
+		if (st->acc_count > 0 && (st->acc_signal != s ||
+					(plan->flush_interval != 0 && st->acc_count >= plan->flush_interval))) {
+			_flush_accumulator(plan, st->acc, job->output+st->acc_signal*job->output_stride,
+					job->layout, &plan->locks[(st->acc_signal%plan->num_lock_sets)*M]);
+			st->acc_count = 0;
+		}
+		st->acc_signal = s;
+		target = st->acc;
+		target_layout = (imf_layout){plan->N, 1};
+		w->emd_w->locks = NULL;
+	}
+	else {
+		w->emd_w->locks = &plan->locks[(s%plan->num_lock_sets)*M];
+	}
+	const libeemd_error_code err = _emd(w->x, w->emd_w, target, target_layout,
+			M, job->S_number, job->num_siftings);
+	if (st->acc != NULL) {
+		st->acc_count++;
+	}
+	return err;
+}
+
+// Helper function for flushing what is left in the private buffer of a
+// thread when the work is done
+static void _eemd_flush_thread_state(eemd_job const* restrict job,
+		eemd_thread_state* restrict st) {
+	emd_plan const* const plan = job->plan;
+	if (st->acc_count > 0) {
+		_flush_accumulator(plan, st->acc, job->output+st->acc_signal*job->output_stride,
+				job->layout, &plan->locks[(st->acc_signal%plan->num_lock_sets)*plan->M]);
+		st->acc_count = 0;
+	}
+}
+
+#if EEMD_THREAD_POOL
+static libeemd_error_code _eemd_execute_pool(eemd_job const* restrict job,
+		size_t num_signals);
+#endif
+
+static libeemd_error_code _eemd_execute(emd_plan* restrict plan,
+		signal_source const* restrict input, size_t num_signals,
+		double* restrict output, size_t output_stride, imf_layout layout,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	const eemd_job job = {plan, input, output, output_stride, layout,
+		noise_strength, S_number, num_siftings, rng_seed};
+	#if EEMD_THREAD_POOL
+	if (plan->pool != NULL) {
+		return _eemd_execute_pool(&job, num_signals);
+	}
+	#endif
+	// Provide some shorthands to avoid excessive '->' operators
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	const unsigned int ensemble_size = plan->ensemble_size;
+	// Each pair of a signal and an ensemble member is a separate work item
+	const size_t num_items = num_signals*ensemble_size;
+	unsigned int ensemble_counter = 0;
+	// The following section is executed in parallel
+	libeemd_error_code emd_err = EMD_SUCCESS;
+	#pragma omp parallel num_threads(plan->num_threads)
+	{
+		#ifdef _OPENMP
+		const int thread_id = omp_get_thread_num();
+		#if EEMD_DEBUG >= 1
+		#pragma omp single nowait
+		fprintf(stderr, "Using %d thread(s) with OpenMP.\n", omp_get_num_threads());
+		#endif
+		#else
+		const int thread_id = 0;
+		#endif
+		// Each thread has its own workspace in the plan
+		eemd_workspace* w = plan->ws[thread_id];
+		#ifdef _OPENMP
+		const unsigned int team_size = (unsigned int)omp_get_num_threads();
+		#else
+		const unsigned int team_size = 1;
+		#endif
+		// Threads with a private accumulation buffer sum their ensemble
+		// members there. The buffer is flushed to the output matrix of the
+		// signal it belongs to when the thread moves to another signal, after
+		// flush_interval members (if nonzero), and when the work is done. If
+		// all threads have a buffer and there is only one signal, the buffers
+		// are instead summed together with a parallel tree reduction.
+		eemd_thread_state st;
+		_eemd_thread_state_init(&st, plan, (unsigned int)thread_id);
+		// If there are at most half as many work items as threads and the
+		// signals are long enough, the whole team sifts one ensemble member
+		// at a time, and adds it directly to the output matrix.
+		const bool team_sift = (plan->sift_team != NULL && 2*num_items <= team_size);
+		const bool tree_reduction = (num_signals == 1 && plan->flush_interval == 0
+				&& plan->num_accumulators >= team_size && !team_sift);
+		// Initialize output data to zero
+		#pragma omp for
+		for (size_t s=0; s<num_signals; s++) {
+			imfs_zero(output+s*output_stride, N, M, layout);
+		}
+		if (team_sift) {
+			eemd_workspace* const team_w = plan->ws[0];
+			for (size_t item=0; item<num_items; item++) {
+				const size_t s = item/ensemble_size;
+				#pragma omp single
+				_eemd_member_input(&job, team_w, &st, item, team_w->x);
+				const libeemd_error_code err = _emd_team(team_w->x, team_w->emd_w->res,
+						plan->sift_team, output+s*output_stride, layout, M, S_number,
+						num_siftings);
+				// All threads get the same error code
+				if (err != EMD_SUCCESS) {
+					#pragma omp single
+					emd_err = err;
+					break;
+				}
+			}
+		}
+		// Otherwise loop over all work items, dividing them among the threads
+		const size_t num_shared_items = team_sift? 0 : num_items;
+		#pragma omp for schedule(dynamic) nowait
+		for (size_t item=0; item<num_shared_items; item++) {
+			// Check if an error has occured in other threads
+			#pragma omp flush(emd_err)
+			if (emd_err != EMD_SUCCESS) {
+				continue;
+			}
+			const libeemd_error_code member_err = _eemd_member(&job, w, &st, item);
+			if (member_err != EMD_SUCCESS) {
+				emd_err = member_err;
+				#pragma omp flush(emd_err)
+			}
+			#pragma omp atomic
+			ensemble_counter++;
+			#if EEMD_DEBUG >= 1
+			fprintf(stderr, "Ensemble iteration %u/%zu done.\n", ensemble_counter, num_items);
+			#endif
+		}
+		if (!tree_reduction) {
+			_eemd_flush_thread_state(&job, &st);
+		}
+		#pragma omp barrier
+		if (tree_reduction && emd_err == EMD_SUCCESS) {
+			_tree_reduce(plan->accumulators, team_size, N, M, output, layout);
+		}
+		// Divide output data by the ensemble size to get the average
+		if (ensemble_size != 1 && emd_err == EMD_SUCCESS) {
+			const double one_per_ensemble_size = 1.0/ensemble_size;
+			#pragma omp for
+			for (size_t s=0; s<num_signals; s++) {
+				imfs_mult(output+s*output_stride, N, M, layout, one_per_ensemble_size);
+			}
+		}
+	} // End of parallel block
+	return emd_err;
+}
+
+#if EEMD_THREAD_POOL
+// EEMD with the thread pool. Each step of _eemd_execute is a loop run by the
+// pool, with the members summed to the private buffers of the workers, which
+// are then flushed to the output matrices under the locks.
+typedef struct {
+	eemd_job const* job;
+	libeemd_error_code err;
+} eemd_pool_context;
+
+static void _eemd_pool_init(void* context, __attribute__((unused)) unsigned int worker,
+		size_t item) {
+	eemd_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	if (item < plan->num_threads) {
+		_eemd_thread_state_init(&plan->pool_states[item], plan, (unsigned int)item);
+	}
+	else {
+		const size_t s = item - plan->num_threads;
+		imfs_zero(ctx->job->output+s*ctx->job->output_stride, plan->N, plan->M,
+				ctx->job->layout);
+	}
+}
+
+static void _eemd_pool_member(void* context, unsigned int worker, size_t item) {
+	eemd_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	if (__atomic_load_n(&ctx->err, __ATOMIC_RELAXED) != EMD_SUCCESS) {
+		return;
+	}
+	const libeemd_error_code err = _eemd_member(ctx->job, plan->ws[worker],
+			&plan->pool_states[worker], item);
+	if (err != EMD_SUCCESS) {
+		__atomic_store_n(&ctx->err, err, __ATOMIC_RELAXED);
+	}
+}
+
+static void _eemd_pool_flush(void* context, __attribute__((unused)) unsigned int worker,
+		size_t item) {
+	eemd_pool_context* const ctx = context;
+	_eemd_flush_thread_state(ctx->job, &ctx->job->plan->pool_states[item]);
+}
+
+// Flushing the private buffer of the worker to the summation buffer of its
+// node instead of the output matrix
+static void _eemd_pool_flush_to_node(void* context, unsigned int worker,
+		__attribute__((unused)) size_t item) {
+	eemd_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	eemd_thread_state* const st = &plan->pool_states[worker];
+	const unsigned int node = plan->worker_nodes[worker];
+	if (st->acc_count > 0) {
+		_flush_accumulator(plan, st->acc, plan->node_sums[node], (imf_layout){plan->N, 1},
+				&plan->node_locks[node*plan->M]);
+		st->acc_count = 0;
+	}
+}
+
+// Adding block k of the summation buffers of all nodes to the output matrix
+// of the single signal, and clearing them for the next execution
+static void _eemd_pool_reduce_nodes(void* context,
+		__attribute__((unused)) unsigned int worker, size_t k) {
+	eemd_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	const size_t N = plan->N;
+	const size_t num_blocks = (N + sum_block_size - 1)/sum_block_size;
+	const size_t imf_i = k/num_blocks;
+	const size_t start = (k%num_blocks)*sum_block_size;
+	const size_t n = (N-start < sum_block_size)? N-start : sum_block_size;
+	for (unsigned int node=0; node<plan->num_nodes; node++) {
+		double* const sum = plan->node_sums[node]+imf_i*N+start;
+		imf_add(sum, n, ctx->job->output, ctx->job->layout, imf_i, start);
+		memset(sum, 0x00, n*sizeof(double));
+	}
+}
+
+static void _eemd_pool_average(void* context, __attribute__((unused)) unsigned int worker,
+		size_t s) {
+	eemd_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	imfs_mult(ctx->job->output+s*ctx->job->output_stride, plan->N, plan->M,
+			ctx->job->layout, 1.0/plan->ensemble_size);
+}
+
+static libeemd_error_code _eemd_execute_pool(eemd_job const* restrict job,
+		size_t num_signals) {
+	emd_plan* const plan = job->plan;
+	thread_pool* const pool = plan->pool;
+	eemd_pool_context ctx = {job, EMD_SUCCESS};
+	_pool_enter(pool);
+	_pool_run(pool, plan->num_threads+num_signals, _eemd_pool_init, &ctx);
+	_pool_run(pool, num_signals*plan->ensemble_size, _eemd_pool_member, &ctx);
+	if (plan->node_sums != NULL && num_signals == 1) {
+		const size_t num_blocks = (plan->N + sum_block_size - 1)/sum_block_size;
+		_pool_run_each(pool, _eemd_pool_flush_to_node, &ctx);
+		_pool_run(pool, plan->M*num_blocks, _eemd_pool_reduce_nodes, &ctx);
+	}
+	else {
+		_pool_run(pool, plan->num_threads, _eemd_pool_flush, &ctx);
+	}
+	if (plan->ensemble_size != 1 && ctx.err == EMD_SUCCESS) {
+		_pool_run(pool, num_signals, _eemd_pool_average, &ctx);
+	}
+	_pool_leave(pool);
+	return ctx.err;
+}
+#endif
+
+// Main CEEMDAN decomposition routine definition
+libeemd_error_code ceemdan(double const* restrict input, size_t N,
+		double* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	// Validate parameters
+	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	// For empty data we have nothing to do
+	if (N == 0) {
+		return EMD_SUCCESS;
+	}
+	emd_plan* plan = _create_routine_plan(EMD_VARIANT_CEEMDAN, N, M, ensemble_size, 0,
+			EMD_PRECISION_DOUBLE);
+	if (plan == NULL) {
+		return _plan_creation_error(N);
+	}
+	libeemd_error_code err = emd_plan_execute(plan, input, output, noise_strength, S_number, num_siftings, rng_seed);
+	emd_plan_destroy(plan);
+	return err;
+}
+
+// Batch CEEMDAN routine definition
+libeemd_error_code ceemdan_batch(double const* restrict input, size_t
+		num_signals, size_t input_stride, size_t N,
+		double* restrict output, size_t output_stride, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	// Validate parameters
+	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	// For empty data we have nothing to do
+	if (N == 0 || num_signals == 0) {
+		return EMD_SUCCESS;
+	}
+	emd_plan* plan = _create_routine_plan(EMD_VARIANT_CEEMDAN, N, M, ensemble_size,
+			_default_num_threads(default_threading), EMD_PRECISION_DOUBLE);
+	if (plan == NULL) {
+		return _plan_creation_error(N);
+	}
+	libeemd_error_code err = emd_plan_execute_batch(plan, input, num_signals, input_stride, output, output_stride, noise_strength, S_number, num_siftings, rng_seed);
+	emd_plan_destroy(plan);
+	return err;
+}
+
+// Reconstruct the noise used by a CEEMDAN ensemble member for mode imf_i,
+// and the residual of that noise, by regenerating the white noise and sifting
+// it exactly as is done for members whose noise is kept in memory
+static libeemd_error_code _ceemdan_regenerate_noise(eemd_workspace* restrict w,
+		emd_rng_type rng, unsigned long int stream, size_t imf_i,
+		double* restrict noise, double* restrict noise_residual,
+		unsigned int S_number, unsigned int num_siftings,
+		unsigned int* sift_counter) {
+	const size_t N = w->N;
+	_generate_noise(w, rng, stream, 1.0, NULL, noise, N);
+	if (imf_i > 0) {
+		array_copy(noise, N, noise_residual);
+	}
+	for (size_t j=0; j<imf_i; j++) {
+		array_copy(noise_residual, N, noise);
+		const libeemd_error_code sift_err = _sift(noise, w->emd_w->sift_w,
+				S_number, num_siftings, sift_counter);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		array_sub(noise, N, noise_residual);
+	}
+	return EMD_SUCCESS;
+}
+
+// Same as _ceemdan_regenerate_noise, but called by all threads of a team for
+// sifting the noise together. The noise and its residual must be shared by the
+// team.
+static libeemd_error_code _ceemdan_regenerate_noise_team(eemd_workspace* restrict w,
+		sifting_team* restrict team, emd_rng_type rng, unsigned long int stream,
+		size_t imf_i, double* restrict noise, double* restrict noise_residual,
+		unsigned int S_number, unsigned int num_siftings,
+		unsigned int* sift_counter) {
+	const size_t N = w->N;
+	const size_t num_chunks = _sifting_team_num_chunks(team);
+	#pragma omp single
+	_generate_noise(w, rng, stream, 1.0, NULL, noise, N);
+	for (size_t j=0; j<imf_i; j++) {
+		#pragma omp for schedule(static)
+		for (size_t c=0; c<num_chunks; c++) {
+			const size_t start = _chunk_start(N, num_chunks, c);
+			const size_t n = _chunk_start(N, num_chunks, c+1) - start;
+			if (j == 0) {
+				array_copy(noise+start, n, noise_residual+start);
+			}
+			else {
+				array_copy(noise_residual+start, n, noise+start);
+			}
+		}
+		const libeemd_error_code sift_err = _sift_team(noise, team, S_number,
+				num_siftings, sift_counter);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		#pragma omp for schedule(static)
+		for (size_t c=0; c<num_chunks; c++) {
+			const size_t start = _chunk_start(N, num_chunks, c);
+			const size_t n = _chunk_start(N, num_chunks, c+1) - start;
+			array_sub(noise+start, n, noise_residual+start);
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+// The parameters of a CEEMDAN execution shared by all ensemble members
+typedef struct {
+	emd_plan* plan;
+	signal_source const* input;
+	double* output;
+	size_t output_stride;
+	imf_layout layout;
+	double noise_strength;
+	unsigned int S_number;
+	unsigned int num_siftings;
+	unsigned long int rng_seed;
+	emd_noise_bank const* bank;
+} ceemdan_job;
+
+// Helper function for extracting mode imf_i of work item 'item' (a pair of a
+// signal in the group starting at group_start and an ensemble member) with
+// the workspace w, and adding it to the partial IMFs of the thread. If the
+// noise of the member is not stored, it is reconstructed to scratch.
+static libeemd_error_code _ceemdan_member(ceemdan_job const* restrict job,
+		eemd_workspace* restrict w, double* restrict partial_imfs,
+		double* restrict scratch, size_t group_start, size_t num_resident,
+		size_t imf_i, size_t item) {
+	emd_plan const* const plan = job->plan;
+	emd_noise_bank const* const bank = job->bank;
+	const size_t N = plan->N;
+	const unsigned int ensemble_size = plan->ensemble_size;
+	const size_t g = item/ensemble_size;
+	double const* const res = &plan->res[N*g];
+	unsigned int sift_counter = 0;
+	// Provide a pointer to the noise used by this ensemble member for this
+	// mode. If it is not stored, it is reconstructed. A noise bank has all the
+	// modes precomputed, and the same noise is used for all signals.
+	double const* mode_noise;
+	libeemd_error_code sift_err = EMD_SUCCESS;
+	if (bank != NULL) {
+		mode_noise = &bank->modes[N*((item%ensemble_size)*bank->M+imf_i)];
+	}
+	else if (item < num_resident) {
+		mode_noise = &plan->noises[N*(2*item+imf_i%2)];
+	}
+	else {
+		sift_err = _ceemdan_regenerate_noise(w, plan->rng,
+				job->rng_seed+group_start*ensemble_size+item, imf_i,
+				scratch, scratch+N, job->S_number, job->num_siftings, &sift_counter);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		mode_noise = scratch;
+	}
+	// Initialize input signal as data + noise. The noise standard deviation
+	// is noise_strength times the standard deviation of input data divided by
+	// the standard deviation of the noise. This is used to fix the SNR at each
+	// stage.
+	const double noise_sd = (bank != NULL)?
+		bank->sds[(item%ensemble_size)*bank->M+imf_i] : gsl_stats_sd(mode_noise, 1, N);
+	const double noise_sigma = (noise_sd != 0)? job->noise_strength*plan->res_sd[g]/noise_sd : 0;
+	array_addmul_to(res, mode_noise, noise_sigma, N, w->x);
+	// Sift to extract first EMD mode
+	sift_err = _sift(w->x, w->emd_w->sift_w, job->S_number, job->num_siftings, &sift_counter);
+	// Sum to this thread's partial IMF
+	array_add(w->x, N, &partial_imfs[N*g]);
+	return sift_err;
+}
+
+// Helper function for extracting the next EMD mode of the stored noise of
+// ensemble member 'item' to its other slot with the workspace w
+static libeemd_error_code _ceemdan_next_noise(ceemdan_job const* restrict job,
+		eemd_workspace* restrict w, size_t imf_i, size_t item) {
+	emd_plan const* const plan = job->plan;
+	const size_t N = plan->N;
+	double* const noise = &plan->noises[N*(2*item+imf_i%2)];
+	double* const next_noise = &plan->noises[N*(2*item+(imf_i+1)%2)];
+	double* const noise_residual = &plan->noise_residuals[N*item];
+	unsigned int sift_counter = 0;
+	if (imf_i == 0) {
+		array_copy(noise, N, noise_residual);
+	}
+	array_copy(noise_residual, N, next_noise);
+	const libeemd_error_code sift_err = _sift(next_noise, w->emd_w->sift_w,
+			job->S_number, job->num_siftings, &sift_counter);
+	array_sub(next_noise, N, noise_residual);
+	return sift_err;
+}
+
+// Helper function for summing block k of the first num_partials partial IMFs
+// (of threads, or of blocks of members with the pool) for the group starting
+// at group_start, dividing it by the ensemble size to get the average, and
+// subtracting it from the previous residual to form the new one
+static void _ceemdan_average_block(ceemdan_job const* restrict job,
+		unsigned int num_partials, size_t group_start, size_t imf_i, size_t k) {
+	emd_plan const* const plan = job->plan;
+	const size_t N = plan->N;
+	const imf_layout layout = job->layout;
+	const double one_per_ensemble_size = 1.0/plan->ensemble_size;
+	const size_t num_blocks = (N + sum_block_size - 1)/sum_block_size;
+	const size_t g = k/num_blocks;
+	const size_t start = (k%num_blocks)*sum_block_size;
+	const size_t n = (N-start < sum_block_size)? N-start : sum_block_size;
+	double* const imf = job->output+(group_start+g)*job->output_stride
+		+imf_i*layout.imf_stride+start*layout.sample_stride;
+	if (layout.sample_stride == 1) {
+		for (unsigned int t=0; t<num_partials; t++) {
+			array_add(&plan->partial_imfs[t][N*g+start], n, imf);
+		}
+		array_mult(imf, n, one_per_ensemble_size);
+		array_sub(imf, n, &plan->res[N*g+start]);
+	}
+	else {
+		// The same operations in the same order one sample at a time
+		for (size_t i=0; i<n; i++) {
+			double value = imf[i*layout.sample_stride];
+			for (unsigned int t=0; t<num_partials; t++) {
+				value += plan->partial_imfs[t][N*g+start+i];
+			}
+			value *= one_per_ensemble_size;
+			imf[i*layout.sample_stride] = value;
+			plan->res[N*g+start+i] -= value;
+		}
+	}
+}
+
+#if EEMD_THREAD_POOL
+static libeemd_error_code _ceemdan_execute_pool(ceemdan_job const* restrict job,
+		size_t num_signals);
+#endif
+
+static libeemd_error_code _ceemdan_execute(emd_plan* restrict plan,
+		signal_source const* restrict input, size_t num_signals,
+		double* restrict output, size_t output_stride, imf_layout layout,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed,
+		emd_noise_bank const* restrict bank) {
+	// Provide some shorthands to avoid excessive '->' operators
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	const unsigned int ensemble_size = plan->ensemble_size;
+	double* const noises = plan->noises;
+	double* const noise_residuals = plan->noise_residuals;
+	// For M == 1 the only "IMF" is the residual
+	if (M == 1) {
+		for (size_t s=0; s<num_signals; s++) {
+			for (size_t j=0; j<N; j++) {
+				output[s*output_stride+j*layout.sample_stride] = _signal_sample(input, s, j);
+			}
+		}
+		return EMD_SUCCESS;
+	}
+	const ceemdan_job job = {plan, input, output, output_stride, layout,
+		noise_strength, S_number, num_siftings, rng_seed, bank};
+	#if EEMD_THREAD_POOL
+	if (plan->pool != NULL) {
+		return _ceemdan_execute_pool(&job, num_signals);
+	}
+	#endif
+	libeemd_error_code emd_err = EMD_SUCCESS;
+	// Scale of the noise shared by a team sifting a single ensemble member
+	double team_noise_sigma = 0;
+	// All of the work is done in a single parallel region. Each mode of each
+	// group of signals is extracted in worksharing loops separated by the
+	// implicit barriers at their ends. Sifting the noise does not depend on
+	// the data, so the noise for the next mode is sifted in a separate loop
+	// without a barrier in between. Threads that finish their share of the
+	// data early start working on the noise instead of waiting.
+	#pragma omp parallel num_threads(plan->num_threads)
+	{
+		#ifdef _OPENMP
+		const int thread_id = omp_get_thread_num();
+		const unsigned int team_size = (unsigned int)omp_get_num_threads();
+		#if EEMD_DEBUG >= 1
+		#pragma omp single nowait
+		fprintf(stderr, "Using %d thread(s) with OpenMP.\n", omp_get_num_threads());
+		#endif
+		#else
+		const int thread_id = 0;
+		const unsigned int team_size = 1;
+		#endif
+		eemd_workspace* w = plan->ws[thread_id];
+		double* const partial_imfs = plan->partial_imfs[thread_id];
+		double* const scratch = (plan->noise_scratch != NULL)?
+			plan->noise_scratch[thread_id] : NULL;
+		unsigned int sift_counter = 0;
+		// The signals are decomposed one group at a time. Each pair of a
+		// signal in the group and an ensemble member is a separate work item.
+		for (size_t group_start=0; group_start<num_signals; group_start+=plan->ceemdan_group_size) {
+			const size_t group_size = (num_signals-group_start < plan->ceemdan_group_size)?
+				num_signals-group_start : plan->ceemdan_group_size;
+			const size_t num_items = group_size*ensemble_size;
+			// Initialize output data to zero. For the first iteration the
+			// residual is the input signal.
+			#pragma omp for nowait
+			for (size_t g=0; g<group_size; g++) {
+				imfs_zero(output+(group_start+g)*output_stride, N, M, layout);
+				_load_signal(input, group_start+g, N, &plan->res[N*g]);
+			}
+			// Generate the white noise of the members whose noise is kept in
+			// memory, since for each mode of the data we need the same mode of
+			// the corresponding realization of noise. Each member has two
+			// slots for the noise: one for the current mode and one for the
+			// next. The random stream depends on the signal and ensemble
+			// member to ensure reproducibility even in a multithreaded case.
+			const size_t num_resident = (bank != NULL)? 0 :
+				(num_items < plan->num_resident_members)? num_items : plan->num_resident_members;
+			// The members are dealt out in the same way as below, so that the
+			// noise is first touched by the thread that uses it for the data
+			#pragma omp for schedule(static, 1)
+			for (size_t item=0; item<num_resident; item++) {
+				_generate_noise(w, plan->rng, rng_seed+group_start*ensemble_size+item,
+						1.0, NULL, &noises[N*2*item], N);
+			}
+			// If there are at most half as many work items as threads and the
+			// signals are long enough, the whole team sifts one ensemble
+			// member at a time instead, using the workspace and partial IMFs
+			// of the first thread. This gives the same results as a single
+			// thread.
+			const bool team_sift = (plan->sift_team != NULL && 2*num_items <= team_size);
+			const size_t num_shared_items = team_sift? 0 : num_items;
+			eemd_workspace* const team_w = plan->ws[0];
+			double* const team_scratch = (plan->noise_scratch != NULL)?
+				plan->noise_scratch[0] : NULL;
+			const size_t num_chunks = team_sift? _sifting_team_num_chunks(plan->sift_team) : 0;
+			// Each mode is extracted sequentially, but we use parallelization
+			// in the inner loops to loop over signals and ensemble members
+			for (size_t imf_i=0; imf_i<M; imf_i++) {
+				// The standard deviation of the residual is needed by every
+				// ensemble member, so compute it only once. The partial IMFs
+				// are cleared for summing the members.
+				#pragma omp for
+				for (size_t g=0; g<group_size; g++) {
+					plan->res_sd[g] = gsl_stats_sd(&plan->res[N*g], 1, N);
+				}
+				memset(partial_imfs, 0x00, group_size*N*sizeof(double));
+				for (size_t item=0; team_sift && item<num_items; item++) {
+					const size_t g = item/ensemble_size;
+					double const* const res = &plan->res[N*g];
+					double const* mode_noise;
+					libeemd_error_code sift_err = EMD_SUCCESS;
+					if (bank != NULL) {
+						mode_noise = &bank->modes[N*((item%ensemble_size)*bank->M+imf_i)];
+					}
+					else if (item < num_resident) {
+						mode_noise = &noises[N*(2*item+imf_i%2)];
+					}
+					else {
+						sift_err = _ceemdan_regenerate_noise_team(team_w, plan->sift_team,
+								plan->rng, rng_seed+group_start*ensemble_size+item, imf_i,
+								team_scratch, team_scratch+N, S_number, num_siftings, &sift_counter);
+						mode_noise = team_scratch;
+					}
+					if (sift_err == EMD_SUCCESS) {
+						#pragma omp single
+						{
+							const double noise_sd = (bank != NULL)?
+								bank->sds[(item%ensemble_size)*bank->M+imf_i] : gsl_stats_sd(mode_noise, 1, N);
+							team_noise_sigma = (noise_sd != 0)? noise_strength*plan->res_sd[g]/noise_sd : 0;
+						}
+						#pragma omp for schedule(static)
+						for (size_t c=0; c<num_chunks; c++) {
+							const size_t start = _chunk_start(N, num_chunks, c);
+							const size_t n = _chunk_start(N, num_chunks, c+1) - start;
+							array_addmul_to(res+start, mode_noise+start, team_noise_sigma, n, team_w->x+start);
+						}
+						sift_err = _sift_team(team_w->x, plan->sift_team, S_number, num_siftings, &sift_counter);
+					}
+					// All threads get the same error code
+					if (sift_err != EMD_SUCCESS) {
+						#pragma omp single
+						emd_err = sift_err;
+						break;
+					}
+					#pragma omp for schedule(static)
+					for (size_t c=0; c<num_chunks; c++) {
+						const size_t start = _chunk_start(N, num_chunks, c);
+						const size_t n = _chunk_start(N, num_chunks, c+1) - start;
+						array_add(team_w->x+start, n, &plan->partial_imfs[0][N*g+start]);
+					}
+				}
+				// A static schedule makes the partial sums, and therefore the
+				// results, depend only on the number of threads. The members
+				// are dealt out one at a time, since members whose noise is
+				// regenerated take more time.
+				#pragma omp for schedule(static, 1) nowait
+				for (size_t item=0; item<num_shared_items; item++) {
+					// Check if an error has occured in other threads
+					#pragma omp flush(emd_err)
+					if (emd_err != EMD_SUCCESS) {
+						continue;
+					}
+					const libeemd_error_code sift_err = _ceemdan_member(&job, w,
+							partial_imfs, scratch, group_start, num_resident, imf_i, item);
+					if (sift_err != EMD_SUCCESS) {
+						emd_err = sift_err;
+						#pragma omp flush(emd_err)
+					}
+				}
+				// Extract next EMD mode of the noise to the other slot. This
+				// is used as the noise for the next mode extracted from the
+				// data. Noise that is not stored is reconstructed from scratch
+				// for the next mode instead. Any thread can do this for any
+				// member without affecting the results.
+				const size_t num_noise_items = (imf_i+1 < M)? num_resident : 0;
+				for (size_t item=0; team_sift && item<num_noise_items && emd_err == EMD_SUCCESS; item++) {
+					double* const noise = &noises[N*(2*item+imf_i%2)];
+					double* const next_noise = &noises[N*(2*item+(imf_i+1)%2)];
+					double* const noise_residual = &noise_residuals[N*item];
+					#pragma omp for schedule(static)
+					for (size_t c=0; c<num_chunks; c++) {
+						const size_t start = _chunk_start(N, num_chunks, c);
+						const size_t n = _chunk_start(N, num_chunks, c+1) - start;
+						if (imf_i == 0) {
+							array_copy(noise+start, n, noise_residual+start);
+						}
+						array_copy(noise_residual+start, n, next_noise+start);
+					}
+					const libeemd_error_code sift_err = _sift_team(next_noise, plan->sift_team,
+							S_number, num_siftings, &sift_counter);
+					if (sift_err != EMD_SUCCESS) {
+						#pragma omp single
+						emd_err = sift_err;
+						break;
+					}
+					#pragma omp for schedule(static)
+					for (size_t c=0; c<num_chunks; c++) {
+						const size_t start = _chunk_start(N, num_chunks, c);
+						const size_t n = _chunk_start(N, num_chunks, c+1) - start;
+						array_sub(next_noise+start, n, noise_residual+start);
+					}
+				}
+				const size_t num_shared_noise_items = team_sift? 0 : num_noise_items;
+				#pragma omp for schedule(dynamic)
+				for (size_t item=0; item<num_shared_noise_items; item++) {
+					#pragma omp flush(emd_err)
+					if (emd_err != EMD_SUCCESS) {
+						continue;
+					}
+					const libeemd_error_code sift_err = _ceemdan_next_noise(&job, w,
+							imf_i, item);
+					if (sift_err != EMD_SUCCESS) {
+						emd_err = sift_err;
+						#pragma omp flush(emd_err)
+					}
+				}
+				// After the implicit barrier all threads see the same error
+				// state and leave the loop together
+				if (emd_err != EMD_SUCCESS) {
+					break;
+				}
+				// Sum the partial IMFs of all threads in blocks, divide with
+				// ensemble size to get the average and subtract this IMF from
+				// the previous residual to form the new one
+				const size_t num_blocks = (N + sum_block_size - 1)/sum_block_size;
+				#pragma omp for
+				for (size_t k=0; k<group_size*num_blocks; k++) {
+					_ceemdan_average_block(&job, team_size, group_start, imf_i, k);
+				}
+			}
+			if (emd_err != EMD_SUCCESS) {
+				break;
+			}
+			// Save final residual
+			#pragma omp for
+			for (size_t g=0; g<group_size; g++) {
+				imf_add(&plan->res[N*g], N, output+(group_start+g)*output_stride, layout, M-1, 0);
+			}
+		}
+	} // Parallel section ends
+	return emd_err;
+}
+
+#if EEMD_THREAD_POOL
+// CEEMDAN with the thread pool. The loops of _ceemdan_execute are run by the
+// pool one after another, except that the ensemble members of the current
+// mode and the noise for the next mode are a single loop, so that workers
+// that finish their share of the members steal noise to sift instead of
+// waiting. The items of the members are the num_partials blocks of the
+// members, each extracted in order by a single worker and summed to the
+// partial IMFs of the block, so that the sums are the same whichever worker
+// happens to extract each block.
+typedef struct {
+	ceemdan_job const* job;
+	size_t group_start;
+	size_t group_size;
+	size_t num_items;
+	size_t num_resident;
+	size_t imf_i;
+	libeemd_error_code err;
+} ceemdan_pool_context;
+
+static void _ceemdan_pool_init(void* context, unsigned int worker, size_t item) {
+	ceemdan_pool_context* const ctx = context;
+	ceemdan_job const* const job = ctx->job;
+	emd_plan const* const plan = job->plan;
+	const size_t N = plan->N;
+	// Initialize output data to zero. For the first iteration the residual
+	// is the input signal.
+	if (item < ctx->group_size) {
+		const size_t s = ctx->group_start+item;
+		imfs_zero(job->output+s*job->output_stride, N, plan->M, job->layout);
+		_load_signal(job->input, s, N, &plan->res[N*item]);
+	}
+	// Generate the white noise of the members whose noise is kept in memory
+	else {
+		const size_t member = item - ctx->group_size;
+		_generate_noise(plan->ws[worker], plan->rng,
+				job->rng_seed+ctx->group_start*plan->ensemble_size+member,
+				1.0, NULL, &plan->noises[N*2*member], N);
+	}
+}
+
+// Start of block b of the members of the group
+static inline size_t _ceemdan_pool_block_start(ceemdan_pool_context const* ctx,
+		size_t b) {
+	return _chunk_start(ctx->num_items, ctx->job->plan->num_partials, b);
+}
+
+// Generating the noise of the resident members in the blocks the worker starts
+// with, so that it is first touched by the worker that starts with sifting it
+static void _ceemdan_pool_generate(void* context, unsigned int worker,
+		__attribute__((unused)) size_t item) {
+	ceemdan_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	size_t start = _ceemdan_pool_block_start(ctx,
+			_chunk_start(plan->num_partials, plan->num_threads, worker));
+	size_t end = _ceemdan_pool_block_start(ctx,
+			_chunk_start(plan->num_partials, plan->num_threads, worker+1));
+	if (start > ctx->num_resident) {
+		start = ctx->num_resident;
+	}
+	if (end > ctx->num_resident) {
+		end = ctx->num_resident;
+	}
+	for (size_t member=start; member<end; member++) {
+		_ceemdan_pool_init(context, worker, ctx->group_size+member);
+	}
+}
+
+static void _ceemdan_pool_prepare_mode(void* context,
+		__attribute__((unused)) unsigned int worker, size_t item) {
+	ceemdan_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	const size_t N = plan->N;
+	if (item < ctx->group_size) {
+		plan->res_sd[item] = gsl_stats_sd(&plan->res[N*item], 1, N);
+	}
+	else {
+		memset(plan->partial_imfs[item-ctx->group_size], 0x00,
+				ctx->group_size*N*sizeof(double));
+	}
+}
+
+// Items below num_partials are the blocks of members, and the rest are the
+// members whose noise is sifted for the next mode
+static void _ceemdan_pool_member(void* context, unsigned int worker, size_t item) {
+	ceemdan_pool_context* const ctx = context;
+	emd_plan const* const plan = ctx->job->plan;
+	libeemd_error_code err = EMD_SUCCESS;
+	if (item < plan->num_partials) {
+		double* const scratch = (plan->noise_scratch != NULL)?
+			plan->noise_scratch[worker] : NULL;
+		const size_t end = _ceemdan_pool_block_start(ctx, item+1);
+		for (size_t member=_ceemdan_pool_block_start(ctx, item); member<end; member++) {
+			if (__atomic_load_n(&ctx->err, __ATOMIC_RELAXED) != EMD_SUCCESS) {
+				return;
+			}
+			err = _ceemdan_member(ctx->job, plan->ws[worker], plan->partial_imfs[item],
+					scratch, ctx->group_start, ctx->num_resident, ctx->imf_i, member);
+			if (err != EMD_SUCCESS) {
+				break;
+			}
+		}
+	}
+	else {
+		if (__atomic_load_n(&ctx->err, __ATOMIC_RELAXED) != EMD_SUCCESS) {
+			return;
+		}
+		err = _ceemdan_next_noise(ctx->job, plan->ws[worker], ctx->imf_i,
+				item-plan->num_partials);
+	}
+	if (err != EMD_SUCCESS) {
+		__atomic_store_n(&ctx->err, err, __ATOMIC_RELAXED);
+	}
+}
+
+// Sifting the noise of the resident members in block b
+static void _ceemdan_pool_next_noise(void* context, unsigned int worker, size_t b) {
+	ceemdan_pool_context* const ctx = context;
+	const size_t num_partials = ctx->job->plan->num_partials;
+	const size_t start = _ceemdan_pool_block_start(ctx, b);
+	const size_t end = _ceemdan_pool_block_start(ctx, b+1);
+	for (size_t member=start; member<end && member<ctx->num_resident; member++) {
+		_ceemdan_pool_member(context, worker, num_partials+member);
+	}
+}
+
+static void _ceemdan_pool_average(void* context,
+		__attribute__((unused)) unsigned int worker, size_t k) {
+	ceemdan_pool_context* const ctx = context;
+	_ceemdan_average_block(ctx->job, ctx->job->plan->num_partials,
+			ctx->group_start, ctx->imf_i, k);
+}
+
+static void _ceemdan_pool_residual(void* context,
+		__attribute__((unused)) unsigned int worker, size_t g) {
+	ceemdan_pool_context* const ctx = context;
+	ceemdan_job const* const job = ctx->job;
+	emd_plan const* const plan = job->plan;
+	imf_add(&plan->res[plan->N*g], plan->N, job->output+(ctx->group_start+g)*job->output_stride,
+			job->layout, plan->M-1, 0);
+}
+
+static libeemd_error_code _ceemdan_execute_pool(ceemdan_job const* restrict job,
+		size_t num_signals) {
+	emd_plan* const plan = job->plan;
+	thread_pool* const pool = plan->pool;
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	const size_t num_blocks = (N + sum_block_size - 1)/sum_block_size;
+	ceemdan_pool_context ctx = {job, 0, 0, 0, 0, 0, EMD_SUCCESS};
+	_pool_enter(pool);
+	for (size_t group_start=0; group_start<num_signals; group_start+=plan->ceemdan_group_size) {
+		ctx.group_start = group_start;
+		ctx.group_size = (num_signals-group_start < plan->ceemdan_group_size)?
+			num_signals-group_start : plan->ceemdan_group_size;
+		ctx.num_items = ctx.group_size*plan->ensemble_size;
+		ctx.num_resident = (job->bank != NULL)? 0 :
+			(ctx.num_items < plan->num_resident_members)? ctx.num_items : plan->num_resident_members;
+		if (plan->numa == EMD_NUMA_LOCAL) {
+			_pool_run(pool, ctx.group_size, _ceemdan_pool_init, &ctx);
+			_pool_run_each(pool, _ceemdan_pool_generate, &ctx);
+		}
+		else {
+			_pool_run(pool, ctx.group_size+ctx.num_resident, _ceemdan_pool_init, &ctx);
+		}
+		for (size_t imf_i=0; imf_i<M; imf_i++) {
+			ctx.imf_i = imf_i;
+			const size_t num_noise_items = (imf_i+1 < M)? ctx.num_resident : 0;
+			_pool_run(pool, ctx.group_size+plan->num_partials, _ceemdan_pool_prepare_mode, &ctx);
+			// With NUMA placement the members and the noise are separate
+			// loops over the same blocks, so that each worker starts with
+			// the same members in both as when the noise was generated
+			if (plan->numa == EMD_NUMA_LOCAL) {
+				_pool_run(pool, plan->num_partials, _ceemdan_pool_member, &ctx);
+				if (num_noise_items > 0) {
+					_pool_run(pool, plan->num_partials, _ceemdan_pool_next_noise, &ctx);
+				}
+			}
+			else {
+				_pool_run(pool, plan->num_partials+num_noise_items, _ceemdan_pool_member, &ctx);
+			}
+			if (ctx.err != EMD_SUCCESS) {
+				_pool_leave(pool);
+				return ctx.err;
+			}
+			_pool_run(pool, ctx.group_size*num_blocks, _ceemdan_pool_average, &ctx);
+		}
+		_pool_run(pool, ctx.group_size, _ceemdan_pool_residual, &ctx);
+	}
+	_pool_leave(pool);
+	return EMD_SUCCESS;
+}
+#endif
+
+// Single-precision decomposition
+//
+// These follow _eemd_execute and _ceemdan_execute for a single signal, but
+// the ensemble members are float arrays sifted with _sift_float and _emd_float.
+// The noise is generated in double precision to the double-precision
+// ensemble member of the thread's workspace, which is otherwise unused.
+
+// Helper function for computing the standard deviation of float data in
+// double precision in the same way as gsl_stats_sd
+static double _stats_sd_float(float const* restrict x, size_t N) {
+	double mean = 0;
+	for (size_t i=0; i<N; i++) {
+		mean += (x[i] - mean)/(double)(i+1);
+	}
+	double variance = 0;
+	for (size_t i=0; i<N; i++) {
+		const double delta = x[i] - mean;
+		variance += (delta*delta - variance)/(double)(i+1);
+	}
+	return sqrt(variance*((double)N/(double)(N-1)));
+}
+
+// Helper function for summing element k of the sum buffers of the first
+// num_sums threads in double precision
+static inline double _total_of_sums(void* const* sums, unsigned int num_sums,
+		emd_precision sum_precision, size_t k) {
+	double total = 0;
+	if (sum_precision == EMD_PRECISION_DOUBLE) {
+		for (unsigned int t=0; t<num_sums; t++) {
+			total += ((double const*)sums[t])[k];
+		}
+	}
+	else {
+		for (unsigned int t=0; t<num_sums; t++) {
+			total += ((float const*)sums[t])[k];
+		}
+	}
+	return total;
+}
+
+static libeemd_error_code _eemd_execute_float(emd_plan* restrict plan,
+		float const* restrict input, float* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	const unsigned int ensemble_size = plan->ensemble_size;
+	const emd_precision sum_precision = plan->sum_precision;
+	const size_t sum_elem_size = (sum_precision == EMD_PRECISION_DOUBLE)? sizeof(double) : sizeof(float);
+	// The noise standard deviation is noise_strength times the standard
+	// deviation of input data
+	const double noise_sigma = (noise_strength == 0.0)? 0 : _stats_sd_float(input, N)*noise_strength;
+	libeemd_error_code emd_err = EMD_SUCCESS;
+	#pragma omp parallel num_threads(plan->num_threads)
+	{
+		#ifdef _OPENMP
+		const int thread_id = omp_get_thread_num();
+		const unsigned int team_size = (unsigned int)omp_get_num_threads();
+		#else
+		const int thread_id = 0;
+		const unsigned int team_size = 1;
+		#endif
+		eemd_workspace* w = plan->ws[thread_id];
+		float* const x = plan->float_signals[thread_id];
+		float* const res = x+N;
+		void* const sum = plan->float_sums[thread_id];
+		memset(sum, 0x00, M*N*sum_elem_size);
+		// Each thread sums its ensemble members to its own buffer
+		#pragma omp for schedule(dynamic) nowait
+		for (size_t i=0; i<ensemble_size; i++) {
+			#pragma omp flush(emd_err)
+			if (emd_err != EMD_SUCCESS) {
+				continue;
+			}
+			if (noise_strength == 0.0) {
+				memcpy(x, input, N*sizeof(float));
+			}
+			else {
+				_generate_noise(w, plan->rng, rng_seed+i, noise_sigma, NULL, w->x, N);
+				for (size_t j=0; j<N; j++) {
+					x[j] = (float)(input[j] + w->x[j]);
+				}
+			}
+			const libeemd_error_code err = _emd_float(x, res, w->emd_w->sift_w,
+					sum_precision, sum, M, S_number, num_siftings);
+			if (err != EMD_SUCCESS) {
+				emd_err = err;
+				#pragma omp flush(emd_err)
+			}
+		}
+		#pragma omp barrier
+		// Sum the buffers of all threads and divide by the ensemble size to
+		// get the average
+		if (emd_err == EMD_SUCCESS) {
+			const double one_per_ensemble_size = 1.0/ensemble_size;
+			#pragma omp for
+			for (size_t k=0; k<M*N; k++) {
+				output[k] = (float)(_total_of_sums(plan->float_sums, team_size,
+							sum_precision, k)*one_per_ensemble_size);
+			}
+		}
+	}
+	return emd_err;
+}
+
+static libeemd_error_code _ceemdan_execute_float(emd_plan* restrict plan,
+		float const* restrict input, float* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	const size_t N = plan->N;
+	const size_t M = plan->M;
+	const unsigned int ensemble_size = plan->ensemble_size;
+	const emd_precision sum_precision = plan->sum_precision;
+	const size_t sum_elem_size = (sum_precision == EMD_PRECISION_DOUBLE)? sizeof(double) : sizeof(float);
+	// Ensemble member i has two slots for the modes of its noise starting at
+	// noises[3*N*i], followed by the residual of the noise
+	float* const noises = plan->float_noises;
+	float* const res = plan->float_res;
+	// For M == 1 the only "IMF" is the residual
+	if (M == 1) {
+		memcpy(output, input, N*sizeof(float));
+		return EMD_SUCCESS;
+	}
+	memset(output, 0x00, M*N*sizeof(float));
+	memcpy(res, input, N*sizeof(float));
+	const double one_per_ensemble_size = 1.0/ensemble_size;
+	libeemd_error_code emd_err = EMD_SUCCESS;
+	double res_sd = 0;
+	#pragma omp parallel num_threads(plan->num_threads)
+	{
+		#ifdef _OPENMP
+		const int thread_id = omp_get_thread_num();
+		const unsigned int team_size = (unsigned int)omp_get_num_threads();
+		#else
+		const int thread_id = 0;
+		const unsigned int team_size = 1;
+		#endif
+		eemd_workspace* w = plan->ws[thread_id];
+		float* const x = plan->float_signals[thread_id];
+		void* const partial_imf = plan->float_sums[thread_id];
+		unsigned int sift_counter = 0;
+		#pragma omp for
+		for (size_t i=0; i<ensemble_size; i++) {
+			_generate_noise(w, plan->rng, rng_seed+i, 1.0, NULL, w->x, N);
+			float* const noise = &noises[3*N*i];
+			for (size_t j=0; j<N; j++) {
+				noise[j] = (float)w->x[j];
+			}
+		}
+		for (size_t imf_i=0; imf_i<M; imf_i++) {
+			#pragma omp single
+			res_sd = _stats_sd_float(res, N);
+			memset(partial_imf, 0x00, N*sum_elem_size);
+			#pragma omp for schedule(static, 1) nowait
+			for (size_t i=0; i<ensemble_size; i++) {
+				#pragma omp flush(emd_err)
+				if (emd_err != EMD_SUCCESS) {
+					continue;
+				}
+				// Fix the SNR of this stage as in _ceemdan_execute
+				float const* const mode_noise = &noises[3*N*i + N*(imf_i%2)];
+				const double noise_sd = _stats_sd_float(mode_noise, N);
+				const double noise_sigma = (noise_sd != 0)? noise_strength*res_sd/noise_sd : 0;
+				for (size_t j=0; j<N; j++) {
+					x[j] = (float)(res[j] + noise_sigma*mode_noise[j]);
+				}
+				const libeemd_error_code sift_err = _sift_float(x, w->emd_w->sift_w,
+						S_number, num_siftings, &sift_counter);
+				_add_to_sum(x, N, sum_precision, partial_imf, 0);
+				if (sift_err != EMD_SUCCESS) {
+					emd_err = sift_err;
+					#pragma omp flush(emd_err)
+				}
+			}
+			// Extract the next mode of the noise to the other slot
+			const size_t num_noise_items = (imf_i+1 < M)? ensemble_size : 0;
+			#pragma omp for schedule(dynamic)
+			for (size_t i=0; i<num_noise_items; i++) {
+				#pragma omp flush(emd_err)
+				if (emd_err != EMD_SUCCESS) {
+					continue;
+				}
+				float* const noise = &noises[3*N*i + N*(imf_i%2)];
+				float* const next_noise = &noises[3*N*i + N*((imf_i+1)%2)];
+				float* const noise_residual = &noises[3*N*i + 2*N];
+				if (imf_i == 0) {
+					memcpy(noise_residual, noise, N*sizeof(float));
+				}
+				memcpy(next_noise, noise_residual, N*sizeof(float));
+				const libeemd_error_code sift_err = _sift_float(next_noise,
+						w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
+				for (size_t j=0; j<N; j++) {
+					noise_residual[j] -= next_noise[j];
+				}
+				if (sift_err != EMD_SUCCESS) {
+					emd_err = sift_err;
+					#pragma omp flush(emd_err)
+				}
+			}
+			if (emd_err != EMD_SUCCESS) {
+				break;
+			}
+			// Average the partial IMFs of all threads and subtract the IMF
+			// from the residual
+			float* const imf = output+imf_i*N;
+			#pragma omp for
+			for (size_t j=0; j<N; j++) {
+				imf[j] = (float)(_total_of_sums(plan->float_sums, team_size,
+							sum_precision, j)*one_per_ensemble_size);
+				res[j] -= imf[j];
+			}
+		}
+		if (emd_err == EMD_SUCCESS) {
+			#pragma omp for
+			for (size_t j=0; j<N; j++) {
+				output[N*(M-1)+j] += res[j];
+			}
+		}
+	}
+	return emd_err;
+}
+
+libeemd_error_code emd_plan_execute_float(emd_plan* plan,
+		float const* restrict input, float* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed) {
+	gsl_set_error_handler_off();
+	if (plan->precision != EMD_PRECISION_FLOAT) {
+		return EMD_PRECISION_MISMATCH;
+	}
+	libeemd_error_code validation_result = _validate_eemd_parameters(plan->ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	if (plan->N == 0) {
+		return EMD_SUCCESS;
+	}
+	if (plan->variant == EMD_VARIANT_CEEMDAN) {
+		return _ceemdan_execute_float(plan, input, output, noise_strength,
+				S_number, num_siftings, rng_seed);
+	}
+	return _eemd_execute_float(plan, input, output, noise_strength,
+			S_number, num_siftings, rng_seed);
+}
+
+// Helper function for eemdf and ceemdanf
+static libeemd_error_code _decompose_float(emd_variant variant,
+		float const* restrict input, size_t N, float* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	libeemd_error_code validation_result = _validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	if (N == 0) {
+		return EMD_SUCCESS;
+	}
+	emd_plan* plan = _create_routine_plan(variant, N, M, ensemble_size, 0,
+			EMD_PRECISION_FLOAT);
+	if (plan == NULL) {
+		return _plan_creation_error(N);
+	}
+	libeemd_error_code err = emd_plan_execute_float(plan, input, output, noise_strength, S_number, num_siftings, rng_seed);
+	emd_plan_destroy(plan);
+	return err;
+}
+
+libeemd_error_code eemdf(float const* restrict input, size_t N,
+		float* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	return _decompose_float(EMD_VARIANT_EEMD, input, N, output, M,
+			ensemble_size, noise_strength, S_number, num_siftings, rng_seed);
+}
+
+libeemd_error_code ceemdanf(float const* restrict input, size_t N,
+		float* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed) {
+	return _decompose_float(EMD_VARIANT_CEEMDAN, input, N, output, M,
+			ensemble_size, noise_strength, S_number, num_siftings, rng_seed);
+}
+
+static inline libeemd_error_code _validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings) {
+	if (ensemble_size < 1) {
+		return EMD_INVALID_ENSEMBLE_SIZE;
+	}
+	if (noise_strength < 0) {
+		return EMD_INVALID_NOISE_STRENGTH;
+	}
+	if (ensemble_size == 1 && noise_strength > 0) {
+		return EMD_NOISE_ADDED_TO_EMD;
+	}
+	if (ensemble_size > 1 && noise_strength == 0) {
+		return EMD_NO_NOISE_ADDED_TO_EEMD;
+	}
+	if (S_number == 0 && num_siftings == 0) {
+		return EMD_NO_CONVERGENCE_POSSIBLE;
+	}
+	return EMD_SUCCESS;
+}
+
+static inline libeemd_error_code _plan_creation_error(size_t N) {
+	if (N > EEMD_MAX_KNOT_N) {
+		return EMD_INVALID_LENGTH;
+	}
+	return EMD_ALLOCATION_ERROR;
+}
+
+// Helper function for checking the S-number criterion after a sifting
+// iteration. S_counter counts the iterations for which the numbers of extrema
+// and zero crossings have stayed stable.
+static inline bool _s_number_converged(unsigned int S_number, unsigned int* S_counter,
+		size_t num_max, size_t num_min, size_t num_zc,
+		size_t prev_num_max, size_t prev_num_min, size_t prev_num_zc) {
+	const int max_diff = (int)num_max - (int)prev_num_max;
+	const int min_diff = (int)num_min - (int)prev_num_min;
+	const int zc_diff = (int)num_zc - (int)prev_num_zc;
+	if (abs(max_diff)+abs(min_diff)+abs(zc_diff) <= 1) {
+		(*S_counter)++;
+		if (*S_counter >= S_number) {
+			const int num_diff = (int)num_min + (int)num_max - 4 - (int)num_zc;
+			if (abs(num_diff) <= 1) {
+				// Number of extrema has been stable for S_number steps
+				// and the number of *interior* extrema and zero
+				// crossings differ by at most one -- we are converged
+				// according to the S-number criterion
+				return true;
+			}
+		}
+	}
+	else {
+		*S_counter = 0;
+	}
+	return false;
+}
+
+// Helper function for applying the sifting procedure to input until it is
+// reduced to an IMF according to the stopping criteria given by S_number and
+// num_siftings. The required number of siftings is saved to sift_counter.
+static libeemd_error_code _sift(double* restrict input, sifting_workspace*
+		restrict w, unsigned int S_number, unsigned int num_siftings,
+		unsigned int* sift_counter) {
+	const size_t N = w->N;
+	// Initialize counters that keep track of the number of siftings
+	// and the S number
+	*sift_counter = 0;
+	unsigned int S_counter = 0;
+	// Numbers of extrema and zero crossings are initialized to dummy values
+	size_t num_max = (size_t)(-1);
+	size_t num_min = (size_t)(-1);
+	size_t num_zc = (size_t)(-1);
+	size_t prev_num_max = (size_t)(-1);
+	size_t prev_num_min = (size_t)(-1);
+	size_t prev_num_zc = (size_t)(-1);
+	// The extrema are found separately only for the first iteration. After
+	// that they are found while sifting. The factorizations of the previous
+	// signal cannot be reused.
+	bool have_extrema = false;
+	w->factored_num_max = 0;
+	w->factored_num_min = 0;
+	size_t next_num_max = 0;
+	size_t next_num_min = 0;
+	size_t next_num_zc = 0;
+	while (num_siftings == 0 || *sift_counter < num_siftings) {
+		(*sift_counter)++;
+		#if EEMD_DEBUG >= 1
+		if (*sift_counter == 10000) {
+			fprintf(stderr, "Something is probably wrong. Sift counter has reached 10000.\n");
+		}
+		#endif
+		prev_num_max = num_max;
+		prev_num_min = num_min;
+		prev_num_zc = num_zc;
+		// Find extrema and count zero crossings
+		if (have_extrema) {
+			num_max = next_num_max;
+			num_min = next_num_min;
+			num_zc = next_num_zc;
+		}
+		else {
+			_find_extrema(input, N, w->maxx, w->maxy, &num_max, w->minx, w->miny, &num_min, &num_zc);
+		}
+		// Check if we are finished based on the S-number criteria
+		if (S_number != 0 && _s_number_converged(S_number, &S_counter,
+					num_max, num_min, num_zc, prev_num_max, prev_num_min, prev_num_zc)) {
+			break;
+		}
+		// Subtract the envelope mean from the data, and find the extrema
+		// for the next iteration if there will be one
+		const bool find_next = (num_siftings == 0 || *sift_counter < num_siftings);
+		libeemd_error_code sift_err = _sift_once(input, w, num_max, num_min,
+				find_next, &next_num_max, &next_num_min, &next_num_zc);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		if (find_next) {
+			_swap_extrema(w);
+			have_extrema = true;
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+// Helper function for extracting all IMFs from input using the sifting
+// procedure defined by _sift. The contents of the input array are destroyed in
+// the process. The IMFs are added to output in the given layout.
+static libeemd_error_code _emd(double* restrict input, emd_workspace* restrict w,
+		double* restrict output, imf_layout layout, size_t M,
+		unsigned int S_number, unsigned int num_siftings) {
+	// Provide some shorthands to avoid excessive '->' operators
+	const size_t N = w->N;
+	double* const res = w->res;
+	lock* locks = w->locks;
+	if (M == 0) {
+		M = emd_num_imfs(N);
+	}
+	// We need to store a copy of the original signal so that once it is
+	// reduced to an IMF we have something to subtract the IMF from to form
+	// the residual for the next iteration
+	array_copy(input, N, res);
+	// Loop over all IMFs to be separated from input
+	unsigned int sift_counter;
+	for (size_t imf_i=0; imf_i<M-1; imf_i++) {
+		if (imf_i != 0) {
+			// Except for the first iteration, restore the previous residual
+			// and use it as an input
+			array_copy(res, N, input);
+		}
+		// Perform siftings on input until it is an IMF
+		libeemd_error_code sift_err = _sift(input, w->sift_w, S_number, num_siftings, &sift_counter);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		// Subtract this IMF from the saved copy to form the residual for
+		// the next round
+		array_sub(input, N, res);
+		// Add the discovered IMF to the output matrix. Use locks to ensure
+		// other threads are not writing to the same row of the output matrix
+		// at the same time, unless the output is private to this thread
+		if (locks != NULL) get_lock(&locks[imf_i]);
+		imf_add(input, N, output, layout, imf_i, 0);
+		if (locks != NULL) release_lock(&locks[imf_i]);
+		#if EEMD_DEBUG >= 2
+		fprintf(stderr, "IMF %zd saved after %u siftings.\n", imf_i+1, sift_counter);
+		#endif
+	}
+	// Save final residual
+	if (locks != NULL) get_lock(&locks[M-1]);
+	imf_add(res, N, output, layout, M-1, 0);
+	if (locks != NULL) release_lock(&locks[M-1]);
+	return EMD_SUCCESS;
+}
+
+// The extrema-finding loop of emd_find_extrema is written as a state machine
+// that can be fed the data piece by piece. This is needed for finding the
+// extrema of the signal while it is still being sifted.
+enum slope { UP, DOWN, NONE };
+enum sign { POS, NEG, ZERO };
+typedef struct {
+	enum slope previous_slope;
+	enum sign previous_sign;
+	int flat_counter;
+	// Numbers of extrema and zero crossings found so far
+	size_t nmax;
+	size_t nmin;
+	size_t nzc;
+} extrema_state;
+
+// Start finding extrema from data whose first point is x0
+static inline void _extrema_begin(extrema_state* restrict st, double x0,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	// Add the ends of the data as both local minima and maxima. These
+	// might be changed later by linear extrapolation.
+	_knot_set(maxx, 0, 0);
+	maxy[0] = x0;
+	st->nmax = 1;
+	_knot_set(minx, 0, 0);
+	miny[0] = x0;
+	st->nmin = 1;
+	st->nzc = 0;
+	st->previous_slope = NONE;
+	st->previous_sign = (x0 < -0)? NEG : ((x0 > 0)? POS : ZERO);
+	st->flat_counter = 0;
+}
+
+// Process the data points from i_start to i_end (inclusive), i.e., look at
+// the differences x[i+1]-x[i] for i_start <= i < i_end. This is the reference
+// implementation, which the SIMD versions below must agree with exactly.
+static inline void _extrema_scan_scalar(extrema_state* restrict st, double const* restrict x,
+		size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	// Now starts the main extrema-finding loop. The loop detects points where
+	// the slope of the data changes sign. In the case of flat regions at the
+	// extrema, the center point of the flat region will be considered the
+	// extremal point. While detecting extrema, the loop also counts the number
+	// of zero crossings that occur.
+	enum slope previous_slope = st->previous_slope;
+	enum sign previous_sign = st->previous_sign;
+	int flat_counter = st->flat_counter;
+	size_t nmax = st->nmax;
+	size_t nmin = st->nmin;
+	size_t nzc = st->nzc;
+	for (size_t i=i_start; i<i_end; i++) {
+		if (x[i+1] > x[i]) { // Going up
+			if (previous_slope == DOWN) {
+				// Was going down before -> local minimum found
+				_knot_set(minx, nmin, _knot(i, flat_counter));
+				miny[nmin] = x[i];
+				nmin++;
+			}
+			if (previous_sign == NEG && x[i+1] > 0) { // zero crossing from neg to pos
+				nzc++;
+				previous_sign = POS;
+			}
+			else if (previous_sign == ZERO && x[i+1] > 0) {
+				// this needs to be handled as an unfortunate special case
+				previous_sign = POS;
+			}
+			previous_slope = UP;
+			flat_counter = 0;
+		}
+		else if (x[i+1] < x[i]) { // Going down
+			if (previous_slope == UP) {
+				// Was going up before -> local maximum found
+				_knot_set(maxx, nmax, _knot(i, flat_counter));
+				maxy[nmax] = x[i];
+				nmax++;
+			}
+			if (previous_sign == POS && x[i+1] < -0) { // zero crossing from pos to neg
+				nzc++;
+				previous_sign = NEG;
+			}
+			else if (previous_sign == ZERO && x[i+1] < -0) {
+				// this needs to be handled as an unfortunate special case
+				previous_sign = NEG;
+			}
+			previous_slope = DOWN;
+			flat_counter = 0;
+		}
+		else { // Staying flat
+			flat_counter++;
+			#if EEMD_DEBUG >= 3
+			fprintf(stderr, "Warning: a flat slope found in data. The results will differ from the reference EEMD implementation.\n");
+			#endif
+		}
+	}
+	st->previous_slope = previous_slope;
+	st->previous_sign = previous_sign;
+	st->flat_counter = flat_counter;
+	st->nmax = nmax;
+	st->nmin = nmin;
+	st->nzc = nzc;
+}
+
+#if EEMD_X86_SIMD
+// The SIMD versions of _extrema_scan look at W consecutive differences at a
+// time. In the common case where there are no flat regions and no exact
+// zeros, the state machine of _extrema_scan_scalar simplifies to bit
+// operations: there is an extremum wherever the direction of the slope
+// changes, and a zero crossing wherever the sign of the data changes. Chunks
+// that do not satisfy these conditions are passed to the scalar version.
+//
+// This helper takes bit masks of rising slopes and positive values for a
+// chunk starting at i, counts the zero crossings, returns the masks of maxima
+// and minima and updates the state to the end of the chunk.
+// The bit operations are only valid if the state does not depend on
+// preceding flat regions, and if the recorded sign agrees with the sign of
+// x[i]. The latter can fail only after NaNs, which count as flat.
+static inline bool _extrema_fast_state(extrema_state const* restrict st, double xi) {
+	return st->flat_counter == 0 &&
+		((st->previous_sign == POS && xi > 0) || (st->previous_sign == NEG && xi < 0));
+}
+
+static inline void _extrema_chunk_masks(extrema_state* restrict st,
+		unsigned int W, unsigned int up, unsigned int pos,
+		unsigned int* maxmask, unsigned int* minmask) {
+	const unsigned int all = (1u << W) - 1;
+	const unsigned int down = ~up & all;
+	const unsigned int prev_up = ((up << 1) | (st->previous_slope == UP)) & all;
+	const unsigned int prev_down = ((down << 1) | (st->previous_slope == DOWN)) & all;
+	*maxmask = down & prev_up;
+	*minmask = up & prev_down;
+	const unsigned int prev_pos = ((pos << 1) | (st->previous_sign == POS)) & all;
+	st->nzc += (size_t)__builtin_popcount(pos ^ prev_pos);
+	st->previous_slope = (up >> (W-1))? UP : DOWN;
+	st->previous_sign = (pos >> (W-1))? POS : NEG;
+}
+
+__attribute__((target("avx2")))
+static void _extrema_scan_avx2(extrema_state* restrict st, double const* restrict x,
+		size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	const __m256d zero = _mm256_setzero_pd();
+	size_t i = i_start;
+	for (; i+4 <= i_end; i+=4) {
+		if (!_extrema_fast_state(st, x[i])) {
+			_extrema_scan_scalar(st, x, i, i+4, maxx, maxy, minx, miny);
+			continue;
+		}
+		const __m256d a = _mm256_loadu_pd(x+i);
+		const __m256d b = _mm256_loadu_pd(x+i+1);
+		const unsigned int up = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(b, a, _CMP_GT_OQ));
+		const unsigned int down = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(b, a, _CMP_LT_OQ));
+		const unsigned int pos = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(b, zero, _CMP_GT_OQ));
+		const unsigned int neg = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(b, zero, _CMP_LT_OQ));
+		if ((up | down) != 0xf || (pos | neg) != 0xf) {
+			_extrema_scan_scalar(st, x, i, i+4, maxx, maxy, minx, miny);
+			continue;
+		}
+		unsigned int maxmask, minmask;
+		_extrema_chunk_masks(st, 4, up, pos, &maxmask, &minmask);
+		// AVX2 has no compress-store, so write the extrema one by one
+		while (maxmask) {
+			const unsigned int k = (unsigned int)__builtin_ctz(maxmask);
+			_knot_set(maxx, st->nmax, _knot(i+k, 0));
+			maxy[st->nmax] = x[i+k];
+			st->nmax++;
+			maxmask &= maxmask-1;
+		}
+		while (minmask) {
+			const unsigned int k = (unsigned int)__builtin_ctz(minmask);
+			_knot_set(minx, st->nmin, _knot(i+k, 0));
+			miny[st->nmin] = x[i+k];
+			st->nmin++;
+			minmask &= minmask-1;
+		}
+	}
+	_extrema_scan_scalar(st, x, i, i_end, maxx, maxy, minx, miny);
+}
+
+__attribute__((target("avx512f")))
+static void _extrema_scan_avx512(extrema_state* restrict st, double const* restrict x,
+		size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	const __m512d zero = _mm512_setzero_pd();
+	const __m512i wide_lanes = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+	// Only the lower eight lanes of narrow positions are ever stored
+	const __m512i narrow_lanes = _mm512_set_epi32(0, 0, 0, 0, 0, 0, 0, 0,
+			14, 12, 10, 8, 6, 4, 2, 0);
+	size_t i = i_start;
+	for (; i+8 <= i_end; i+=8) {
+		if (!_extrema_fast_state(st, x[i])) {
+			_extrema_scan_scalar(st, x, i, i+8, maxx, maxy, minx, miny);
+			continue;
+		}
+		const __m512d a = _mm512_loadu_pd(x+i);
+		const __m512d b = _mm512_loadu_pd(x+i+1);
+		const unsigned int up = _mm512_cmp_pd_mask(b, a, _CMP_GT_OQ);
+		const unsigned int down = _mm512_cmp_pd_mask(b, a, _CMP_LT_OQ);
+		const unsigned int pos = _mm512_cmp_pd_mask(b, zero, _CMP_GT_OQ);
+		const unsigned int neg = _mm512_cmp_pd_mask(b, zero, _CMP_LT_OQ);
+		if ((up | down) != 0xff || (pos | neg) != 0xff) {
+			_extrema_scan_scalar(st, x, i, i+8, maxx, maxy, minx, miny);
+			continue;
+		}
+		unsigned int maxmask, minmask;
+		_extrema_chunk_masks(st, 8, up, pos, &maxmask, &minmask);
+		void* const maxp = _knot_array_at(maxx, st->nmax).p;
+		void* const minp = _knot_array_at(minx, st->nmin).p;
+		if (maxx.wide) {
+			const __m512i idx = _mm512_add_epi64(_mm512_set1_epi64((long long)_knot(i, 0)), wide_lanes);
+			_mm512_mask_compressstoreu_epi64(maxp, (__mmask8)maxmask, idx);
+			_mm512_mask_compressstoreu_epi64(minp, (__mmask8)minmask, idx);
+		}
+		else {
+			const __m512i idx = _mm512_add_epi32(
+					_mm512_set1_epi32((int)(uint32_t)_knot(i, 0)), narrow_lanes);
+			_mm512_mask_compressstoreu_epi32(maxp, (__mmask16)maxmask, idx);
+			_mm512_mask_compressstoreu_epi32(minp, (__mmask16)minmask, idx);
+		}
+		_mm512_mask_compressstoreu_pd(maxy+st->nmax, (__mmask8)maxmask, a);
+		st->nmax += (size_t)__builtin_popcount(maxmask);
+		_mm512_mask_compressstoreu_pd(miny+st->nmin, (__mmask8)minmask, a);
+		st->nmin += (size_t)__builtin_popcount(minmask);
+	}
+	_extrema_scan_scalar(st, x, i, i_end, maxx, maxy, minx, miny);
+}
+#endif
+
+// Process the data points from i_start to i_end with the fastest
+// implementation supported by the CPU
+static inline void _extrema_scan(extrema_state* restrict st, double const* restrict x,
+		size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	#if EEMD_X86_SIMD
+	if (__builtin_cpu_supports("avx512f")) {
+		_extrema_scan_avx512(st, x, i_start, i_end, maxx, maxy, minx, miny);
+		return;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		_extrema_scan_avx2(st, x, i_start, i_end, maxx, maxy, minx, miny);
+		return;
+	}
+	#endif
+	_extrema_scan_scalar(st, x, i_start, i_end, maxx, maxy, minx, miny);
+}
+
+// Helper function for replacing the first and last of n >= 4 maxima (if
+// upper) or minima y of data of length N by the linear extrapolation of the
+// next two extrema, if that is more extremal. The positions of the second
+// and third extrema and of the third and second to last are x_1, x_2, x_nm3
+// and x_nm2.
+static inline void _extrapolate_ends(double* restrict y, size_t n, size_t N,
+		double x_1, double x_2, double x_nm3, double x_nm2, bool upper) {
+	const double el = linear_extrapolate(x_1, y[1], x_2, y[2], 0);
+	if (upper? (el > y[0]) : (el < y[0]))
+		y[0] = el;
+	const double er = linear_extrapolate(x_nm3, y[n-3], x_nm2, y[n-2], N-1);
+	if (upper? (er > y[n-1]) : (er < y[n-1]))
+		y[n-1] = er;
+}
+
+// Finish finding extrema from data of length N >= 2 whose last point is
+// x_last, after all of it has been processed with _extrema_scan
+static inline void _extrema_end(extrema_state* restrict st, double x_last,
+		size_t N, knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	// Add the other end of the data as extrema as well.
+	_knot_set(maxx, st->nmax, _knot(N-1, 0));
+	maxy[st->nmax] = x_last;
+	st->nmax++;
+	_knot_set(minx, st->nmin, _knot(N-1, 0));
+	miny[st->nmin] = x_last;
+	st->nmin++;
+	const size_t nmax = st->nmax;
+	const size_t nmin = st->nmin;
+	// If we have at least two interior extrema, test if linear extrapolation provides
+	// a more extremal value.
+	if (nmax >= 4) {
+		_extrapolate_ends(maxy, nmax, N,
+				_knot_x(_knot_get(maxx, 1)), _knot_x(_knot_get(maxx, 2)),
+				_knot_x(_knot_get(maxx, nmax-3)), _knot_x(_knot_get(maxx, nmax-2)),
+				true);
+	}
+	if (nmin >= 4) {
+		_extrapolate_ends(miny, nmin, N,
+				_knot_x(_knot_get(minx, 1)), _knot_x(_knot_get(minx, 2)),
+				_knot_x(_knot_get(minx, nmin-3)), _knot_x(_knot_get(minx, nmin-2)),
+				false);
+	}
+}
+
+// Same as emd_find_extrema, but with the doubled positions used in sifting
+static void _find_extrema(double const* restrict x, size_t N,
+		knot_array maxx, double* restrict maxy, size_t* nmax,
+		knot_array minx, double* restrict miny, size_t* nmin,
+		size_t* nzc) {
+	// Set the number of extrema and zero crossings to zero initially
+	*nmax = 0;
+	*nmin = 0;
+	*nzc = 0;
+	// Handle empty array as a special case
+	if (N == 0) {
+		return;
+	}
+	extrema_state st;
+	_extrema_begin(&st, x[0], maxx, maxy, minx, miny);
+	// If we had only one data point this is it
+	if (N > 1) {
+		_extrema_scan(&st, x, 0, N-1, maxx, maxy, minx, miny);
+		_extrema_end(&st, x[N-1], N, maxx, maxy, minx, miny);
+	}
+	*nmax = st.nmax;
+	*nmin = st.nmin;
+	*nzc = st.nzc;
+}
+
+void emd_find_extrema(double const* restrict x, size_t N,
+		double* restrict maxx, double* restrict maxy, size_t* nmax,
+		double* restrict minx, double* restrict miny, size_t* nmin,
+		size_t* nzc) {
+	*nmax = 0;
+	*nmin = 0;
+	*nzc = 0;
+	if (N == 0) {
+		return;
+	}
+	// The data is scanned in blocks, and the doubled positions relative to
+	// the start of each block are converted to doubles. A flat region
+	// continuing from the previous block gives a negative relative position.
+	// This works for any N, also beyond EEMD_MAX_KNOT_N.
+	const size_t block_size = 512;
+	knot_pos block_maxx_pos[512/2+1];
+	knot_pos block_minx_pos[512/2+1];
+	const knot_array block_maxx = {block_maxx_pos, true};
+	const knot_array block_minx = {block_minx_pos, true};
+	extrema_state st;
+	_extrema_begin(&st, x[0], block_maxx, maxy, block_minx, miny);
+	maxx[0] = 0;
+	minx[0] = 0;
+	if (N > 1) {
+		for (size_t i=0; i<N-1; i+=block_size) {
+			const size_t n = (N-1-i < block_size)? N-1-i : block_size;
+			const size_t found_max = st.nmax;
+			const size_t found_min = st.nmin;
+			st.nmax = 0;
+			st.nmin = 0;
+			_extrema_scan(&st, x+i, 0, n, block_maxx, maxy+found_max,
+					block_minx, miny+found_min);
+			for (size_t k=0; k<st.nmax; k++) {
+				maxx[found_max+k] = (double)i + 0.5*(double)(knot_offset)block_maxx_pos[k];
+			}
+			for (size_t k=0; k<st.nmin; k++) {
+				minx[found_min+k] = (double)i + 0.5*(double)(knot_offset)block_minx_pos[k];
+			}
+			st.nmax += found_max;
+			st.nmin += found_min;
+		}
+		maxx[st.nmax] = N-1;
+		maxy[st.nmax] = x[N-1];
+		st.nmax++;
+		minx[st.nmin] = N-1;
+		miny[st.nmin] = x[N-1];
+		st.nmin++;
+		if (st.nmax >= 4) {
+			_extrapolate_ends(maxy, st.nmax, N, maxx[1], maxx[2],
+					maxx[st.nmax-3], maxx[st.nmax-2], true);
+		}
+		if (st.nmin >= 4) {
+			_extrapolate_ends(miny, st.nmin, N, minx[1], minx[2],
+					minx[st.nmin-3], minx[st.nmin-2], false);
+		}
+	}
+	*nmax = st.nmax;
+	*nmin = st.nmin;
+	*nzc = st.nzc;
+}
+
+size_t emd_num_imfs(size_t N) {
+	if (N == 0) {
+		return 0;
+	}
+	if (N <= 3) {
+		return 1;
+	}
+	return (size_t)(log2(N));
+}
+
+// Helper function for solving the tridiagonal system Ax=g of size n, where the
+// matrix A is defined by the arrays diag (length n), supdiag and subdiag
+// (length n-1). This is the Thomas algorithm, i.e., Gaussian elimination
+// without pivoting, which is fine for the diagonally dominant systems arising
+// from spline interpolation. The elimination is done in place, so the
+// contents of diag and g are destroyed, and no extra memory is needed. The
+// operations are done in the same order as in gsl_linalg_solve_tridiag, so
+// the results agree with it up to rounding differences of a few ulps at most.
+static libeemd_error_code _solve_tridiag(double* restrict diag,
+		double const* restrict supdiag, double const* restrict subdiag,
+		double* restrict g, double* restrict x, size_t n) {
+	if (diag[0] == 0) {
+		return EMD_SINGULAR_SPLINE_SYSTEM;
+	}
+	// Forward elimination
+	for (size_t i=1; i<n; i++) {
+		const double t = subdiag[i-1]/diag[i-1];
+		diag[i] -= t*supdiag[i-1];
+		g[i] -= t*g[i-1];
+		if (diag[i] == 0) {
+			return EMD_SINGULAR_SPLINE_SYSTEM;
+		}
+	}
+	// Back substitution
+	x[n-1] = g[n-1]/diag[n-1];
+	for (size_t i=n-1; i-- > 0;) {
+		x[i] = (g[i] - supdiag[i]*x[i+1])/diag[i];
+	}
+	return EMD_SUCCESS;
+}
+
+// Helper function for describing the (N-2)x(N-2) tridiagonal linear system
+// Ac=g for the coefficients of a cubic spline with not-a-knot end conditions
+// for N >= 4 nodes at x. The matrix A is given by the arrays subdiag, diag and
+// supdiag, and it depends only on x.
+static void _spline_matrix(double const* restrict x, size_t N,
+		double* restrict diag, double* restrict supdiag, double* restrict subdiag) {
+	const size_t n = N-1;
+	// Define some constants for easier comparison with Engeln-Mullges & Uhlig
+	// and let the compiler optimize them away.
+	const double h_0 = x[1]-x[0];
+	const double h_1 = x[2]-x[1];
+	const double h_nm1 = x[n]-x[n-1];
+	const double h_nm2 = x[n-1]-x[n-2];
+	// first row
+	diag[0] = h_0 + 2*h_1;
+	supdiag[0] = h_1 - h_0;
+	// rows 2 to n-2
+	for (size_t i=2; i<=n-2; i++) {
+		const double h_i = x[i+1] - x[i];
+		const double h_im1 = x[i] - x[i-1];
+		
+		subdiag[i-2] = h_im1;
+		diag[i-1] = 2*(h_im1 + h_i);
+		supdiag[i-1] = h_i;
+	}
+	// final row
+	subdiag[n-3] = h_nm2 - h_nm1;
+	diag[n-2] = 2*h_nm2 + h_nm1;
+}
+
+// Helper function for computing the right hand side g of the system described
+// by _spline_matrix for nodes defined by the arrays x and y
+static void _spline_rhs(double const* restrict x, double const* restrict y,
+		size_t N, double* restrict g) {
+	const size_t n = N-1;
+	const double h_0 = x[1]-x[0];
+	const double h_1 = x[2]-x[1];
+	const double h_nm1 = x[n]-x[n-1];
+	const double h_nm2 = x[n-1]-x[n-2];
+	g[0] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
+	for (size_t i=2; i<=n-2; i++) {
+		const double h_i = x[i+1] - x[i];
+		const double h_im1 = x[i] - x[i-1];
+		g[i-1] = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
+	}
+	g[n-2] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]));
+}
+
+// Helper function for computing the rest of the spline coefficients once
+// c_1 ... c_{n-1} have been solved
+static void _spline_finish(double const* restrict x, double const* restrict y,
+		size_t N, double* restrict c, double* restrict b, double* restrict d) {
+	const size_t n = N-1;
+	const double h_0 = x[1]-x[0];
+	const double h_1 = x[2]-x[1];
+	const double h_nm1 = x[n]-x[n-1];
+	const double h_nm2 = x[n-1]-x[n-2];
+	// Compute c[0] and c[n]
+	c[0] = c[1] + (h_0/h_1)*(c[1]-c[2]);
+	c[n] = c[n-1] + (h_nm1/h_nm2)*(c[n-1]-c[n-2]);
+	// The coefficients b_i and d_i are computed from the c_i's once per
+	// interval
+	for (size_t i=0; i<n; i++) {
+		const double h_i = x[i+1] - x[i];
+		b[i] = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
+		d[i] = (c[i+1]-c[i])/(3.0*h_i);
+	}
+}
+
+// Same as _spline_matrix, _spline_rhs and _spline_finish for knots at the
+// doubled positions p, with identical results
+static void _knot_spline_matrix(knot_array p, size_t N,
+		double* restrict diag, double* restrict supdiag, double* restrict subdiag) {
+	const size_t n = N-1;
+	const double h_0 = _knot_h(p, 0);
+	const double h_1 = _knot_h(p, 1);
+	const double h_nm1 = _knot_h(p, n-1);
+	const double h_nm2 = _knot_h(p, n-2);
+	diag[0] = h_0 + 2*h_1;
+	supdiag[0] = h_1 - h_0;
+	for (size_t i=2; i<=n-2; i++) {
+		const double h_i = _knot_h(p, i);
+		const double h_im1 = _knot_h(p, i-1);
+		subdiag[i-2] = h_im1;
+		diag[i-1] = 2*(h_im1 + h_i);
+		supdiag[i-1] = h_i;
+	}
+	subdiag[n-3] = h_nm2 - h_nm1;
+	diag[n-2] = 2*h_nm2 + h_nm1;
+}
+
+static void _knot_spline_rhs(knot_array p, double const* restrict y,
+		size_t N, double* restrict g) {
+	const size_t n = N-1;
+	const double h_0 = _knot_h(p, 0);
+	const double h_1 = _knot_h(p, 1);
+	const double h_nm1 = _knot_h(p, n-1);
+	const double h_nm2 = _knot_h(p, n-2);
+	g[0] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
+	for (size_t i=2; i<=n-2; i++) {
+		const double h_i = _knot_h(p, i);
+		const double h_im1 = _knot_h(p, i-1);
+		g[i-1] = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
+	}
+	g[n-2] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]));
+}
+
+static void _knot_spline_finish(knot_array p, double const* restrict y,
+		size_t N, double* restrict c, double* restrict b, double* restrict d) {
+	const size_t n = N-1;
+	const double h_0 = _knot_h(p, 0);
+	const double h_1 = _knot_h(p, 1);
+	const double h_nm1 = _knot_h(p, n-1);
+	const double h_nm2 = _knot_h(p, n-2);
+	c[0] = c[1] + (h_0/h_1)*(c[1]-c[2]);
+	c[n] = c[n-1] + (h_nm1/h_nm2)*(c[n-1]-c[n-2]);
+	for (size_t i=0; i<n; i++) {
+		const double h_i = _knot_h(p, i);
+		b[i] = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
+		d[i] = (c[i+1]-c[i])/(3.0*h_i);
+	}
+}
+
+// Helper function for the forward elimination of _solve_tridiag without the
+// right hand side. The multipliers of the elimination replace the subdiagonal,
+// and diag is replaced by the diagonal of the eliminated matrix.
+static libeemd_error_code _factor_tridiag(double* restrict diag,
+		double const* restrict supdiag, double* restrict subdiag, size_t n) {
+	if (diag[0] == 0) {
+		return EMD_SINGULAR_SPLINE_SYSTEM;
+	}
+	for (size_t i=1; i<n; i++) {
+		const double t = subdiag[i-1]/diag[i-1];
+		subdiag[i-1] = t;
+		diag[i] -= t*supdiag[i-1];
+		if (diag[i] == 0) {
+			return EMD_SINGULAR_SPLINE_SYSTEM;
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+// Helper function for solving the tridiagonal system Ax=g of size n with A
+// factorized by _factor_tridiag. The contents of g are destroyed. The
+// operations are the same as in _solve_tridiag, so the results are identical.
+static void _solve_factored_tridiag(double const* restrict diag,
+		double const* restrict supdiag, double const* restrict mult,
+		double* restrict g, double* restrict x, size_t n) {
+	for (size_t i=1; i<n; i++) {
+		g[i] -= mult[i-1]*g[i-1];
+	}
+	x[n-1] = g[n-1]/diag[n-1];
+	for (size_t i=n-1; i-- > 0;) {
+		x[i] = (g[i] - supdiag[i]*x[i+1])/diag[i];
+	}
+}
+
+// Batched solver for tridiagonal systems
+//
+// Solving a single tridiagonal system is a long chain of dependent divisions
+// and multiplications, which leaves most of the execution units of the CPU
+// idle. A spline batch solves several independent systems at the same time.
+// They are copied to a structure-of-arrays layout, where element i of the
+// system in lane l is at i*lanes+l, so that the same step is done for all
+// lanes with one SIMD instruction and the dependency chains of the systems
+// overlap. Smaller systems are padded with identity rows to the size of the
+// largest one in the same group. If there are more systems than lanes, they
+// are sorted by size and solved in groups of similar sizes to keep the
+// padding small. The results are identical to solving each system with
+// _factor_tridiag and _solve_factored_tridiag.
+
+// Maximum number of systems solved at the same time
+#ifndef EEMD_SPLINE_BATCH_LANES
+#define EEMD_SPLINE_BATCH_LANES 4
+#endif
+
+// A system in a batch. The matrix is given by diag, supdiag and the
+// subdiagonal stored in mult. If factor is true, it is factorized in place as
+// by _factor_tridiag, otherwise diag and mult already hold the factorization.
+// The solution for the right hand side g is stored to x, and g is destroyed.
+typedef struct {
+	double* diag;
+	double const* supdiag;
+	double* mult;
+	double* g;
+	double* x;
+	size_t n;
+	bool factor;
+} spline_system;
+
+struct spline_batch {
+	size_t capacity;
+	size_t max_size;
+	size_t lanes;
+	size_t num_systems;
+	spline_system* systems;
+	// Order in which the systems are solved, largest first
+	size_t* order;
+	// Interleaved diagonal, superdiagonal, multipliers and right hand sides
+	// of the systems being solved, max_size*lanes doubles each
+	double* interleaved;
+};
+
+// Carve a batch for at most capacity systems of size at most max_size
+static spline_batch* _carve_spline_batch(arena* a, size_t capacity, size_t max_size) {
+	const size_t lanes = (capacity < EEMD_SPLINE_BATCH_LANES)? capacity : EEMD_SPLINE_BATCH_LANES;
+	spline_batch* batch = _arena_alloc(a, sizeof(spline_batch));
+	spline_system* systems = _arena_alloc(a, capacity*sizeof(spline_system));
+	size_t* order = _arena_alloc(a, capacity*sizeof(size_t));
+	double* interleaved = _arena_alloc(a, 4*max_size*lanes*sizeof(double));
+	if (batch == NULL) {
+		return NULL;
+	}
+	batch->capacity = capacity;
+	batch->max_size = max_size;
+	batch->lanes = lanes;
+	batch->num_systems = 0;
+	batch->systems = systems;
+	batch->order = order;
+	batch->interleaved = interleaved;
+	return batch;
+}
+
+// Remove all systems from a batch without solving them
+static inline void _spline_batch_clear(spline_batch* batch) {
+	batch->num_systems = 0;
+}
+
+// Add a system to be solved by _spline_batch_solve. The arrays are not
+// accessed before that.
+static void _spline_batch_add(spline_batch* restrict batch, double* diag,
+		double const* supdiag, double* mult, double* g, double* x, size_t n,
+		bool factor) {
+	assert(batch->num_systems < batch->capacity);
+	assert(n >= 1 && n <= batch->max_size);
+	spline_system* const sys = &batch->systems[batch->num_systems++];
+	sys->diag = diag;
+	sys->supdiag = supdiag;
+	sys->mult = mult;
+	sys->g = g;
+	sys->x = x;
+	sys->n = n;
+	sys->factor = factor;
+}
+
+// Helper function for copying a system of size m to lane l of interleaved
+// arrays of size n, or padding the lane with identity rows if sys is NULL
+static void _spline_system_gather(spline_system const* restrict sys,
+		size_t lanes, size_t l, size_t n, double* restrict D,
+		double* restrict S, double* restrict M, double* restrict G) {
+	const size_t m = (sys == NULL)? 0 : sys->n;
+	for (size_t i=0; i<m; i++) {
+		D[i*lanes+l] = sys->diag[i];
+		G[i*lanes+l] = sys->g[i];
+	}
+	for (size_t i=0; i+1<m; i++) {
+		S[i*lanes+l] = sys->supdiag[i];
+		M[i*lanes+l] = sys->mult[i];
+	}
+	for (size_t i=(m == 0)? 0 : m-1; i<n; i++) {
+		S[i*lanes+l] = 0;
+		M[i*lanes+l] = 0;
+	}
+	for (size_t i=m; i<n; i++) {
+		D[i*lanes+l] = 1;
+		G[i*lanes+l] = 0;
+	}
+}
+
+// Helper function for copying the solution and factorization in lane l of
+// interleaved arrays back to the arrays of a system
+static void _spline_system_scatter(spline_system const* restrict sys,
+		size_t lanes, size_t l, double const* restrict D,
+		double const* restrict M, double const* restrict X) {
+	const size_t m = sys->n;
+	for (size_t i=0; i<m; i++) {
+		sys->x[i] = X[i*lanes+l];
+	}
+	if (sys->factor) {
+		for (size_t i=0; i<m; i++) {
+			sys->diag[i] = D[i*lanes+l];
+		}
+		for (size_t i=0; i+1<m; i++) {
+			sys->mult[i] = M[i*lanes+l];
+		}
+	}
+}
+
+// Helper function for solving interleaved systems of size n in place. The
+// lanes for which factor is nonzero are factorized as by _factor_tridiag,
+// and the solutions replace the right hand sides in G. The lanes with a
+// singular matrix are marked in singular.
+static void _solve_interleaved_tridiag(size_t lanes, size_t n,
+		int const* restrict factor, double* restrict D, double const* restrict S,
+		double* restrict M, double* restrict G, int* restrict singular) {
+	for (size_t l=0; l<lanes; l++) {
+		singular[l] = (D[l] == 0);
+	}
+	// Factorization and forward elimination
+	for (size_t i=1; i<n; i++) {
+		double* const D_i = D + i*lanes;
+		double const* const D_p = D + (i-1)*lanes;
+		double const* const S_p = S + (i-1)*lanes;
+		double* const M_p = M + (i-1)*lanes;
+		double* const G_i = G + i*lanes;
+		double const* const G_p = G + (i-1)*lanes;
+		#pragma omp simd
+		for (size_t l=0; l<lanes; l++) {
+			const double t = factor[l]? M_p[l]/D_p[l] : M_p[l];
+			M_p[l] = t;
+			if (factor[l]) {
+				D_i[l] -= t*S_p[l];
+			}
+			G_i[l] -= t*G_p[l];
+			singular[l] |= (D_i[l] == 0);
+		}
+	}
+	// Back substitution
+	double* const G_last = G + (n-1)*lanes;
+	double const* const D_last = D + (n-1)*lanes;
+	#pragma omp simd
+	for (size_t l=0; l<lanes; l++) {
+		G_last[l] = G_last[l]/D_last[l];
+	}
+	for (size_t i=n-1; i-- > 0;) {
+		double* const G_i = G + i*lanes;
+		double const* const G_n = G + (i+1)*lanes;
+		double const* const D_i = D + i*lanes;
+		double const* const S_i = S + i*lanes;
+		#pragma omp simd
+		for (size_t l=0; l<lanes; l++) {
+			G_i[l] = (G_i[l] - S_i[l]*G_n[l])/D_i[l];
+		}
+	}
+}
+
+// Solve all systems added to a batch, and remove them from it. Returns
+// EMD_SINGULAR_SPLINE_SYSTEM if any of the matrices is singular.
+static libeemd_error_code _spline_batch_solve(spline_batch* restrict batch) {
+	const size_t num_systems = batch->num_systems;
+	const size_t lanes = batch->lanes;
+	spline_system const* const systems = batch->systems;
+	size_t* const order = batch->order;
+	batch->num_systems = 0;
+	// Sort the systems by decreasing size. There are only a few of them.
+	for (size_t k=0; k<num_systems; k++) {
+		size_t j = k;
+		while (j > 0 && systems[order[j-1]].n < systems[k].n) {
+			order[j] = order[j-1];
+			j--;
+		}
+		order[j] = k;
+	}
+	libeemd_error_code err = EMD_SUCCESS;
+	for (size_t first=0; first<num_systems; first+=lanes) {
+		const size_t group_size = (num_systems-first < lanes)? num_systems-first : lanes;
+		spline_system const* const largest = &systems[order[first]];
+		// A lone system is solved directly without copying it
+		if (group_size == 1) {
+			if (largest->factor) {
+				libeemd_error_code factor_err = _factor_tridiag(largest->diag,
+						largest->supdiag, largest->mult, largest->n);
+				if (factor_err != EMD_SUCCESS) {
+					err = factor_err;
+					continue;
+				}
+			}
+			_solve_factored_tridiag(largest->diag, largest->supdiag,
+					largest->mult, largest->g, largest->x, largest->n);
+			continue;
+		}
+		const size_t n = largest->n;
+		double* const D = batch->interleaved;
+		double* const S = D + n*lanes;
+		double* const M = S + n*lanes;
+		double* const G = M + n*lanes;
+		int factor[EEMD_SPLINE_BATCH_LANES];
+		int singular[EEMD_SPLINE_BATCH_LANES];
+		for (size_t l=0; l<lanes; l++) {
+			spline_system const* const sys = (l < group_size)? &systems[order[first+l]] : NULL;
+			factor[l] = (sys != NULL && sys->factor);
+			_spline_system_gather(sys, lanes, l, n, D, S, M, G);
+		}
+		_solve_interleaved_tridiag(lanes, n, factor, D, S, M, G, singular);
+		for (size_t l=0; l<group_size; l++) {
+			if (singular[l]) {
+				err = EMD_SINGULAR_SPLINE_SYSTEM;
+				continue;
+			}
+			_spline_system_scatter(&systems[order[first+l]], lanes, l, D, M, G);
+		}
+	}
+	return err;
+}
+
+// Helper function for computing the coefficients of a cubic spline with
+// not-a-knot end conditions for N >= 4 nodes defined by the arrays x and y.
+// On interval i, i.e., for x[i] <= t <= x[i+1], the spline is
+//   y[i] + b[i]*(t-x[i]) + c[i]*(t-x[i])^2 + d[i]*(t-x[i])^3,
+// where c (length N) is stored at the start of the workspace, followed by b
+// and d (length N-1 each). The workspace needs to hold 5*N-10 doubles.
+static libeemd_error_code _spline_coefficients(double const* restrict x,
+		double const* restrict y, size_t N, double* restrict spline_workspace) {
+	const size_t n = N-1;
+	// This algorithm is described in "Numerical Algorithms with C" by
+	// G. Engeln-Müllges and F. Uhlig, page 257.
+	//
+	// Extra homework assignment for anyone reading this: Implement this
+	// algorithm in GSL, so that next time someone needs these end conditions
+	// they can just use GSL.
+	const size_t sys_size = N-2;
+	double* const c = spline_workspace;
+	double* const diag = c+N;
+	double* const supdiag = diag + sys_size;
+	double* const subdiag = supdiag + (sys_size-1);
+	double* const g = subdiag + (sys_size-1);
+	_spline_matrix(x, N, diag, supdiag, subdiag);
+	_spline_rhs(x, y, N, g);
+	// Solve to get c_1 ... c_{n-1}
+	libeemd_error_code solve_err = _solve_tridiag(diag, supdiag, subdiag, g, c+1, n-1);
+	if (solve_err != EMD_SUCCESS) {
+		return solve_err;
+	}
+	// The linear system is no longer needed, so b and d can overwrite it
+	double* const b = c+N;
+	double* const d = b+n;
+	_spline_finish(x, y, N, c, b, d);
+	return EMD_SUCCESS;
+}
+
+// Same as _spline_coefficients for knots at the doubled positions x, but the
+// factorization of the linear system is kept in the workspace, so that it can
+// be reused for another spline with the same knots by setting reuse to true.
+// The workspace holds c (length N), the
+// factorization (3*N-8 doubles) and b and d (length N-1 each), and g is
+// stored in place of b while solving, so it needs 6*N-10 doubles in total.
+// The results are identical to _spline_coefficients.
+static libeemd_error_code _spline_coefficients_factored(knot_array x,
+		double const* restrict y, size_t N, double* restrict spline_workspace,
+		bool reuse) {
+	const size_t n = N-1;
+	const size_t sys_size = N-2;
+	double* const c = spline_workspace;
+	double* const diag = c+N;
+	double* const supdiag = diag + sys_size;
+	double* const mult = supdiag + (sys_size-1);
+	double* const b = mult + (sys_size-1);
+	double* const d = b+n;
+	double* const g = b;
+	if (!reuse) {
+		_knot_spline_matrix(x, N, diag, supdiag, mult);
+		libeemd_error_code factor_err = _factor_tridiag(diag, supdiag, mult, n-1);
+		if (factor_err != EMD_SUCCESS) {
+			return factor_err;
+		}
+	}
+	_knot_spline_rhs(x, y, N, g);
+	_solve_factored_tridiag(diag, supdiag, mult, g, c+1, n-1);
+	_knot_spline_finish(x, y, N, c, b, d);
+	return EMD_SUCCESS;
+}
+
+// Same as _spline_coefficients_factored, but the linear system is only set up
+// and added to a batch. Once the batch has been solved, the rest of the
+// coefficients are computed with _spline_coefficients_complete.
+static void _spline_coefficients_submit(knot_array x,
+		double const* restrict y, size_t N, double* restrict spline_workspace,
+		bool reuse, spline_batch* restrict batch) {
+	const size_t n = N-1;
+	const size_t sys_size = N-2;
+	double* const c = spline_workspace;
+	double* const diag = c+N;
+	double* const supdiag = diag + sys_size;
+	double* const mult = supdiag + (sys_size-1);
+	double* const g = mult + (sys_size-1);
+	if (!reuse) {
+		_knot_spline_matrix(x, N, diag, supdiag, mult);
+	}
+	_knot_spline_rhs(x, y, N, g);
+	_spline_batch_add(batch, diag, supdiag, mult, g, c+1, n-1, !reuse);
+}
+
+static void _spline_coefficients_complete(knot_array x,
+		double const* restrict y, size_t N, double* restrict spline_workspace) {
+	double* const c = spline_workspace;
+	double* const b = c + N + 3*(N-2) - 2;
+	double* const d = b + (N-1);
+	_knot_spline_finish(x, y, N, c, b, d);
+}
+
+// Helper function for evaluating the polynomial a+b*dx+c*dx^2+d*dx^3 at the
+// integer points j_start <= j <= j_end, where dx = j-x0, using the Horner
+// scheme. There are no dependencies between the iterations, so the compiler
+// is free to vectorize the loop.
+static inline void _eval_cubic(double a, double b, double c, double d,
+		double x0, size_t j_start, size_t j_end, double* restrict spline_y) {
+	for (size_t j=j_start; j<=j_end; j++) {
+		const double dx = (double)j-x0;
+		spline_y[j] = a + dx*(b + dx*(c + dx*d));
+	}
+}
+
+// Helper function for evaluating a spline computed with _spline_coefficients
+// at the integer points from 0 to x[N-1]. Each interval x[i] < j <= x[i+1] is
+// filled in one go with the coefficients of that interval.
+static void _spline_evaluate(double const* restrict x, double const* restrict y,
+		size_t N, double const* restrict spline_workspace, double* restrict spline_y) {
+	const size_t n = N-1;
+	double const* const c = spline_workspace;
+	double const* const b = c+N;
+	double const* const d = b+n;
+	spline_y[0] = y[0];
+	for (size_t i=0; i<n; i++) {
+		const size_t j_start = (size_t)x[i] + 1;
+		const size_t j_end = (size_t)x[i+1];
+		_eval_cubic(y[i], b[i], c[i], d[i], x[i], j_start, j_end, spline_y);
+	}
+}
+
+libeemd_error_code emd_evaluate_spline(double const* restrict x, double const* restrict y,
+		size_t N, double* restrict spline_y, double* restrict spline_workspace) {
+	gsl_set_error_handler_off();
+	if (N <= 1) {
+		return EMD_NOT_ENOUGH_POINTS_FOR_SPLINE;
+	}
+	const size_t n = N-1;
+	const size_t max_j = (size_t)x[n];
+	// perform more assertions only if EEMD_DEBUG is on,
+	// as this function is meant only for internal use
+	#if EEMD_DEBUG >= 1
+	if (x[0] != 0) {
+		return EMD_INVALID_SPLINE_POINTS;
+	}
+	for (size_t i=1; i<N; i++) {
+		if (x[i] <= x[i-1]) {
+			return EMD_INVALID_SPLINE_POINTS;
 		}
-		// Each thread allocates its own workspace
-		ws[thread_id] = allocate_eemd_workspace(N);
-		eemd_workspace* w = ws[thread_id];
-		// Precompute and store white noise, since for each mode of the data we
-		// need the same mode of the corresponding realization of noise
-		#pragma omp for
-		for (size_t en_i=0; en_i<ensemble_size; en_i++) {
-			// set rng seed based on ensemble member to ensure
-			// reproducibility even in a multithreaded case
-			set_rng_seed(w, rng_seed+en_i);
-			for (size_t j=0; j<N; j++) {
-				noises[N*en_i+j] = gsl_ran_gaussian(w->r, 1.0);
+	}
+	#endif
+	// Fall back to linear interpolation (for N==2) or polynomial interpolation
+	// (for N==3)
+	if (N <= 3) {
+		int gsl_status = gsl_poly_dd_init(spline_workspace, x, y, N);
+		if (gsl_status != GSL_SUCCESS) {
+			fprintf(stderr, "Error reported by gsl_poly_dd_init: %s\n",
+				gsl_strerror(gsl_status));
+			return EMD_GSL_ERROR;
+		}
+		for (size_t j=0; j<=max_j; j++) {
+			spline_y[j] = gsl_poly_dd_eval(spline_workspace, x, N, j);
+		}
+		return EMD_SUCCESS;
+	}
+	// For N >= 4, interpolate by using cubic splines with not-a-node end
+	// conditions.
+	libeemd_error_code coeff_err = _spline_coefficients(x, y, N, spline_workspace);
+	if (coeff_err != EMD_SUCCESS) {
+		return coeff_err;
+	}
+	_spline_evaluate(x, y, N, spline_workspace, spline_y);
+	return EMD_SUCCESS;
+}
+
+// An envelope of the signal is a spline through either its maxima or minima.
+// For evaluating the envelopes interval by interval, we need to keep track of
+// the coefficients and the current interval of both of them.
+typedef struct {
+	knot_array x;
+	double const* restrict y;
+	size_t N;
+	// For N >= 4 these point to the coefficients computed by
+	// _spline_coefficients, otherwise dd holds the divided differences for
+	// polynomial interpolation through the knots at dd_x
+	double const* restrict b;
+	double const* restrict c;
+	double const* restrict d;
+	double const* restrict dd;
+	double dd_x[3];
+	// The interval x[i] < j <= x[i+1] the evaluation has reached
+	size_t i;
+} envelope;
+
+// Memory needed from the spline workspace for an envelope through N points
+static inline size_t _envelope_workspace_size(size_t N) {
+	return (N <= 3)? N : 6*N-10;
+}
+
+// The part of the spline workspace used for the upper envelope through
+// num_max points or the lower envelope through num_min points. They never
+// overlap, and each stays at the same place if the number of its knots does
+// not change.
+static inline double* _envelope_workspace(sifting_workspace* restrict w,
+		bool upper, size_t N) {
+	if (upper) {
+		return w->spline_workspace;
+	}
+	return w->spline_workspace + w->spline_workspace_size - _envelope_workspace_size(N);
+}
+
+// Helper function for preparing the upper or lower envelope through the N
+// extrema stored in the sifting workspace for evaluation. If the knots are
+// the same as in the previous sifting iteration, the factorization of the
+// linear system for the spline coefficients is reused. If batch is not NULL,
+// the linear system is only added to it, and the envelope can be used after
+// solving the batch and calling _envelope_complete.
+static libeemd_error_code _envelope_init(envelope* restrict env,
+		sifting_workspace* restrict w, bool upper, size_t N,
+		spline_batch* restrict batch) {
+	const knot_array x = upper? w->maxx : w->minx;
+	double const* const y = upper? w->maxy : w->miny;
+	const knot_array prev_x = upper? w->next_maxx : w->next_minx;
+	size_t* const factored_N = upper? &w->factored_num_max : &w->factored_num_min;
+	const int k = upper? 0 : 1;
+	double* const spline_workspace = _envelope_workspace(w, upper, N);
+	const bool reuse = (N >= 4 && *factored_N == N
+			&& memcmp(x.p, prev_x.p, N*_knot_size(x.wide)) == 0);
+	*factored_N = 0;
+	if (N <= 1) {
+		return EMD_NOT_ENOUGH_POINTS_FOR_SPLINE;
+	}
+	env->x = x;
+	env->y = y;
+	env->N = N;
+	env->i = 0;
+	if (N <= 3) {
+		// Fall back to linear interpolation (for N==2) or polynomial
+		// interpolation (for N==3), same as emd_evaluate_spline
+		for (size_t i=0; i<N; i++) {
+			env->dd_x[i] = _knot_x(_knot_get(x, i));
+		}
+		int gsl_status = gsl_poly_dd_init(spline_workspace, env->dd_x, y, N);
+		if (gsl_status != GSL_SUCCESS) {
+			fprintf(stderr, "Error reported by gsl_poly_dd_init: %s\n",
+				gsl_strerror(gsl_status));
+			return EMD_GSL_ERROR;
+		}
+		env->dd = spline_workspace;
+		env->b = env->c = env->d = NULL;
+		return EMD_SUCCESS;
+	}
+	if (batch != NULL) {
+		_spline_coefficients_submit(x, y, N, spline_workspace, reuse, batch);
+	}
+	else {
+		libeemd_error_code coeff_err = _spline_coefficients_factored(x, y, N,
+				spline_workspace, reuse);
+		if (coeff_err != EMD_SUCCESS) {
+			return coeff_err;
+		}
+	}
+	*factored_N = N;
+	w->num_envelopes[k]++;
+	if (reuse) {
+		w->num_reused[k]++;
+	}
+	env->dd = NULL;
+	env->c = spline_workspace;
+	env->b = env->c + N + 3*(N-2) - 2;
+	env->d = env->b + (N-1);
+	return EMD_SUCCESS;
+}
+
+// Helper function for finishing an envelope prepared by _envelope_init with a
+// batch, after the batch has been solved
+static void _envelope_complete(envelope const* restrict env,
+		sifting_workspace* restrict w, bool upper) {
+	if (env->dd == NULL) {
+		_spline_coefficients_complete(env->x, env->y, env->N,
+				_envelope_workspace(w, upper, env->N));
+	}
+}
+
+// Value of an envelope at integer point j, which must be within the current
+// interval of the envelope (or zero)
+static inline double _envelope_value(envelope const* restrict env, size_t j) {
+	if (env->dd != NULL) {
+		return gsl_poly_dd_eval(env->dd, env->dd_x, env->N, j);
+	}
+	if (j == 0) {
+		return env->y[0];
+	}
+	const size_t i = env->i;
+	const double dx = (double)j-_knot_x(_knot_get(env->x, i));
+	return env->y[i] + dx*(env->b[i] + dx*(env->c[i] + dx*env->d[i]));
+}
+
+// Move an envelope to the interval containing j > 0 and return the last
+// integer point of that interval
+static inline size_t _envelope_seek(envelope* restrict env, size_t j) {
+	while (_knot(j, 0) > _knot_get(env->x, env->i+1)) {
+		env->i++;
+	}
+	return (size_t)(_knot_get(env->x, env->i+1)/2);
+}
+
+// Move an envelope directly to the interval containing j > 0 with a binary
+// search, for starting the evaluation in the middle of the data
+static inline void _envelope_locate(envelope* restrict env, size_t j) {
+	size_t lo = 0;
+	size_t hi = env->N-1;
+	while (hi-lo > 1) {
+		const size_t mid = lo + (hi-lo)/2;
+		if (_knot(j, 0) > _knot_get(env->x, mid)) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	env->i = lo;
+}
+
+// Helper function for subtracting the mean of the upper and lower envelopes
+// from the points j_start <= j <= j_end of input. The envelopes must be at
+// the interval containing j_start (or at the first interval if j_start is
+// zero), and they are left at the interval containing j_end.
+static void _subtract_envelope_mean(double* restrict input,
+		envelope* restrict upper, envelope* restrict lower,
+		size_t j_start, size_t j_end) {
+	const bool both_cubic = (upper->dd == NULL && lower->dd == NULL);
+	size_t j = j_start;
+	// The first point is handled separately, since it is not within any
+	// interval
+	if (j == 0) {
+		input[0] -= 0.5*(_envelope_value(upper, 0) + _envelope_value(lower, 0));
+		j = 1;
+	}
+	// Go through the points in runs where neither envelope changes interval
+	while (j <= j_end) {
+		const size_t upper_end = _envelope_seek(upper, j);
+		const size_t lower_end = _envelope_seek(lower, j);
+		size_t run_end = (upper_end < lower_end)? upper_end : lower_end;
+		if (run_end > j_end) {
+			run_end = j_end;
+		}
+		if (both_cubic) {
+			// Evaluate both envelopes with the Horner scheme
+			const size_t iu = upper->i;
+			const double xu = _knot_x(_knot_get(upper->x, iu)), au = upper->y[iu], bu = upper->b[iu],
+			             cu = upper->c[iu], du = upper->d[iu];
+			const size_t il = lower->i;
+			const double xl = _knot_x(_knot_get(lower->x, il)), al = lower->y[il], bl = lower->b[il],
+			             cl = lower->c[il], dl = lower->d[il];
+			for (size_t k=j; k<=run_end; k++) {
+				const double dxu = (double)k-xu;
+				const double dxl = (double)k-xl;
+				const double u = au + dxu*(bu + dxu*(cu + dxu*du));
+				const double l = al + dxl*(bl + dxl*(cl + dxl*dl));
+				input[k] -= 0.5*(u + l);
 			}
 		}
-	} // Return to sequental mode
-	// Allocate memory for the residual shared among all threads
-	double* restrict res = malloc(N*sizeof(double));
-	// For the first iteration the residual is the input signal
-	array_copy(input, N, res);
-	// Each mode is extracted sequentially, but we use parallelization in the inner loop
-	// to loop over ensemble members
-	for (size_t imf_i=0; imf_i<M; imf_i++) {
-		// Provide a pointer to the output vector where this IMF will be stored
-		double* const imf = &output[imf_i*N];
-		// Then we go parallel to compute the different ensemble members
-		libeemd_error_code sift_err = EMD_SUCCESS;
-		#pragma omp parallel
-		{
-			#ifdef _OPENMP
-			const int thread_id = omp_get_thread_num();
-			#else
-			const int thread_id = 0;
-			#endif
-			eemd_workspace* w = ws[thread_id];
-			unsigned int sift_counter = 0;
-			#pragma omp for
-			for (size_t en_i=0; en_i<ensemble_size; en_i++) {
-				// Check if an error has occured in other threads
-				#pragma omp flush(sift_err)
-				if (sift_err != EMD_SUCCESS) {
-					continue;
-				}
-				// Provide a pointer to the noise vector and noise residual used by
-				// this ensemble member
-				double* const noise = &noises[N*en_i];
-				double* const noise_residual = &noise_residuals[N*en_i];
-				// Initialize input signal as data + noise.
-				// The noise standard deviation is noise_strength times the
-				// standard deviation of input data divided by the standard
-				// deviation of the noise. This is used to fix the SNR at each
-				// stage.
-				const double noise_sd = gsl_stats_sd(noise, 1, N);
-				const double noise_sigma = (noise_sd != 0)? noise_strength*gsl_stats_sd(res, 1, N)/noise_sd : 0;
-				array_addmul_to(res, noise, noise_sigma, N, w->x);
-				// Sift to extract first EMD mode
-				sift_err = _sift(w->x, w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
-				#pragma omp flush(sift_err)
-				// Sum to output vector
-				get_lock(output_lock);
-				array_add(w->x, N, imf);
-				release_lock(output_lock);
-				// Extract next EMD mode of the noise. This is used as the noise for
-				// the next mode extracted from the data
-				if (imf_i == 0) {
-					array_copy(noise, N, noise_residual);
-				}
-				else {
-					array_copy(noise_residual, N, noise);
-				}
-				sift_err = _sift(noise, w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
-				#pragma omp flush(sift_err)
-				array_sub(noise, N, noise_residual);
+		else {
+			for (size_t k=j; k<=run_end; k++) {
+				input[k] -= 0.5*(_envelope_value(upper, k) + _envelope_value(lower, k));
+			}
+		}
+		j = run_end + 1;
+	}
+}
+
+// Helper function for performing a single sifting iteration, i.e.,
+// subtracting the mean of the upper and lower envelopes from input. The
+// envelopes are splines through the num_max maxima and num_min minima stored
+// in the workspace. Instead of storing the envelopes in arrays, they are
+// evaluated in blocks that fit in the cache, and the means are subtracted
+// right away. If find_next is true, the extrema of the result are also found
+// block by block, and stored to the arrays for the next iteration in the
+// workspace. The results are identical to what evaluating the envelopes with
+// emd_evaluate_spline and running emd_find_extrema afterwards would give.
+static libeemd_error_code _sift_once(double* restrict input,
+		sifting_workspace* restrict w, size_t num_max, size_t num_min,
+		bool find_next, size_t* next_num_max, size_t* next_num_min,
+		size_t* next_num_zc) {
+	const size_t N = w->N;
+	// Compute the coefficients of both envelopes, solving their linear
+	// systems together
+	envelope upper, lower;
+	_spline_batch_clear(w->envelope_batch);
+	libeemd_error_code max_errcode = _envelope_init(&upper, w, true, num_max,
+			w->envelope_batch);
+	if (max_errcode != EMD_SUCCESS) {
+		return max_errcode;
+	}
+	libeemd_error_code min_errcode = _envelope_init(&lower, w, false, num_min,
+			w->envelope_batch);
+	if (min_errcode != EMD_SUCCESS) {
+		return min_errcode;
+	}
+	libeemd_error_code solve_errcode = _spline_batch_solve(w->envelope_batch);
+	if (solve_errcode != EMD_SUCCESS) {
+		return solve_errcode;
+	}
+	_envelope_complete(&upper, w, true);
+	_envelope_complete(&lower, w, false);
+	extrema_state st;
+	const size_t block_size = 512;
+	for (size_t block_start=0; block_start<N; block_start+=block_size) {
+		const size_t block_end = (N-block_start < block_size)? N-1 : block_start+block_size-1;
+		_subtract_envelope_mean(input, &upper, &lower, block_start, block_end);
+		// The block is now final, so look for extrema in it
+		if (find_next) {
+			if (block_start == 0) {
+				_extrema_begin(&st, input[0], w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
+			}
+			const size_t scan_start = (block_start == 0)? 0 : block_start-1;
+			_extrema_scan(&st, input, scan_start, block_end,
+					w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
+		}
+	}
+	if (find_next) {
+		_extrema_end(&st, input[N-1], N, w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
+		*next_num_max = st.nmax;
+		*next_num_min = st.nmin;
+		*next_num_zc = st.nzc;
+	}
+	return EMD_SUCCESS;
+}
+
+// Single-precision sifting
+//
+// These are the same as _sift_once, _sift and _emd, but for signals stored as
+// floats, which halves the memory traffic of sifting. The values of the
+// extrema are still stored as doubles, where they are exact, and the spline
+// coefficients of the envelopes are computed from them in double precision
+// exactly as for double signals. The envelopes are also evaluated in double
+// precision: between two knots there are usually only a few points, so
+// evaluating them as floats would gain little, and the rounding errors of the
+// envelope mean would show up as spurious extrema in the slowly varying modes.
+
+// Process the float data points from i_start to i_end like _extrema_scan. The
+// data is converted to doubles in small blocks for _extrema_scan_scalar,
+// which gives positions relative to the start of the block. Adding the start
+// wraps around correctly for flat regions continuing from the previous block,
+// also for narrow positions, which wrap around at 32 bits.
+static void _extrema_scan_float_generic(extrema_state* restrict st,
+		float const* restrict x, size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	const size_t block_size = 64;
+	double block[64+1];
+	for (size_t i=i_start; i<i_end; i+=block_size) {
+		const size_t n = (i_end-i < block_size)? i_end-i : block_size;
+		for (size_t k=0; k<=n; k++) {
+			block[k] = x[i+k];
+		}
+		const size_t nmax = st->nmax;
+		const size_t nmin = st->nmin;
+		_extrema_scan_scalar(st, block, 0, n, maxx, maxy, minx, miny);
+		for (size_t k=nmax; k<st->nmax; k++) {
+			_knot_set(maxx, k, _knot_get(maxx, k) + _knot(i, 0));
+		}
+		for (size_t k=nmin; k<st->nmin; k++) {
+			_knot_set(minx, k, _knot_get(minx, k) + _knot(i, 0));
+		}
+	}
+}
+
+#if EEMD_X86_SIMD
+// Same as _extrema_scan_avx2, but for eight floats at a time
+__attribute__((target("avx2")))
+static void _extrema_scan_float_avx2(extrema_state* restrict st,
+		float const* restrict x, size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	const __m256 zero = _mm256_setzero_ps();
+	size_t i = i_start;
+	for (; i+8 <= i_end; i+=8) {
+		if (!_extrema_fast_state(st, x[i])) {
+			_extrema_scan_float_generic(st, x, i, i+8, maxx, maxy, minx, miny);
+			continue;
+		}
+		const __m256 a = _mm256_loadu_ps(x+i);
+		const __m256 b = _mm256_loadu_ps(x+i+1);
+		const unsigned int up = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(b, a, _CMP_GT_OQ));
+		const unsigned int down = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(b, a, _CMP_LT_OQ));
+		const unsigned int pos = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(b, zero, _CMP_GT_OQ));
+		const unsigned int neg = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ));
+		if ((up | down) != 0xff || (pos | neg) != 0xff) {
+			_extrema_scan_float_generic(st, x, i, i+8, maxx, maxy, minx, miny);
+			continue;
+		}
+		unsigned int maxmask, minmask;
+		_extrema_chunk_masks(st, 8, up, pos, &maxmask, &minmask);
+		while (maxmask) {
+			const unsigned int k = (unsigned int)__builtin_ctz(maxmask);
+			_knot_set(maxx, st->nmax, _knot(i+k, 0));
+			maxy[st->nmax] = x[i+k];
+			st->nmax++;
+			maxmask &= maxmask-1;
+		}
+		while (minmask) {
+			const unsigned int k = (unsigned int)__builtin_ctz(minmask);
+			_knot_set(minx, st->nmin, _knot(i+k, 0));
+			miny[st->nmin] = x[i+k];
+			st->nmin++;
+			minmask &= minmask-1;
+		}
+	}
+	_extrema_scan_float_generic(st, x, i, i_end, maxx, maxy, minx, miny);
+}
+#endif
+
+static inline void _extrema_scan_float(extrema_state* restrict st,
+		float const* restrict x, size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	#if EEMD_X86_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		_extrema_scan_float_avx2(st, x, i_start, i_end, maxx, maxy, minx, miny);
+		return;
+	}
+	#endif
+	_extrema_scan_float_generic(st, x, i_start, i_end, maxx, maxy, minx, miny);
+}
+
+// Same as emd_find_extrema for float data
+static void _find_extrema_float(float const* restrict x, size_t N,
+		knot_array maxx, double* restrict maxy, size_t* nmax,
+		knot_array minx, double* restrict miny, size_t* nmin,
+		size_t* nzc) {
+	*nmax = 0;
+	*nmin = 0;
+	*nzc = 0;
+	if (N == 0) {
+		return;
+	}
+	extrema_state st;
+	_extrema_begin(&st, x[0], maxx, maxy, minx, miny);
+	if (N > 1) {
+		_extrema_scan_float(&st, x, 0, N-1, maxx, maxy, minx, miny);
+		_extrema_end(&st, x[N-1], N, maxx, maxy, minx, miny);
+	}
+	*nmax = st.nmax;
+	*nmin = st.nmin;
+	*nzc = st.nzc;
+}
+
+// Same as _subtract_envelope_mean for float data. The envelopes are
+// evaluated and subtracted in double precision, and only the result is
+// rounded to a float.
+static void _subtract_envelope_mean_float(float* restrict input,
+		envelope* restrict upper, envelope* restrict lower,
+		size_t j_start, size_t j_end) {
+	const bool both_cubic = (upper->dd == NULL && lower->dd == NULL);
+	size_t j = j_start;
+	if (j == 0) {
+		input[0] = (float)(input[0] - 0.5*(_envelope_value(upper, 0) + _envelope_value(lower, 0)));
+		j = 1;
+	}
+	while (j <= j_end) {
+		const size_t upper_end = _envelope_seek(upper, j);
+		const size_t lower_end = _envelope_seek(lower, j);
+		size_t run_end = (upper_end < lower_end)? upper_end : lower_end;
+		if (run_end > j_end) {
+			run_end = j_end;
+		}
+		if (both_cubic) {
+			const size_t iu = upper->i;
+			const double xu = _knot_x(_knot_get(upper->x, iu)), au = upper->y[iu], bu = upper->b[iu],
+			             cu = upper->c[iu], du = upper->d[iu];
+			const size_t il = lower->i;
+			const double xl = _knot_x(_knot_get(lower->x, il)), al = lower->y[il], bl = lower->b[il],
+			             cl = lower->c[il], dl = lower->d[il];
+			for (size_t k=j; k<=run_end; k++) {
+				const double dxu = (double)k-xu;
+				const double dxl = (double)k-xl;
+				const double u = au + dxu*(bu + dxu*(cu + dxu*du));
+				const double l = al + dxl*(bl + dxl*(cl + dxl*dl));
+				input[k] = (float)(input[k] - 0.5*(u + l));
+			}
+		}
+		else {
+			for (size_t k=j; k<=run_end; k++) {
+				input[k] = (float)(input[k] - 0.5*(_envelope_value(upper, k) + _envelope_value(lower, k)));
+			}
+		}
+		j = run_end + 1;
+	}
+}
+
+// Same as _sift_once for float data
+static libeemd_error_code _sift_once_float(float* restrict input,
+		sifting_workspace* restrict w, size_t num_max, size_t num_min,
+		bool find_next, size_t* next_num_max, size_t* next_num_min,
+		size_t* next_num_zc) {
+	const size_t N = w->N;
+	envelope upper, lower;
+	_spline_batch_clear(w->envelope_batch);
+	libeemd_error_code max_errcode = _envelope_init(&upper, w, true, num_max,
+			w->envelope_batch);
+	if (max_errcode != EMD_SUCCESS) {
+		return max_errcode;
+	}
+	libeemd_error_code min_errcode = _envelope_init(&lower, w, false, num_min,
+			w->envelope_batch);
+	if (min_errcode != EMD_SUCCESS) {
+		return min_errcode;
+	}
+	libeemd_error_code solve_errcode = _spline_batch_solve(w->envelope_batch);
+	if (solve_errcode != EMD_SUCCESS) {
+		return solve_errcode;
+	}
+	_envelope_complete(&upper, w, true);
+	_envelope_complete(&lower, w, false);
+	extrema_state st;
+	const size_t block_size = 1024;
+	for (size_t block_start=0; block_start<N; block_start+=block_size) {
+		const size_t block_end = (N-block_start < block_size)? N-1 : block_start+block_size-1;
+		_subtract_envelope_mean_float(input, &upper, &lower, block_start, block_end);
+		if (find_next) {
+			if (block_start == 0) {
+				_extrema_begin(&st, input[0], w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
 			}
-		} // Parallel section ends
+			const size_t scan_start = (block_start == 0)? 0 : block_start-1;
+			_extrema_scan_float(&st, input, scan_start, block_end,
+					w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
+		}
+	}
+	if (find_next) {
+		_extrema_end(&st, input[N-1], N, w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
+		*next_num_max = st.nmax;
+		*next_num_min = st.nmin;
+		*next_num_zc = st.nzc;
+	}
+	return EMD_SUCCESS;
+}
+
+static libeemd_error_code _sift_float(float* restrict input, sifting_workspace*
+		restrict w, unsigned int S_number, unsigned int num_siftings, unsigned int*
+		sift_counter) {
+	const size_t N = w->N;
+	*sift_counter = 0;
+	unsigned int S_counter = 0;
+	size_t num_max = (size_t)(-1);
+	size_t num_min = (size_t)(-1);
+	size_t num_zc = (size_t)(-1);
+	size_t prev_num_max = (size_t)(-1);
+	size_t prev_num_min = (size_t)(-1);
+	size_t prev_num_zc = (size_t)(-1);
+	bool have_extrema = false;
+	w->factored_num_max = 0;
+	w->factored_num_min = 0;
+	size_t next_num_max = 0;
+	size_t next_num_min = 0;
+	size_t next_num_zc = 0;
+	while (num_siftings == 0 || *sift_counter < num_siftings) {
+		(*sift_counter)++;
+		prev_num_max = num_max;
+		prev_num_min = num_min;
+		prev_num_zc = num_zc;
+		if (have_extrema) {
+			num_max = next_num_max;
+			num_min = next_num_min;
+			num_zc = next_num_zc;
+		}
+		else {
+			_find_extrema_float(input, N, w->maxx, w->maxy, &num_max, w->minx, w->miny, &num_min, &num_zc);
+		}
+		if (S_number != 0 && _s_number_converged(S_number, &S_counter,
+					num_max, num_min, num_zc, prev_num_max, prev_num_min, prev_num_zc)) {
+			break;
+		}
+		const bool find_next = (num_siftings == 0 || *sift_counter < num_siftings);
+		libeemd_error_code sift_err = _sift_once_float(input, w, num_max, num_min,
+				find_next, &next_num_max, &next_num_min, &next_num_zc);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		if (find_next) {
+			_swap_extrema(w);
+			have_extrema = true;
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+// Helper function for adding n floats to the elements of a sum array of
+// floats or doubles starting from offset
+static inline void _add_to_sum(float const* restrict src, size_t n,
+		emd_precision sum_precision, void* restrict sum, size_t offset) {
+	if (sum_precision == EMD_PRECISION_DOUBLE) {
+		double* const dest = (double*)sum + offset;
+		for (size_t i=0; i<n; i++) {
+			dest[i] += src[i];
+		}
+	}
+	else {
+		float* const dest = (float*)sum + offset;
+		for (size_t i=0; i<n; i++) {
+			dest[i] += src[i];
+		}
+	}
+}
+
+// Same as _emd for float data, using res for the residual. The IMFs are added
+// to the N*M sum matrix, which holds either floats or doubles.
+static libeemd_error_code _emd_float(float* restrict input, float* restrict res,
+		sifting_workspace* restrict w, emd_precision sum_precision,
+		void* restrict sum, size_t M, unsigned int S_number,
+		unsigned int num_siftings) {
+	const size_t N = w->N;
+	memcpy(res, input, N*sizeof(float));
+	unsigned int sift_counter;
+	for (size_t imf_i=0; imf_i<M-1; imf_i++) {
+		if (imf_i != 0) {
+			memcpy(input, res, N*sizeof(float));
+		}
+		libeemd_error_code sift_err = _sift_float(input, w, S_number, num_siftings, &sift_counter);
 		if (sift_err != EMD_SUCCESS) {
 			return sift_err;
 		}
-		// Divide with ensemble size to get the average
-		array_mult(imf, N, one_per_ensemble_size);
-		// Subtract this IMF from the previous residual to form the new one
-		array_sub(imf, N, res);
+		for (size_t i=0; i<N; i++) {
+			res[i] -= input[i];
+		}
+		_add_to_sum(input, N, sum_precision, sum, N*imf_i);
+	}
+	_add_to_sum(res, N, sum_precision, sum, N*(M-1));
+	return EMD_SUCCESS;
+}
+
+// Sifting a single signal with all threads of a team
+//
+// The signal is divided into num_chunks contiguous chunks, and each step of a
+// sifting iteration is a worksharing loop over the chunks. All threads of the
+// team must therefore call these functions together, and the team may have at
+// most num_chunks threads. The spline coefficients of envelopes with at least
+// parallel_solve_min_knots knots are computed by the whole team, one envelope
+// at a time, with a partitioned solver for the linear system. Smaller
+// envelopes are computed by two threads while the others wait. The extrema of
+// each chunk are found to separate arrays, starting from the state the
+// sequential search would have at the start of the chunk, and then
+// concatenated. The results are identical to sequential sifting, except that
+// the partitioned solver changes the spline coefficients by rounding errors,
+// which then depend on the number of threads.
+struct sifting_team {
+	size_t N;
+	size_t num_chunks;
+	// Extrema and spline workspace shared by the team
+	sifting_workspace* sift_w;
+	// Extrema found in chunk c: chunk_capacity positions of the maxima and
+	// the minima starting at chunk_positions[2*c*chunk_capacity], and as many
+	// values starting at chunk_values[2*c*chunk_capacity]
+	size_t chunk_capacity;
+	knot_array chunk_positions;
+	double* chunk_values;
+	extrema_state* chunk_states;
+	// Envelopes, errors and numbers of extrema shared by the team
+	envelope upper;
+	envelope lower;
+	libeemd_error_code upper_err;
+	libeemd_error_code lower_err;
+	size_t num_max;
+	size_t num_min;
+	size_t num_zc;
+	// Partitioned solver: the minimum number of knots (zero means never),
+	// room for the two spikes of the largest possible system, the
+	// coefficients of the reduced system and the errors of each partition
+	size_t parallel_solve_min_knots;
+	double* spikes;
+	double* reduced;
+	libeemd_error_code* partition_errs;
+	libeemd_error_code solve_err;
+};
+
+static sifting_team* _carve_sifting_team(arena* a, size_t N, size_t num_chunks,
+		size_t parallel_solve_min_knots) {
+	sifting_team* team = _arena_alloc(a, sizeof(sifting_team));
+	double* spikes = NULL;
+	double* reduced = NULL;
+	libeemd_error_code* partition_errs = NULL;
+	if (parallel_solve_min_knots != 0) {
+		spikes = _arena_alloc(a, 2*_max_num_extrema(N)*sizeof(double));
+		reduced = _arena_alloc(a, 6*num_chunks*sizeof(double));
+		partition_errs = _arena_alloc(a, num_chunks*sizeof(libeemd_error_code));
+	}
+	sifting_workspace* sift_w = _carve_sifting_workspace(a, N);
+	// A chunk of L differences has at most (L+1)/2 maxima and as many minima
+	const size_t max_chunk_length = (N-1)/num_chunks + 1;
+	const size_t chunk_capacity = max_chunk_length/2 + 1;
+	const knot_array chunk_positions = {_arena_alloc(a,
+			2*num_chunks*chunk_capacity*_knot_size(_knots_wide(N))), _knots_wide(N)};
+	double* chunk_values = _arena_alloc(a, 2*num_chunks*chunk_capacity*sizeof(double));
+	extrema_state* chunk_states = _arena_alloc(a, num_chunks*sizeof(extrema_state));
+	if (team == NULL) {
+		return NULL;
+	}
+	team->N = N;
+	team->num_chunks = num_chunks;
+	team->parallel_solve_min_knots = parallel_solve_min_knots;
+	team->spikes = spikes;
+	team->reduced = reduced;
+	team->partition_errs = partition_errs;
+	team->sift_w = sift_w;
+	team->chunk_capacity = chunk_capacity;
+	team->chunk_positions = chunk_positions;
+	team->chunk_values = chunk_values;
+	team->chunk_states = chunk_states;
+	return team;
+}
+
+static size_t _sifting_team_num_chunks(sifting_team const* team) {
+	return team->num_chunks;
+}
+
+static sifting_workspace* _sifting_team_workspace(sifting_team* team) {
+	return team->sift_w;
+}
+
+// Set the state of the extrema search to what it would be after processing
+// the data points from 0 to i sequentially, by looking backwards from i. The
+// numbers of extrema and zero crossings are set to zero.
+static void _extrema_state_at(extrema_state* restrict st, double const* restrict x, size_t i) {
+	st->nmax = 0;
+	st->nmin = 0;
+	st->nzc = 0;
+	// The flat region, if any, ends at i, and the slope is that of the last
+	// difference before it
+	size_t k = i;
+	int flat_counter = 0;
+	while (k > 0 && !(x[k] > x[k-1]) && !(x[k] < x[k-1])) {
+		flat_counter++;
+		k--;
+	}
+	st->flat_counter = flat_counter;
+	st->previous_slope = (k == 0)? NONE : ((x[k] > x[k-1])? UP : DOWN);
+	// The sign changes only when going up to a positive value or down to a
+	// negative value, so the last such difference determines it
+	st->previous_sign = (x[0] < -0)? NEG : ((x[0] > 0)? POS : ZERO);
+	for (size_t j=i; j>0; j--) {
+		if (x[j] > x[j-1] && x[j] > 0) {
+			st->previous_sign = POS;
+			break;
+		}
+		if (x[j] < x[j-1] && x[j] < -0) {
+			st->previous_sign = NEG;
+			break;
+		}
+	}
+}
+
+// Partitions of the tridiagonal system solved by _solve_tridiag_team have at
+// least this many rows, so that there is enough work to share
+#define _MIN_PARTITION_SIZE 1024
+
+// Same as _solve_tridiag, but done by the team with the SPIKE algorithm. The
+// system is divided into partitions, and each thread solves its partitions
+// independently, both for g and for the two "spikes": the responses of the
+// partition to the unknowns just outside it. The unknowns at the boundaries of
+// the partitions are then solved from a small reduced system, and the rest are
+// corrected with them. The results differ from _solve_tridiag by rounding
+// errors.
+static libeemd_error_code _solve_tridiag_team(double* restrict diag,
+		double const* restrict supdiag, double const* restrict subdiag,
+		double* restrict g, double* restrict x, size_t n,
+		sifting_team* restrict team) {
+	size_t num_parts = n/_MIN_PARTITION_SIZE;
+	if (num_parts > team->num_chunks) {
+		num_parts = team->num_chunks;
+	}
+	if (num_parts < 2) {
+		#pragma omp single
+		team->solve_err = _solve_tridiag(diag, supdiag, subdiag, g, x, n);
+		return team->solve_err;
+	}
+	// Spike v is the solution for the left neighbour x[s-1] with coefficient
+	// subdiag[s-1], and w for the right neighbour x[e] with supdiag[e-1]
+	double* const v = team->spikes;
+	double* const w = team->spikes + n;
+	#pragma omp for schedule(static)
+	for (size_t k=0; k<num_parts; k++) {
+		const size_t s = _chunk_start(n, num_parts, k);
+		const size_t e = _chunk_start(n, num_parts, k+1);
+		team->partition_errs[k] = EMD_SUCCESS;
+		for (size_t i=s; i<e; i++) {
+			v[i] = 0;
+			w[i] = 0;
+		}
+		if (k > 0) {
+			v[s] = subdiag[s-1];
+		}
+		if (k < num_parts-1) {
+			w[e-1] = supdiag[e-1];
+		}
+		// Forward elimination with three right-hand sides
+		if (diag[s] == 0) {
+			team->partition_errs[k] = EMD_SINGULAR_SPLINE_SYSTEM;
+			continue;
+		}
+		for (size_t i=s+1; i<e; i++) {
+			const double t = subdiag[i-1]/diag[i-1];
+			diag[i] -= t*supdiag[i-1];
+			g[i] -= t*g[i-1];
+			v[i] -= t*v[i-1];
+			w[i] -= t*w[i-1];
+			if (diag[i] == 0) {
+				team->partition_errs[k] = EMD_SINGULAR_SPLINE_SYSTEM;
+				break;
+			}
+		}
+		if (team->partition_errs[k] != EMD_SUCCESS) {
+			continue;
+		}
+		// Back substitution
+		x[e-1] = g[e-1]/diag[e-1];
+		v[e-1] /= diag[e-1];
+		w[e-1] /= diag[e-1];
+		for (size_t i=e-1; i-- > s;) {
+			x[i] = (g[i] - supdiag[i]*x[i+1])/diag[i];
+			v[i] = (v[i] - supdiag[i]*v[i+1])/diag[i];
+			w[i] = (w[i] - supdiag[i]*w[i+1])/diag[i];
+		}
+	}
+	// The reduced system for the last unknown a[j] of partition j and the
+	// first unknown b[j] of partition j+1 is
+	//   a[j] + v[last of j]*a[j-1] + w[last of j]*b[j] = x[last of j]
+	//   v[first of j+1]*a[j] + b[j] + w[first of j+1]*b[j+1] = x[first of j+1]
+	// It is solved by eliminating it to the form
+	//   a[j] = R[j] + S[j]*b[j+1], b[j] = P[j] + Q[j]*b[j+1]
+	double* const a = team->reduced;
+	double* const b = a + num_parts;
+	double* const P = b + num_parts;
+	double* const Q = P + num_parts;
+	double* const R = Q + num_parts;
+	double* const S = R + num_parts;
+	#pragma omp single
+	{
+		team->solve_err = EMD_SUCCESS;
+		for (size_t k=0; k<num_parts; k++) {
+			if (team->partition_errs[k] != EMD_SUCCESS) {
+				team->solve_err = team->partition_errs[k];
+			}
+		}
+		for (size_t j=0; team->solve_err == EMD_SUCCESS && j+1<num_parts; j++) {
+			const size_t last = _chunk_start(n, num_parts, j+1) - 1;
+			const size_t first = last + 1;
+			// a[j] = A + B*b[j], after substituting a[j-1]
+			const double prev_R = (j > 0)? R[j-1] : 0;
+			const double prev_S = (j > 0)? S[j-1] : 0;
+			const double A = x[last] - v[last]*prev_R;
+			const double B = -(v[last]*prev_S + w[last]);
+			const double den = 1 + v[first]*B;
+			if (den == 0) {
+				team->solve_err = EMD_SINGULAR_SPLINE_SYSTEM;
+				break;
+			}
+			P[j] = (x[first] - v[first]*A)/den;
+			Q[j] = -w[first]/den;
+			R[j] = A + B*P[j];
+			S[j] = B*Q[j];
+		}
+		if (team->solve_err == EMD_SUCCESS) {
+			b[num_parts-2] = P[num_parts-2];
+			a[num_parts-2] = R[num_parts-2];
+			for (size_t j=num_parts-2; j-- > 0;) {
+				b[j] = P[j] + Q[j]*b[j+1];
+				a[j] = R[j] + S[j]*b[j+1];
+			}
+		}
+	}
+	if (team->solve_err != EMD_SUCCESS) {
+		return team->solve_err;
+	}
+	// Correct each partition with the unknowns next to it
+	#pragma omp for schedule(static)
+	for (size_t k=0; k<num_parts; k++) {
+		const size_t s = _chunk_start(n, num_parts, k);
+		const size_t e = _chunk_start(n, num_parts, k+1);
+		const double left = (k > 0)? a[k-1] : 0;
+		const double right = (k < num_parts-1)? b[k] : 0;
+		for (size_t i=s; i<e; i++) {
+			x[i] -= v[i]*left + w[i]*right;
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+// Same as _envelope_init for N >= 4 points, but done by the team. The
+// coefficients are computed as in _spline_coefficients, with the rows of the
+// linear system and the final coefficients divided among the threads.
+static libeemd_error_code _envelope_init_team(envelope* restrict env,
+		knot_array x, double const* restrict y, size_t N,
+		double* restrict spline_workspace, sifting_team* restrict team) {
+	const size_t num_chunks = team->num_chunks;
+	const size_t n = N-1;
+	const size_t sys_size = N-2;
+	double* const c = spline_workspace;
+	double* const diag = c+N;
+	double* const supdiag = diag + sys_size;
+	double* const subdiag = supdiag + (sys_size-1);
+	double* const g = subdiag + (sys_size-1);
+	#pragma omp single nowait
+	{
+		const double h_0 = _knot_h(x, 0);
+		const double h_1 = _knot_h(x, 1);
+		const double h_nm1 = _knot_h(x, n-1);
+		const double h_nm2 = _knot_h(x, n-2);
+		diag[0] = h_0 + 2*h_1;
+		supdiag[0] = h_1 - h_0;
+		g[0] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
+		subdiag[n-3] = h_nm2 - h_nm1;
+		diag[n-2] = 2*h_nm2 + h_nm1;
+		g[n-2] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]));
+	}
+	#pragma omp for schedule(static)
+	for (size_t k=0; k<num_chunks; k++) {
+		const size_t i_start = 2 + _chunk_start(n-3, num_chunks, k);
+		const size_t i_end = 2 + _chunk_start(n-3, num_chunks, k+1);
+		for (size_t i=i_start; i<i_end; i++) {
+			const double h_i = _knot_h(x, i);
+			const double h_im1 = _knot_h(x, i-1);
+			subdiag[i-2] = h_im1;
+			diag[i-1] = 2*(h_im1 + h_i);
+			supdiag[i-1] = h_i;
+			g[i-1] = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
+		}
+	}
+	libeemd_error_code solve_err = _solve_tridiag_team(diag, supdiag, subdiag, g, c+1, n-1, team);
+	if (solve_err != EMD_SUCCESS) {
+		return solve_err;
+	}
+	#pragma omp single
+	{
+		const double h_0 = _knot_h(x, 0);
+		const double h_1 = _knot_h(x, 1);
+		const double h_nm1 = _knot_h(x, n-1);
+		const double h_nm2 = _knot_h(x, n-2);
+		c[0] = c[1] + (h_0/h_1)*(c[1]-c[2]);
+		c[n] = c[n-1] + (h_nm1/h_nm2)*(c[n-1]-c[n-2]);
+		env->x = x;
+		env->y = y;
+		env->N = N;
+		env->i = 0;
+		env->dd = NULL;
+		env->c = c;
+		env->b = c + N;
+		env->d = env->b + n;
+	}
+	double* const bb = c+N;
+	double* const dd = bb+n;
+	#pragma omp for schedule(static)
+	for (size_t k=0; k<num_chunks; k++) {
+		const size_t i_start = _chunk_start(n, num_chunks, k);
+		const size_t i_end = _chunk_start(n, num_chunks, k+1);
+		for (size_t i=i_start; i<i_end; i++) {
+			const double h_i = _knot_h(x, i);
+			bb[i] = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
+			dd[i] = (c[i+1]-c[i])/(3.0*h_i);
+		}
 	}
-	// Save final residual
-	get_lock(output_lock);
-	array_add(res, N, output+N*(M-1));
-	release_lock(output_lock);
-	// Free global resources
-	for (int thread_id=0; thread_id<num_threads; thread_id++) {
-		free_eemd_workspace(ws[thread_id]);
-	}
-	free(ws); ws = NULL;
-	free(res); res = NULL;
-	free(noise_residuals); noise_residuals = NULL;
-	free(noises); noises = NULL;
-	destroy_lock(output_lock);
-	free(output_lock); output_lock = NULL;
 	return EMD_SUCCESS;
 }
 
-static inline libeemd_error_code _validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings) {
-	if (ensemble_size < 1) {
-		return EMD_INVALID_ENSEMBLE_SIZE;
+// Find the extrema of x in the same way as _find_extrema. The numbers of
+// extrema and zero crossings are stored in the team.
+static void _extrema_team(double const* restrict x, sifting_team* restrict team,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny) {
+	const size_t N = team->N;
+	const size_t num_chunks = team->num_chunks;
+	const size_t cap = team->chunk_capacity;
+	#pragma omp for schedule(static)
+	for (size_t c=0; c<num_chunks; c++) {
+		const size_t i_start = _chunk_start(N-1, num_chunks, c);
+		const size_t i_end = _chunk_start(N-1, num_chunks, c+1);
+		const knot_array pos = _knot_array_at(team->chunk_positions, 2*c*cap);
+		double* const val = &team->chunk_values[2*c*cap];
+		_extrema_state_at(&team->chunk_states[c], x, i_start);
+		_extrema_scan(&team->chunk_states[c], x, i_start, i_end,
+				pos, val, _knot_array_at(pos, cap), val+cap);
 	}
-	if (noise_strength < 0) {
-		return EMD_INVALID_NOISE_STRENGTH;
+	// Copy the extrema of each chunk after those of the preceding chunks,
+	// leaving room for the first data point
+	#pragma omp for schedule(static)
+	for (size_t c=0; c<num_chunks; c++) {
+		size_t max_offset = 1;
+		size_t min_offset = 1;
+		for (size_t k=0; k<c; k++) {
+			max_offset += team->chunk_states[k].nmax;
+			min_offset += team->chunk_states[k].nmin;
+		}
+		extrema_state const* const st = &team->chunk_states[c];
+		const knot_array pos = _knot_array_at(team->chunk_positions, 2*c*cap);
+		const size_t pos_size = _knot_size(pos.wide);
+		double const* const val = &team->chunk_values[2*c*cap];
+		memcpy(_knot_array_at(maxx, max_offset).p, pos.p, st->nmax*pos_size);
+		memcpy(maxy+max_offset, val, st->nmax*sizeof(double));
+		memcpy(_knot_array_at(minx, min_offset).p, _knot_array_at(pos, cap).p,
+				st->nmin*pos_size);
+		memcpy(miny+min_offset, val+cap, st->nmin*sizeof(double));
 	}
-	if (ensemble_size == 1 && noise_strength > 0) {
-		return EMD_NOISE_ADDED_TO_EMD;
+	#pragma omp single
+	{
+		extrema_state st;
+		_extrema_begin(&st, x[0], maxx, maxy, minx, miny);
+		for (size_t c=0; c<num_chunks; c++) {
+			st.nmax += team->chunk_states[c].nmax;
+			st.nmin += team->chunk_states[c].nmin;
+			st.nzc += team->chunk_states[c].nzc;
+		}
+		_extrema_end(&st, x[N-1], N, maxx, maxy, minx, miny);
+		team->num_max = st.nmax;
+		team->num_min = st.nmin;
+		team->num_zc = st.nzc;
 	}
-	if (ensemble_size > 1 && noise_strength == 0) {
-		return EMD_NO_NOISE_ADDED_TO_EEMD;
+}
+
+// Same as _sift_once, but done by the team. The numbers of extrema and zero
+// crossings for the next iteration are stored in the team.
+static libeemd_error_code _sift_once_team(double* restrict input,
+		sifting_team* restrict team, size_t num_max, size_t num_min,
+		bool find_next) {
+	const size_t N = team->N;
+	const size_t num_chunks = team->num_chunks;
+	sifting_workspace* const w = team->sift_w;
+	// Large envelopes are computed by the whole team, one at a time. Small
+	// ones are independent of each other, so their coefficients are computed
+	// at the same time.
+	const size_t min_knots = team->parallel_solve_min_knots;
+	const bool parallel_upper = (min_knots != 0 && num_max >= min_knots && num_max >= 4);
+	const bool parallel_lower = (min_knots != 0 && num_min >= min_knots && num_min >= 4);
+	#pragma omp sections
+	{
+		#pragma omp section
+		if (!parallel_upper) {
+			team->upper_err = _envelope_init(&team->upper, w, true, num_max, NULL);
+		}
+		#pragma omp section
+		if (!parallel_lower) {
+			team->lower_err = _envelope_init(&team->lower, w, false, num_min, NULL);
+		}
 	}
-	if (S_number == 0 && num_siftings == 0) {
-		return EMD_NO_CONVERGENCE_POSSIBLE;
+	// The partitioned solver does not keep a factorization
+	if (parallel_upper) {
+		const libeemd_error_code err = _envelope_init_team(&team->upper, w->maxx, w->maxy,
+				num_max, _envelope_workspace(w, true, num_max), team);
+		#pragma omp single
+		{
+			team->upper_err = err;
+			w->factored_num_max = 0;
+			w->num_envelopes[0]++;
+		}
+	}
+	if (parallel_lower) {
+		const libeemd_error_code err = _envelope_init_team(&team->lower, w->minx, w->miny,
+				num_min, _envelope_workspace(w, false, num_min), team);
+		#pragma omp single
+		{
+			team->lower_err = err;
+			w->factored_num_min = 0;
+			w->num_envelopes[1]++;
+		}
+	}
+	if (team->upper_err != EMD_SUCCESS) {
+		return team->upper_err;
+	}
+	if (team->lower_err != EMD_SUCCESS) {
+		return team->lower_err;
+	}
+	#pragma omp for schedule(static)
+	for (size_t c=0; c<num_chunks; c++) {
+		const size_t j_start = _chunk_start(N, num_chunks, c);
+		const size_t j_end = _chunk_start(N, num_chunks, c+1);
+		if (j_start == j_end) {
+			continue;
+		}
+		envelope upper = team->upper;
+		envelope lower = team->lower;
+		if (j_start > 0) {
+			_envelope_locate(&upper, j_start);
+			_envelope_locate(&lower, j_start);
+		}
+		_subtract_envelope_mean(input, &upper, &lower, j_start, j_end-1);
+	}
+	if (find_next) {
+		_extrema_team(input, team, w->next_maxx, w->next_maxy, w->next_minx, w->next_miny);
 	}
 	return EMD_SUCCESS;
 }
 
-// Helper function for applying the sifting procedure to input until it is
-// reduced to an IMF according to the stopping criteria given by S_number and
-// num_siftings. The required number of siftings is saved to sift_counter.
-static libeemd_error_code _sift(double* restrict input, sifting_workspace*
-		restrict w, unsigned int S_number, unsigned int num_siftings,
+// Same as _sift, but done by the team. All threads see the same numbers of
+// extrema, so they make the same decisions.
+static libeemd_error_code _sift_team(double* restrict input, sifting_team*
+		restrict team, unsigned int S_number, unsigned int num_siftings,
 		unsigned int* sift_counter) {
-	const size_t N = w->N;
-	// Provide some shorthands to avoid excessive '->' operators
-	double* const maxx = w->maxx;
-	double* const maxy = w->maxy;
-	double* const minx = w->minx;
-	double* const miny = w->miny;
-	// Initialize counters that keep track of the number of siftings
-	// and the S number
+	sifting_workspace* const w = team->sift_w;
 	*sift_counter = 0;
 	unsigned int S_counter = 0;
-	// Numbers of extrema and zero crossings are initialized to dummy values
 	size_t num_max = (size_t)(-1);
 	size_t num_min = (size_t)(-1);
 	size_t num_zc = (size_t)(-1);
 	size_t prev_num_max = (size_t)(-1);
 	size_t prev_num_min = (size_t)(-1);
 	size_t prev_num_zc = (size_t)(-1);
+	bool have_extrema = false;
+	#pragma omp single nowait
+	{
+		w->factored_num_max = 0;
+		w->factored_num_min = 0;
+	}
 	while (num_siftings == 0 || *sift_counter < num_siftings) {
 		(*sift_counter)++;
-		#if EEMD_DEBUG >= 1
-		if (*sift_counter == 10000) {
-			fprintf(stderr, "Something is probably wrong. Sift counter has reached 10000.\n");
-		}
-		#endif
 		prev_num_max = num_max;
 		prev_num_min = num_min;
 		prev_num_zc = num_zc;
-		// Find extrema and count zero crossings
-		emd_find_extrema(input, N, maxx, maxy, &num_max, minx, miny, &num_min, &num_zc);
-		// Check if we are finished based on the S-number criteria
-		if (S_number != 0) {
-			const int max_diff = (int)num_max - (int)prev_num_max;
-			const int min_diff = (int)num_min - (int)prev_num_min;
-			const int zc_diff = (int)num_zc - (int)prev_num_zc;
-			if (abs(max_diff)+abs(min_diff)+abs(zc_diff) <= 1) {
-				S_counter++;
-				if (S_counter >= S_number) {
-					const int num_diff = (int)num_min + (int)num_max - 4 - (int)num_zc;
-					if (abs(num_diff) <= 1) {
-						// Number of extrema has been stable for S_number steps
-						// and the number of *interior* extrema and zero
-						// crossings differ by at most one -- we are converged
-						// according to the S-number criterion
-						break;
-					}
-				}
-			}
-			else {
-				S_counter = 0;
-			}
+		if (!have_extrema) {
+			_extrema_team(input, team, w->maxx, w->maxy, w->minx, w->miny);
 		}
-		// Fit splines, choose order of spline based on the number of extrema
-		libeemd_error_code max_errcode = emd_evaluate_spline(maxx, maxy, num_max, w->maxspline, w->spline_workspace);
-		if (max_errcode != EMD_SUCCESS) {
-			return max_errcode;
+		num_max = team->num_max;
+		num_min = team->num_min;
+		num_zc = team->num_zc;
+		if (S_number != 0 && _s_number_converged(S_number, &S_counter,
+					num_max, num_min, num_zc, prev_num_max, prev_num_min, prev_num_zc)) {
+			break;
 		}
-		libeemd_error_code min_errcode = emd_evaluate_spline(minx, miny, num_min, w->minspline, w->spline_workspace);
-		if (min_errcode != EMD_SUCCESS) {
-			return min_errcode;
+		const bool find_next = (num_siftings == 0 || *sift_counter < num_siftings);
+		libeemd_error_code sift_err = _sift_once_team(input, team, num_max, num_min, find_next);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
 		}
-		// Subtract envelope mean from the data
-		for (size_t i=0; i<N; i++) {
-			input[i] -= 0.5*(w->maxspline[i] + w->minspline[i]);
+		if (find_next) {
+			#pragma omp single
+			_swap_extrema(w);
+			have_extrema = true;
 		}
 	}
 	return EMD_SUCCESS;
 }
 
-// Helper function for extracting all IMFs from input using the sifting
-// procedure defined by _sift. The contents of the input array are destroyed in
-// the process.
-static libeemd_error_code _emd(double* restrict input, emd_workspace* restrict w,
-		double* restrict output, size_t M,
-		unsigned int S_number, unsigned int num_siftings) {
-	// Provide some shorthands to avoid excessive '->' operators
-	const size_t N = w->N;
-	double* const res = w->res;
-	lock** locks = w->locks;
-	if (M == 0) {
-		M = emd_num_imfs(N);
+static libeemd_error_code _emd_team(double* restrict input, double* restrict res,
+		sifting_team* restrict team, double* restrict output, imf_layout layout,
+		size_t M, unsigned int S_number, unsigned int num_siftings) {
+	const size_t N = team->N;
+	const size_t num_chunks = team->num_chunks;
+	#pragma omp for schedule(static)
+	for (size_t c=0; c<num_chunks; c++) {
+		const size_t start = _chunk_start(N, num_chunks, c);
+		array_copy(input+start, _chunk_start(N, num_chunks, c+1)-start, res+start);
 	}
-	// We need to store a copy of the original signal so that once it is
-	// reduced to an IMF we have something to subtract the IMF from to form
-	// the residual for the next iteration
-	array_copy(input, N, res);
-	// Loop over all IMFs to be separated from input
 	unsigned int sift_counter;
 	for (size_t imf_i=0; imf_i<M-1; imf_i++) {
 		if (imf_i != 0) {
-			// Except for the first iteration, restore the previous residual
-			// and use it as an input
-			array_copy(res, N, input);
+			#pragma omp for schedule(static)
+			for (size_t c=0; c<num_chunks; c++) {
+				const size_t start = _chunk_start(N, num_chunks, c);
+				array_copy(res+start, _chunk_start(N, num_chunks, c+1)-start, input+start);
+			}
 		}
-		// Perform siftings on input until it is an IMF
-		libeemd_error_code sift_err = _sift(input, w->sift_w, S_number, num_siftings, &sift_counter);
+		libeemd_error_code sift_err = _sift_team(input, team, S_number, num_siftings, &sift_counter);
 		if (sift_err != EMD_SUCCESS) {
 			return sift_err;
 		}
-		// Subtract this IMF from the saved copy to form the residual for
-		// the next round
-		array_sub(input, N, res);
-		// Add the discovered IMF to the output matrix. Use locks to ensure
-		// other threads are not writing to the same row of the output matrix
-		// at the same time
-		get_lock(locks[imf_i]);
-		array_add(input, N, output+N*imf_i);
-		release_lock(locks[imf_i]);
-		#if EEMD_DEBUG >= 2
-		fprintf(stderr, "IMF %zd saved after %u siftings.\n", imf_i+1, sift_counter);
-		#endif
-	}
-	// Save final residual
-	get_lock(locks[M-1]);
-	array_add(res, N, output+N*(M-1));
-	release_lock(locks[M-1]);
-	return EMD_SUCCESS;
-}
-
-void emd_find_extrema(double const* restrict x, size_t N,
-		double* restrict maxx, double* restrict maxy, size_t* nmax,
-		double* restrict minx, double* restrict miny, size_t* nmin,
-		size_t* nzc) {
-	// Set the number of extrema and zero crossings to zero initially
-	*nmax = 0;
-	*nmin = 0;
-	*nzc = 0;
-	// Handle empty array as a special case
-	if (N == 0) {
-		return;
-	}
-	// Add the ends of the data as both local minima and maxima. These
-	// might be changed later by linear extrapolation.
-	maxx[0] = 0;
-	maxy[0] = x[0];
-	(*nmax)++;
-	minx[0] = 0;
-	miny[0] = x[0];
-	(*nmin)++;
-	// If we had only one data point this is it
-	if (N == 1) {
-		return;
-	}
-	// Now starts the main extrema-finding loop. The loop detects points where
-	// the slope of the data changes sign. In the case of flat regions at the
-	// extrema, the center point of the flat region will be considered the
-	// extremal point. While detecting extrema, the loop also counts the number
-	// of zero crossings that occur.
-	enum slope { UP, DOWN, NONE };
-	enum sign { POS, NEG, ZERO };
-	enum slope previous_slope = NONE;
-	enum sign previous_sign = (x[0] < -0)? NEG : ((x[0] > 0)? POS : ZERO);
-	int flat_counter = 0;
-	for (size_t i=0; i<N-1; i++) {
-		if (x[i+1] > x[i]) { // Going up
-			if (previous_slope == DOWN) {
-				// Was going down before -> local minimum found
-				minx[*nmin] = (double)(i)-(double)(flat_counter)/2;
-				miny[*nmin] = x[i];
-				(*nmin)++;
-			}
-			if (previous_sign == NEG && x[i+1] > 0) { // zero crossing from neg to pos
-				(*nzc)++;
-				previous_sign = POS;
-			}
-			else if (previous_sign == ZERO && x[i+1] > 0) {
-				// this needs to be handled as an unfortunate special case
-				previous_sign = POS;
-			}
-			previous_slope = UP;
-			flat_counter = 0;
-		}
-		else if (x[i+1] < x[i]) { // Going down
-			if (previous_slope == UP) {
-				// Was going up before -> local maximum found
-				maxx[*nmax] = (double)(i)-(double)(flat_counter)/2;
-				maxy[*nmax] = x[i];
-				(*nmax)++;
-			}
-			if (previous_sign == POS && x[i+1] < -0) { // zero crossing from pos to neg
-				(*nzc)++;
-				previous_sign = NEG;
-			}
-			else if (previous_sign == ZERO && x[i+1] < -0) {
-				// this needs to be handled as an unfortunate special case
-				previous_sign = NEG;
-			}
-			previous_slope = DOWN;
-			flat_counter = 0;
-		}
-		else { // Staying flat
-			flat_counter++;
-			#if EEMD_DEBUG >= 3
-			fprintf(stderr, "Warning: a flat slope found in data. The results will differ from the reference EEMD implementation.\n");
-			#endif
-		}
-	}
-	// Add the other end of the data as extrema as well.
-	maxx[*nmax] = N-1;
-	maxy[*nmax] = x[N-1];
-	(*nmax)++;
-	minx[*nmin] = N-1;
-	miny[*nmin] = x[N-1];
-	(*nmin)++;
-	// If we have at least two interior extrema, test if linear extrapolation provides
-	// a more extremal value.
-	if (*nmax >= 4) {
-		const double max_el = linear_extrapolate(maxx[1], maxy[1],
-				maxx[2], maxy[2], 0);
-		if (max_el > maxy[0])
-			maxy[0] = max_el;
-		const double max_er = linear_extrapolate(maxx[*nmax-3], maxy[*nmax-3],
-				maxx[*nmax-2], maxy[*nmax-2], N-1);
-		if (max_er > maxy[*nmax-1])
-			maxy[*nmax-1] = max_er;
-	}
-	if (*nmin >= 4) {
-		const double min_el = linear_extrapolate(minx[1], miny[1],
-				minx[2], miny[2], 0);
-		if (min_el < miny[0])
-			miny[0] = min_el;
-		const double min_er = linear_extrapolate(minx[*nmin-3], miny[*nmin-3],
-				minx[*nmin-2], miny[*nmin-2], N-1);
-		if (min_er < miny[*nmin-1])
-			miny[*nmin-1] = min_er;
-	}
-	return;
-}
-
-size_t emd_num_imfs(size_t N) {
-	if (N == 0) {
-		return 0;
-	}
-	if (N <= 3) {
-		return 1;
-	}
-	return (size_t)(log2(N));
-}
-
-libeemd_error_code emd_evaluate_spline(double const* restrict x, double const* restrict y,
-		size_t N, double* restrict spline_y, double* restrict spline_workspace) {
-	gsl_set_error_handler_off();
-	const size_t n = N-1;
-	const size_t max_j = (size_t)x[n];
-	if (N <= 1) {
-		return EMD_NOT_ENOUGH_POINTS_FOR_SPLINE;
-	}
-	// perform more assertions only if EEMD_DEBUG is on,
-	// as this function is meant only for internal use
-	#if EEMD_DEBUG >= 1
-	if (x[0] != 0) {
-		return EMD_INVALID_SPLINE_POINTS;
-	}
-	for (size_t i=1; i<N; i++) {
-		if (x[i] <= x[i-1]) {
-			return EMD_INVALID_SPLINE_POINTS;
-		}
-	}
-	#endif
-	// Fall back to linear interpolation (for N==2) or polynomial interpolation
-	// (for N==3)
-	if (N <= 3) {
-		int gsl_status = gsl_poly_dd_init(spline_workspace, x, y, N);
-		if (gsl_status != GSL_SUCCESS) {
-			fprintf(stderr, "Error reported by gsl_poly_dd_init: %s\n",
-				gsl_strerror(gsl_status));
-			return EMD_GSL_ERROR;
-		}
-		for (size_t j=0; j<=max_j; j++) {
-			spline_y[j] = gsl_poly_dd_eval(spline_workspace, x, N, j);
+		#pragma omp for schedule(static)
+		for (size_t c=0; c<num_chunks; c++) {
+			const size_t start = _chunk_start(N, num_chunks, c);
+			const size_t n = _chunk_start(N, num_chunks, c+1)-start;
+			array_sub(input+start, n, res+start);
+			imf_add(input+start, n, output, layout, imf_i, start);
 		}
-		return EMD_SUCCESS;
-	}
-	// For N >= 4, interpolate by using cubic splines with not-a-node end conditions.
-	// This algorithm is described in "Numerical Algorithms with C" by
-	// G. Engeln-Müllges and F. Uhlig, page 257.
-	//
-	// Extra homework assignment for anyone reading this: Implement this
-	// algorithm in GSL, so that next time someone needs these end conditions
-	// they can just use GSL.
-	const size_t sys_size = N-2;
-	double* const c = spline_workspace;
-	double* const diag = c+N;
-	double* const supdiag = diag + sys_size;
-	double* const subdiag = supdiag + (sys_size-1);
-	double* const g = subdiag + (sys_size-1);
-	// Define some constants for easier comparison with Engeln-Mullges & Uhlig
-	// and let the compiler optimize them away.
-	const double h_0 = x[1]-x[0];
-	const double h_1 = x[2]-x[1];
-	const double h_nm1 = x[n]-x[n-1];
-	const double h_nm2 = x[n-1]-x[n-2];
-	// Describe the (N-2)x(N-2) linear system Ac=g with the tridiagonal
-	// matrix A defined by subdiag, diag and supdiag
-	// first row
-	diag[0] = h_0 + 2*h_1;
-	supdiag[0] = h_1 - h_0;
-	g[0] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
-	// rows 2 to n-2
-	for (size_t i=2; i<=n-2; i++) {
-		const double h_i = x[i+1] - x[i];
-		const double h_im1 = x[i] - x[i-1];
-		
-		subdiag[i-2] = h_im1;
-		diag[i-1] = 2*(h_im1 + h_i);
-		supdiag[i-1] = h_i;
-		g[i-1] = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
-	}
-	// final row
-	subdiag[n-3] = h_nm2 - h_nm1;
-	diag[n-2] = 2*h_nm2 + h_nm1;
-	g[n-2] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]));
-	// Solve to get c_1 ... c_{n-1}
-	gsl_vector_view diag_vec = gsl_vector_view_array(diag, n-1);
-	gsl_vector_view supdiag_vec = gsl_vector_view_array(supdiag, n-2);
-	gsl_vector_view subdiag_vec = gsl_vector_view_array(subdiag, n-2);
-	gsl_vector_view g_vec = gsl_vector_view_array(g, n-1);
-	gsl_vector_view solution_vec = gsl_vector_view_array(c+1, n-1);
-	int gsl_status = gsl_linalg_solve_tridiag(&diag_vec.vector,
-			                                    &supdiag_vec.vector,
-												&subdiag_vec.vector,
-												&g_vec.vector,
-												&solution_vec.vector);
-	if (gsl_status != GSL_SUCCESS) {
-		fprintf(stderr, "Error reported by gsl_linalg_solve_tridiag: %s\n",
-				gsl_strerror(gsl_status));
-		return EMD_GSL_ERROR;
 	}
-	// Compute c[0] and c[n]
-	c[0] = c[1] + (h_0/h_1)*(c[1]-c[2]);
-	c[n] = c[n-1] + (h_nm1/h_nm2)*(c[n-1]-c[n-2]);
-	// The coefficients b_i and d_i are computed from the c_i's, so just
-	// evaluate the spline at the required points. In this case it is easy to
-	// find the required interval for spline evaluation, since the evaluation
-	// points j just increase monotonically from 0 to max_j.
-	size_t i = 0;
-	for (size_t j=0; j<=max_j; j++) {
-		if (j > x[i+1]) {
-			i++;
-			assert(i < n);
-		}
-		const double dx = j-x[i];
-		if (dx == 0) {
-			spline_y[j] = y[i];
-			continue;
-		}
-		// Compute coefficients b_i and d_i
-		const double h_i = x[i+1] - x[i];
-		const double a_i = y[i];
-		const double b_i = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
-		const double c_i = c[i];
-		const double d_i = (c[i+1]-c[i])/(3.0*h_i);
-		// evaluate spline at x=j using the Horner scheme
-		spline_y[j] = a_i + dx*(b_i + dx*(c_i + dx*d_i));
+	#pragma omp for schedule(static)
+	for (size_t c=0; c<num_chunks; c++) {
+		const size_t start = _chunk_start(N, num_chunks, c);
+		imf_add(res+start, _chunk_start(N, num_chunks, c+1)-start, output, layout, M-1, start);
 	}
 	return EMD_SUCCESS;
 }
@@ -891,6 +6334,24 @@ void emd_report_to_file_if_error(FILE* file, libeemd_error_code err) {
 		case EMD_GSL_ERROR :
 			fprintf(file, "Error reported by GSL library\n");
 			break;
+		case EMD_SINGULAR_SPLINE_SYSTEM :
+			fprintf(file, "Singular linear system in spline evaluation\n");
+			break;
+		case EMD_INCOMPATIBLE_NOISE_BANK :
+			fprintf(file, "Noise bank does not match the plan\n");
+			break;
+		case EMD_FILE_ERROR :
+			fprintf(file, "Could not write file\n");
+			break;
+		case EMD_PRECISION_MISMATCH :
+			fprintf(file, "Precision of the data does not match the plan\n");
+			break;
+		case EMD_INVALID_LENGTH :
+			fprintf(file, "Data is too long for this build of libeemd\n");
+			break;
+		case EMD_ALLOCATION_ERROR :
+			fprintf(file, "Memory allocation failed\n");
+			break;
 		default :
 			fprintf(file, "Error code with unknown meaning. Please file a bug!\n");
 	}
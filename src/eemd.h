@@ -34,6 +34,7 @@
 #include <string.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <gsl/gsl_statistics_double.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
@@ -58,7 +59,14 @@ typedef enum {
 	EMD_NOT_ENOUGH_POINTS_FOR_SPLINE = 6,
 	EMD_INVALID_SPLINE_POINTS = 7,
 	// Other errors
-	EMD_GSL_ERROR = 8
+	EMD_GSL_ERROR = 8,
+	EMD_SINGULAR_SPLINE_SYSTEM = 9,
+	EMD_INCOMPATIBLE_NOISE_BANK = 10,
+	EMD_FILE_ERROR = 11,
+	EMD_PRECISION_MISMATCH = 12,
+	// Data longer than this build of libeemd supports (see emd_plan_create)
+	EMD_INVALID_LENGTH = 13,
+	EMD_ALLOCATION_ERROR = 14
 } libeemd_error_code;
 
 // Helper functions to print an error message if an error occured
@@ -84,7 +92,20 @@ void emd_report_to_file_if_error(FILE* file, libeemd_error_code err);
 // article for details) or a fixed number of siftings. If both are specified,
 // the sifting ends when either criterion is fulfilled. The final parameter is
 // the seed given to the random number generator. A value of zero denotes a
-// RNG-specific default value.
+// RNG-specific default value. As in libeemd 1.4 and earlier, ensemble member
+// i reseeds a Mersenne Twister with rng_seed+i (EMD_RNG_MT19937, see
+// emd_rng_type below); use a plan for the faster Philox generator that plans
+// use by default. The number of threads is chosen as for a plan created with
+// num_threads=0 (see emd_plan_create below); use a plan to give it
+// explicitly. Signals of at least 2^20 samples with an ensemble of at most
+// half as many members as threads are sifted by all threads together, which
+// gives the same results as a single thread. Unlike plans, this routine never
+// computes the envelopes with the partitioned solver, so the results do not
+// depend on the number of threads (see parallel_sift_min_length and
+// parallel_solve_min_knots below).
+// If the memory for the decomposition cannot be allocated,
+// EMD_ALLOCATION_ERROR is returned. If N is too long for the positions of the
+// extrema (over 2^63, see emd_plan_create), EMD_INVALID_LENGTH is returned.
 libeemd_error_code eemd(double const* restrict input, size_t N,
 		double* restrict output, size_t M,
 		unsigned int ensemble_size, double noise_strength, unsigned int
@@ -102,12 +123,452 @@ libeemd_error_code ceemdan(double const* restrict input, size_t N,
 		unsigned int ensemble_size, double noise_strength, unsigned int
 		S_number, unsigned int num_siftings, unsigned long int rng_seed);
 
+// Single-precision variants of eemd and ceemdan for float data. The
+// parameters are the same, and the ensemble members get the same noise, but
+// the signals are sifted in single precision (see EMD_PRECISION_FLOAT below).
+// The IMFs of the ensemble members are summed in double precision. The
+// program examples/float_validation reports how much the results differ from
+// eemd and ceemdan.
+libeemd_error_code eemdf(float const* restrict input, size_t N,
+		float* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed);
+libeemd_error_code ceemdanf(float const* restrict input, size_t N,
+		float* restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed);
+
+// Batch variants of eemd and ceemdan for decomposing several independent
+// signals of the same length with a single call. Parallelism is used across
+// both the signals and the ensemble members, so that many small problems keep
+// all threads busy.
+//
+// Signal s (0 <= s < num_signals) is read from input+s*input_stride, and its M
+// IMFs are written in the same format as for eemd to output+s*output_stride,
+// so output_stride must be at least M*N. The rest of the parameters have the
+// same meaning as for routine eemd. Ensemble member i of signal s uses the RNG
+// stream number rng_seed+s*ensemble_size+i, so that the result for signal s
+// is the same as given by eemd (or ceemdan) with rng_seed+s*ensemble_size as
+// the seed, regardless of the number of threads.
+libeemd_error_code eemd_batch(double const* restrict input, size_t
+		num_signals, size_t input_stride, size_t N,
+		double* restrict output, size_t output_stride, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed);
+libeemd_error_code ceemdan_batch(double const* restrict input, size_t
+		num_signals, size_t input_stride, size_t N,
+		double* restrict output, size_t output_stride, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed);
+
+// Decomposition plans
+//
+// Every call to eemd or ceemdan allocates all the memory it needs and frees it
+// before returning. When many signals of the same length are decomposed, this
+// can be avoided by creating a plan once, executing it for each signal, and
+// finally destroying it. Executing a plan does not allocate any memory.
+typedef enum {
+	EMD_VARIANT_EEMD = 0,
+	EMD_VARIANT_CEEMDAN = 1
+} emd_variant;
+
+typedef struct emd_plan emd_plan;
+
+// Create a plan for decomposing signals of length N into M IMFs with the
+// method given by 'variant' (EMD and EEMD both use EMD_VARIANT_EEMD) and the
+// given ensemble size. As with eemd, M=0 means M = emd_num_imfs(N). The plan
+// uses at most 'num_threads' threads; zero selects the default number of
+// OpenMP threads (see 'threading' below for the alternative), but not more
+// than ensemble_size unless the signals are long enough to be sifted in
+// parallel (see parallel_sift_min_length below). The positions of the
+// extrema are stored in 32 bits if N is less than 2^31 and in 64 bits
+// otherwise, so N can be at most 2^63.
+// Returns NULL if the parameters are invalid or memory allocation fails.
+//
+// libeemd never changes the settings of the OpenMP runtime, such as the
+// number of threads of later parallel regions of the program. A plan asks for
+// exactly num_threads threads for each execution with the num_threads clause
+// of its parallel region, which OpenMP can only reduce (e.g. with
+// OMP_DYNAMIC or OMP_THREAD_LIMIT), in which case the work is divided among
+// the threads that were started. If a plan is created with num_threads=0
+// inside an active parallel region of the program, such as from the body of
+// a parallel loop decomposing one signal per iteration, it uses a single
+// thread, so that libeemd does not add threads to those of the program. The
+// same applies to eemd, ceemdan and the batch routines. A plan given more
+// threads and executed inside a parallel region starts a nested team of
+// num_threads threads if the program has allowed nested parallelism (see
+// omp_set_max_active_levels), and otherwise runs on the calling thread alone,
+// giving the same results as a plan with one thread. A plan using the thread
+// pool (see 'threading' below) always runs on exactly num_threads threads,
+// even inside a parallel region. Any number of plans can be executed at the
+// same time by different threads, but each plan by only one thread at a
+// time.
+emd_plan* emd_plan_create(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads);
+
+// Number of threads a plan uses, i.e., num_threads or the default chosen when
+// the plan was created
+unsigned int emd_plan_get_num_threads(emd_plan const* plan);
+
+// Options for creating a plan
+//
+// In EEMD every ensemble member produces a full set of IMFs that is summed to
+// the output matrix. With 'accumulation' set to EMD_ACCUMULATE_LOCKED all
+// threads add their IMFs directly to the shared output matrix, protected by
+// one lock per IMF. With EMD_ACCUMULATE_PRIVATE each thread instead sums its
+// ensemble members to a private buffer of N*M doubles, and the buffers are
+// combined with a parallel tree reduction at the end. If the buffers of all
+// threads would take more than 'accumulation_memory_limit' bytes (zero means
+// no limit), only as many threads as fit within the limit get a buffer, and
+// the rest use the locked path. These buffers are flushed to the output
+// matrix under the locks instead of being reduced at the end. A nonzero
+// 'flush_interval' forces the buffers to be flushed every flush_interval
+// ensemble members. These options have no effect for CEEMDAN or plain EMD.
+typedef enum {
+	EMD_ACCUMULATE_LOCKED = 0,
+	EMD_ACCUMULATE_PRIVATE = 1
+} emd_accumulation_mode;
+
+// The random number generator used for the added noise is selected with
+// 'rng'. With EMD_RNG_PHILOX the noise comes from the counter-based
+// Philox4x32-10 generator, keyed by the stream number rng_seed+i of ensemble
+// member i, with the sample index as the counter. The noise of any ensemble
+// member can then be generated independently of the others without any setup
+// cost. With EMD_RNG_MT19937 each ensemble member reseeds a GSL Mersenne
+// Twister with its stream number instead, which reproduces the results of
+// libeemd 1.4 and earlier. In both cases the results do not depend on the
+// number of threads.
+typedef enum {
+	EMD_RNG_PHILOX = 0,
+	EMD_RNG_MT19937 = 1
+} emd_rng_type;
+
+// CEEMDAN needs the noise of every ensemble member and the residual of that
+// noise at each mode. The noise for the next mode is computed while the
+// current one is still in use, so this takes 3*ensemble_size*N doubles. If
+// 'noise_memory_limit' is nonzero, only as many ensemble members as fit within
+// that many bytes keep their noise in memory. For the rest the noise is
+// regenerated from the seed and sifted again up to the current mode whenever
+// it is needed, which gives exactly the same results but costs about k extra
+// siftings of the noise for mode k. The work for these members is spread
+// evenly among the threads. This option has no effect for EEMD.
+//
+// Normally each ensemble member is sifted by a single thread, so that a plain
+// EMD of a single signal uses only one thread no matter how long the signal
+// is. For signals of at least 'parallel_sift_min_length' samples (zero means
+// never), if there are at most half as many ensemble members to work on as
+// threads, all threads instead sift one ensemble member at a time together:
+// the search for extrema, the evaluation of the envelopes and the subtraction
+// of their mean are divided into chunks of the signal. With this option a
+// plan created with num_threads=0 uses the default number of threads even if
+// the ensemble is small. The spline coefficients of an envelope with fewer
+// than 'parallel_solve_min_knots' knots are computed by a single thread, and
+// the results are then the same as when using a single thread. For larger
+// envelopes (unless parallel_solve_min_knots is zero) the whole team computes
+// them, solving the linear system with a partitioned (SPIKE) algorithm, which
+// changes the results by rounding errors. The program
+// examples/spline_solver_benchmark shows where this starts to pay off.
+//
+// A plan with 'precision' set to EMD_PRECISION_FLOAT decomposes float data
+// with emd_plan_execute_float. The signals are stored as floats, which halves
+// the memory used and the memory traffic of sifting, and the extrema are
+// found eight floats at a time, but the spline coefficients and the values of
+// the envelopes are still computed in double precision. Rounding the signal
+// to floats can add extrema to slowly varying modes, so expect the last IMFs
+// to differ more from double precision than the first ones. The IMFs of the
+// ensemble members are summed in double precision unless 'sum_precision' is
+// EMD_PRECISION_FLOAT. Such a plan sifts each ensemble member with a single
+// thread and keeps all CEEMDAN noise in memory, so the accumulation, noise
+// memory and parallel sifting options have no effect on it. It cannot use
+// the thread pool, so in builds without OpenMP, where the pool is the default,
+// set 'threading' to EMD_THREADS_OPENMP to run it on a single thread.
+typedef enum {
+	EMD_PRECISION_DOUBLE = 0,
+	EMD_PRECISION_FLOAT = 1
+} emd_precision;
+
+// The threads of a plan come from the OpenMP runtime or from a pool of
+// threads owned by the plan, as selected with 'threading'. With
+// EMD_THREADS_OPENMP every execution opens an OpenMP parallel region of
+// num_threads threads. With EMD_THREADS_POOL the plan starts num_threads-1
+// POSIX threads when it is created, which wait for work until the plan is
+// destroyed; the thread executing the plan is the remaining one. Each thread
+// of the pool starts with an equal share of the ensemble members and, when it
+// runs out, steals half of the remaining members of another thread, so that
+// members that need many siftings do not leave the other threads idle. For
+// CEEMDAN the members are stolen in fixed blocks, four per thread. The
+// pool never calls into the OpenMP runtime, so plans using it can be executed
+// from programs with their own OpenMP parallelism without oversubscribing the
+// cores or changing their OpenMP settings, and a plan created with
+// num_threads=0 uses as many threads as there are online processors, but not
+// more than ensemble_size. Such a plan always sifts each ensemble member with
+// a single thread, so parallel_sift_min_length has no effect, and it cannot
+// be used with single precision. With the pool the results of EEMD are the
+// same as with OpenMP up to rounding. The CEEMDAN members of each block are
+// summed in order, and the sums of the blocks in the order of the blocks, so
+// the results of CEEMDAN do not depend on which thread extracted which block.
+// They depend on the number of threads and differ from OpenMP by rounding.
+// The default is OpenMP if libeemd was built with it, and otherwise the pool
+// if it was built with POSIX threads (configure --disable-thread-pool leaves
+// it out). Creating a plan with a backend that was not built returns NULL.
+typedef enum {
+	EMD_THREADS_OPENMP = 0,
+	EMD_THREADS_POOL = 1
+} emd_threading;
+
+// On machines with several NUMA nodes (sockets), a plan using the thread
+// pool can keep the memory each thread works on in the node of that thread.
+// With 'numa' set to EMD_NUMA_LOCAL the threads of the pool are pinned to
+// the CPUs the creating thread is allowed to run on, divided among the nodes
+// in contiguous blocks of (almost) equal size, and the thread executing the
+// plan is pinned to the CPU of the first one for the duration of each
+// execution. Each thread allocates and first touches its own workspace, EEMD
+// summation buffer and CEEMDAN partial modes, and touches the CEEMDAN noise
+// of the ensemble members it starts with first. When a thread runs out of
+// work it steals from the threads on its own node before the others. The
+// ensemble members of a single EEMD signal are summed to one buffer per
+// node, and only these buffers are added together across the nodes at the
+// end. The nodes are read from /sys/devices/system/node; if that is not
+// available, all CPUs are treated as one node. Creating a plan with
+// EMD_NUMA_LOCAL returns NULL if it does not use the thread pool or if
+// threads cannot be pinned on this platform. Plans using OpenMP are not
+// pinned by libeemd, but the workspaces and the CEEMDAN noise are first
+// touched by the threads using them, so they are placed similarly when
+// OpenMP pins its threads (e.g. OMP_PROC_BIND=spread). The program
+// examples/numa_benchmark compares the throughput with and without this
+// option for 1 to all cores.
+typedef enum {
+	EMD_NUMA_NONE = 0,
+	EMD_NUMA_LOCAL = 1
+} emd_numa_mode;
+
+// All memory of a plan, including the plan itself, is carved from a single
+// block, whose size in bytes is returned by emd_plan_workspace_size. The size
+// covers the worst case of an extremum at every other point, but only the
+// memory for the extrema actually found is touched. By default, blocks of at
+// least a MiB are mapped with mmap without reserving swap space, so that
+// memory is committed as it is touched, and smaller ones are allocated with
+// malloc. A workspace or allocator of the caller always provides the whole
+// block. If 'workspace' is not NULL, the plan is instead carved from the
+// 'workspace_size' bytes starting there, which must be aligned to
+// EMD_WORKSPACE_ALIGNMENT bytes (to a page with EMD_NUMA_LOCAL) and stay
+// valid until the plan is destroyed, such as memory in huge pages or memory
+// that was touched in advance. Creating a plan with a smaller or misaligned
+// workspace returns NULL.
+// Otherwise, if 'allocate' is not NULL, the block is allocated by a single
+// call allocate(size, allocator_context), where size is
+// EMD_WORKSPACE_ALIGNMENT-1 bytes (a page less one byte with EMD_NUMA_LOCAL)
+// more than emd_plan_workspace_size returns, so that the block can be
+// aligned, and it is freed by calling deallocate(ptr, allocator_context) when
+// the plan is destroyed, unless deallocate is NULL.
+// Apart from the block, creating a plan only allocates the threads of the
+// pool, a GSL generator for each thread with EMD_RNG_MT19937, and small
+// temporary arrays with EMD_NUMA_LOCAL. Since the threads of an
+// EMD_NUMA_LOCAL plan touch their memory first, a workspace given to such a
+// plan should not be touched in advance.
+#define EMD_WORKSPACE_ALIGNMENT 64
+
+typedef struct {
+	emd_accumulation_mode accumulation;
+	size_t accumulation_memory_limit;
+	unsigned int flush_interval;
+	emd_rng_type rng;
+	size_t noise_memory_limit;
+	size_t parallel_sift_min_length;
+	size_t parallel_solve_min_knots;
+	emd_precision precision;
+	emd_precision sum_precision;
+	emd_threading threading;
+	emd_numa_mode numa;
+	void* workspace;
+	size_t workspace_size;
+	void* (*allocate)(size_t size, void* context);
+	void (*deallocate)(void* ptr, void* context);
+	void* allocator_context;
+} emd_plan_options;
+
+// Initialize plan options to their default values: private accumulation with
+// a memory limit of 256 MiB, no forced flushing, the Philox generator, all
+// CEEMDAN noise kept in memory, parallel sifting of signals of at least 2^20
+// samples, the parallel solver for envelopes of at least 2^15 knots, double
+// precision, OpenMP threads if available, no NUMA placement, and memory
+// allocated by libeemd.
+void emd_plan_options_init(emd_plan_options* options);
+
+// Same as emd_plan_create, but with explicitly given options. Passing NULL as
+// 'options' is the same as passing options initialized by
+// emd_plan_options_init.
+emd_plan* emd_plan_create_with_options(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads,
+		emd_plan_options const* options);
+
+// Number of bytes of memory that emd_plan_create_with_options needs for a
+// plan with the same parameters, or zero if the parameters are invalid.
+// With num_threads=0 the number of threads, and hence the size, is decided
+// in the same way as when creating the plan, so query it in the same context
+// (e.g. outside of parallel regions).
+size_t emd_plan_workspace_size(emd_variant variant, size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int num_threads,
+		emd_plan_options const* options);
+
+// Decompose 'input' with a plan, writing the result to 'output', which must
+// be able to store at least N*M doubles. The rest of the parameters have the
+// same meaning as for routine eemd. The same plan must not be executed by
+// several threads at the same time.
+libeemd_error_code emd_plan_execute(emd_plan* plan,
+		double const* restrict input, double* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed);
+
+// Decompose a batch of signals with a plan. The layout of the input and
+// output data and the RNG seeds are the same as for eemd_batch.
+libeemd_error_code emd_plan_execute_batch(emd_plan* plan,
+		double const* restrict input, size_t num_signals, size_t input_stride,
+		double* restrict output, size_t output_stride,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed);
+
+// Layouts of the input and output data of emd_plan_execute_strided, with all
+// strides counted in doubles. Sample j of input signal s is read from
+// input[s*signal_stride + j*sample_stride], and sample j of IMF m of signal s
+// is written to output[s*signal_stride + m*imf_stride + j*sample_stride].
+// For example, C channels interleaved sample by sample are read with
+// sample_stride C and signal_stride 1, and the IMFs of each channel are stored
+// sample by sample ([sample][IMF]) with sample_stride M, imf_stride 1 and
+// signal_stride M*N. The output elements of different signals and IMFs must
+// not overlap.
+typedef struct {
+	size_t sample_stride;
+	size_t signal_stride;
+} emd_input_layout;
+
+typedef struct {
+	size_t sample_stride;
+	size_t imf_stride;
+	size_t signal_stride;
+} emd_output_layout;
+
+// Decompose a batch of signals with a plan, reading and writing the data in
+// the given layouts. A NULL layout means contiguous signals and IMFs as for
+// emd_plan_execute_batch with input_stride N and output_stride M*N. The data
+// is read and written in place while the ensemble members are initialized
+// and summed, so no transposed copies are made, and the results are the same
+// as with contiguous data.
+libeemd_error_code emd_plan_execute_strided(emd_plan* plan,
+		double const* restrict input, emd_input_layout const* input_layout,
+		size_t num_signals, double* restrict output,
+		emd_output_layout const* output_layout, double noise_strength,
+		unsigned int S_number, unsigned int num_siftings,
+		unsigned long int rng_seed);
+
+// Decompose fixed-point data, such as the samples of an ADC, with a plan. The
+// value of sample i is scale*input[i]. The samples are converted to doubles
+// only when an ensemble member or the first residual of CEEMDAN is
+// initialized, so no converted copy of the whole signal is made. The results
+// are the same as converting the samples first and calling emd_plan_execute,
+// except that the standard deviation of the signal, and hence the scale of
+// the noise, may differ by rounding errors.
+libeemd_error_code emd_plan_execute_int16(emd_plan* plan,
+		int16_t const* restrict input, double scale, double* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed);
+libeemd_error_code emd_plan_execute_int32(emd_plan* plan,
+		int32_t const* restrict input, double scale, double* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed);
+
+// Decompose float data with a plan created with precision
+// EMD_PRECISION_FLOAT, writing the result to 'output', which must be able to
+// store at least N*M floats. The rest of the parameters are the same as for
+// emd_plan_execute. Returns EMD_PRECISION_MISMATCH if the plan is for double
+// precision, and the routines for double data return it for a plan for
+// single precision.
+libeemd_error_code emd_plan_execute_float(emd_plan* plan,
+		float const* restrict input, float* restrict output,
+		double noise_strength, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed);
+
+// Return the number of IMFs computed by a plan (useful when created with M=0)
+size_t emd_plan_num_imfs(emd_plan const* plan);
+
+// Release all memory held by a plan
+void emd_plan_destroy(emd_plan* plan);
+
+// Sifting statistics of a plan, accumulated over all executions since the
+// plan was created or the statistics were last reset. 'envelopes' is the
+// number of cubic spline envelopes computed. Between sifting iterations the
+// extrema often stay at the same positions and only their values change, in
+// which case the factorization of the linear system for the spline
+// coefficients from the previous iteration is reused instead of computed
+// again. 'reused_factorizations' is the number of envelopes for which this
+// was done. Envelopes through at most three points and those computed with
+// the partitioned solver (see parallel_solve_min_knots) never reuse a
+// factorization.
+typedef struct {
+	unsigned long long envelopes;
+	unsigned long long reused_factorizations;
+} emd_plan_stats;
+
+// Read or reset the statistics of a plan. These must not be called while the
+// plan is being executed.
+void emd_plan_get_stats(emd_plan const* plan, emd_plan_stats* stats);
+void emd_plan_reset_stats(emd_plan* plan);
+
+// Noise banks for CEEMDAN
+//
+// In CEEMDAN the white noise of each ensemble member and its EMD modes depend
+// only on N, the ensemble size, the RNG and its seed, and the stopping
+// criterion, but not on the input signal. Sifting the noise is about half of
+// the work. A noise bank precomputes all of these modes once, after which any
+// number of signals can be decomposed without sifting any noise.
+typedef struct emd_noise_bank emd_noise_bank;
+
+// Compute the first M modes of the noise for each of the ensemble_size
+// members, with the given stopping criterion and random number generator.
+// Member i uses the RNG stream rng_seed+i, so decomposing a signal with the
+// bank gives exactly the same result as ceemdan with the same parameters (if
+// rng is EMD_RNG_MT19937) or a plan executed with them. M=0 means M =
+// emd_num_imfs(N), and num_threads=0 selects the default number of OpenMP
+// threads. The bank takes ensemble_size*M*(N+1) doubles of memory. Returns
+// NULL if the parameters are invalid, memory allocation fails or the noise
+// cannot be sifted.
+emd_noise_bank* emd_noise_bank_create(size_t N, size_t M,
+		unsigned int ensemble_size, unsigned int S_number, unsigned int
+		num_siftings, unsigned long int rng_seed, emd_rng_type rng,
+		unsigned int num_threads);
+
+// Write a bank to a file, or read it back. The file is in the native byte
+// order of the machine, and it is mapped to memory instead of read if
+// possible, so that it is loaded only as needed and shared by all processes
+// using it. emd_noise_bank_load returns NULL if the file cannot be read or is
+// not a valid noise bank.
+libeemd_error_code emd_noise_bank_save(emd_noise_bank const* bank, char const* filename);
+emd_noise_bank* emd_noise_bank_load(char const* filename);
+
+// Release all memory held by a bank, or unmap its file
+void emd_noise_bank_destroy(emd_noise_bank* bank);
+
+// Execute a CEEMDAN plan using the noise in a bank. The plan must have the
+// same N and ensemble size as the bank, and at most as many IMFs. The
+// stopping criterion and seed are those of the bank. In the batch variant
+// every signal uses the same noise, unlike in emd_plan_execute_batch. Returns
+// EMD_INCOMPATIBLE_NOISE_BANK if the bank does not match the plan. A plan
+// that is only used with banks can be created with a small
+// noise_memory_limit, since it does not need memory for noise of its own.
+libeemd_error_code emd_plan_execute_with_noise_bank(emd_plan* plan,
+		emd_noise_bank const* bank, double const* restrict input,
+		double* restrict output, double noise_strength);
+libeemd_error_code emd_plan_execute_batch_with_noise_bank(emd_plan* plan,
+		emd_noise_bank const* bank, double const* restrict input,
+		size_t num_signals, size_t input_stride, double* restrict output,
+		size_t output_stride, double noise_strength);
+
 // A method for finding the local minima and maxima from input data specified
 // with parameters x and N. The memory for storing the coordinates of the
 // extrema and their number are passed as the rest of the parameters. The
-// arrays for the coordinates must be at least size N. The method also counts
-// the number of zero crossings in the data, and saves the results into the
-// pointer given as num_zero_crossings_ptr.
+// arrays for the coordinates must be at least size N/2+2. The method also
+// counts the number of zero crossings in the data, and saves the results into
+// the pointer given as num_zero_crossings_ptr.
 void emd_find_extrema(double const* restrict x, size_t N,
 		double* restrict maxx, double* restrict maxy, size_t* num_max_ptr,
 		double* restrict minx, double* restrict miny, size_t* num_min_ptr,
@@ -125,7 +586,15 @@ size_t emd_num_imfs(size_t N);
 // integer, and the x values are assumed to be in ascending order, with x[0]
 // equal to 0. The workspace required is 5*N-10 doubles, except that N==2
 // requires no extra memory. For N<=3 the routine falls back to polynomial
-// interpolation, same as Matlab.
+// interpolation, same as Matlab. The tridiagonal system for the spline
+// coefficients is solved in place in the workspace, so the routine does not
+// allocate memory. The solution agrees with the one given by GSL's
+// gsl_linalg_solve_tridiag up to a few ulps, which leads to a relative
+// difference of at most about 1e-14 in the spline values. The polynomial
+// coefficients are computed once for each interval between nodes, and each
+// interval is then evaluated with the Horner scheme exactly as the Matlab
+// reference does, so apart from the differences from the linear solver the
+// results are bit-for-bit reproducible.
 //
 // This routine is mainly exported so that it can be tested separately to
 // produce identical results to the Matlab routine 'spline'.
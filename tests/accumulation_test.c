@@ -0,0 +1,88 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// EEMD with thread-private accumulation buffers, with and without a memory
+// limit and forced flushing, compared with adding the ensemble members to the
+// output matrix under the locks. With a single thread the members are summed
+// in the same order, so the results must be identical unless the buffers are
+// flushed. Otherwise the order differs, which only changes the results by
+// rounding.
+
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 2000;
+const size_t num_signals = 3;
+const unsigned int ensemble_size = 8;
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 7;
+
+static void decompose(double const* input, double* output, size_t M,
+		emd_accumulation_mode accumulation, size_t memory_limit,
+		unsigned int flush_interval, unsigned int num_threads) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.accumulation = accumulation;
+	options.accumulation_memory_limit = memory_limit;
+	options.flush_interval = flush_interval;
+	emd_plan* plan = emd_plan_create_with_options(EMD_VARIANT_EEMD, N, M,
+			ensemble_size, num_threads, &options);
+	CHECK(plan != NULL);
+	if (plan == NULL) {
+		return;
+	}
+	libeemd_error_code err = emd_plan_execute_batch(plan, input, num_signals, N,
+			output, M*N, noise_strength, 0, num_siftings, rng_seed);
+	CHECK(err == EMD_SUCCESS);
+	emd_plan_destroy(plan);
+}
+
+int main(void) {
+	const size_t M = emd_num_imfs(N);
+	const size_t size = num_signals*M*N;
+	double* input = malloc(num_signals*N*sizeof(double));
+	double* reference = malloc(size*sizeof(double));
+	double* output = malloc(size*sizeof(double));
+	for (size_t s=0; s<num_signals; s++) {
+		test_signal(input+s*N, N, (unsigned int)s);
+	}
+	decompose(input, reference, M, EMD_ACCUMULATE_LOCKED, 0, 0, 1);
+	decompose(input, output, M, EMD_ACCUMULATE_PRIVATE, 0, 0, 1);
+	CHECK(max_abs_diff(output, reference, size) == 0);
+	// Flushing adds the members to the output in groups
+	decompose(input, output, M, EMD_ACCUMULATE_PRIVATE, 0, 3, 1);
+	CHECK(max_abs_diff(output, reference, size) < 1e-12);
+	const unsigned int thread_counts[] = {2, 3, 4};
+	for (size_t i=0; i<sizeof(thread_counts)/sizeof(thread_counts[0]); i++) {
+		const unsigned int num_threads = thread_counts[i];
+		decompose(input, output, M, EMD_ACCUMULATE_LOCKED, 0, 0, num_threads);
+		CHECK(max_abs_diff(output, reference, size) < 1e-12);
+		decompose(input, output, M, EMD_ACCUMULATE_PRIVATE, 0, 0, num_threads);
+		CHECK(max_abs_diff(output, reference, size) < 1e-12);
+		// Only one thread gets a buffer
+		decompose(input, output, M, EMD_ACCUMULATE_PRIVATE, M*N*sizeof(double), 0, num_threads);
+		CHECK(max_abs_diff(output, reference, size) < 1e-12);
+		decompose(input, output, M, EMD_ACCUMULATE_PRIVATE, 0, 3, num_threads);
+		CHECK(max_abs_diff(output, reference, size) < 1e-12);
+	}
+	free(output);
+	free(reference);
+	free(input);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,61 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Helpers shared by the tests run by make check. Each test compares a code
+// path of libeemd with a reference computed in another way, counts the
+// failed checks and returns nonzero from main if there were any.
+
+#ifndef EEMD_CHECK_H
+#define EEMD_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+static int num_failures = 0;
+
+// Report a failed check with its location, but keep running the test
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		num_failures++; \
+	} \
+} while (0)
+
+// Largest absolute difference of arrays a and b of length n
+static inline double max_abs_diff(double const* a, double const* b, size_t n) {
+	double diff = 0;
+	for (size_t i=0; i<n; i++) {
+		diff = fmax(diff, fabs(a[i] - b[i]));
+	}
+	return diff;
+}
+
+// Signal s of a set of test signals of length N: two sines and a ramp with a
+// deterministic pseudo-random perturbation
+static inline void test_signal(double* x, size_t N, unsigned int s) {
+	uint64_t state = 12345 + 7919*s;
+	for (size_t i=0; i<N; i++) {
+		state = state*6364136223846793005u + 1442695040888963407u;
+		const double perturbation = (double)((state >> 33) % 5)/10.0;
+		x[i] = sin(0.03*(s+1)*i) + 0.3*sin(0.5*i) + 1e-4*i + perturbation;
+	}
+}
+
+#endif // EEMD_CHECK_H
@@ -0,0 +1,201 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The SIMD versions of the extrema search compared with the scalar reference
+// implementation, which they must agree with exactly, for smooth and noisy
+// signals and for signals with flat regions and zeros. The data is also
+// scanned in pieces of various lengths to check that the state is carried
+// over correctly. The versions for float data are compared with the scalar
+// version on the data widened to doubles. The versions that the processor
+// does not support are skipped. Each version writes both 32-bit and 64-bit
+// positions, which must equal the 64-bit positions of the reference. The
+// source of libeemd is included to reach its internal functions.
+
+#include "eemd.c"
+#include "check.h"
+
+typedef void (*extrema_scanner)(extrema_state* restrict st, double const* restrict x,
+		size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny);
+
+typedef void (*float_extrema_scanner)(extrema_state* restrict st,
+		float const* restrict x, size_t i_start, size_t i_end,
+		knot_array maxx, double* restrict maxy,
+		knot_array minx, double* restrict miny);
+
+typedef struct {
+	extrema_state st;
+	knot_array maxx;
+	double* maxy;
+	knot_array minx;
+	double* miny;
+} extrema;
+
+static void extrema_alloc(extrema* e, size_t N, bool wide) {
+	const size_t max_extrema = _max_num_extrema(N);
+	e->maxx.p = malloc(max_extrema*_knot_size(wide));
+	e->maxx.wide = wide;
+	e->maxy = malloc(max_extrema*sizeof(double));
+	e->minx.p = malloc(max_extrema*_knot_size(wide));
+	e->minx.wide = wide;
+	e->miny = malloc(max_extrema*sizeof(double));
+}
+
+static void extrema_free(extrema* e) {
+	free(e->maxx.p);
+	free(e->maxy);
+	free(e->minx.p);
+	free(e->miny);
+}
+
+// Whether the first n positions of a and b are equal
+static bool same_positions(knot_array a, knot_array b, size_t n) {
+	for (size_t i=0; i<n; i++) {
+		if (_knot_get(a, i) != _knot_get(b, i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Find the extrema of x with scan, called for pieces of the given length
+static void find(extrema_scanner scan, double const* x, size_t N,
+		size_t piece, extrema* e) {
+	_extrema_begin(&e->st, x[0], e->maxx, e->maxy, e->minx, e->miny);
+	for (size_t i=0; i<N-1; i+=piece) {
+		const size_t end = (N-1-i < piece)? N-1 : i+piece;
+		scan(&e->st, x, i, end, e->maxx, e->maxy, e->minx, e->miny);
+	}
+}
+
+// Same as find for float data
+static void find_float(float_extrema_scanner scan, float const* x, size_t N,
+		size_t piece, extrema* e) {
+	_extrema_begin(&e->st, x[0], e->maxx, e->maxy, e->minx, e->miny);
+	for (size_t i=0; i<N-1; i+=piece) {
+		const size_t end = (N-1-i < piece)? N-1 : i+piece;
+		scan(&e->st, x, i, end, e->maxx, e->maxy, e->minx, e->miny);
+	}
+}
+
+// Compare scan, or if it is NULL float_scan on x rounded to floats, with the
+// scalar version, writing wide or narrow positions
+static void compare(extrema_scanner scan, float_extrema_scanner float_scan,
+		double const* x, size_t N, bool wide) {
+	extrema reference, e;
+	extrema_alloc(&reference, N, true);
+	extrema_alloc(&e, N, wide);
+	double* xd = malloc(N*sizeof(double));
+	float* xf = malloc(N*sizeof(float));
+	for (size_t i=0; i<N; i++) {
+		xf[i] = (float)x[i];
+		xd[i] = (scan == NULL)? xf[i] : x[i];
+	}
+	find(_extrema_scan_scalar, xd, N, N, &reference);
+	const size_t pieces[] = {N, 1, 7, 8, 16, 61, 256};
+	for (size_t p=0; p<sizeof(pieces)/sizeof(pieces[0]); p++) {
+		if (scan != NULL) {
+			find(scan, xd, N, pieces[p], &e);
+		}
+		else {
+			find_float(float_scan, xf, N, pieces[p], &e);
+		}
+		CHECK(e.st.nmax == reference.st.nmax);
+		CHECK(e.st.nmin == reference.st.nmin);
+		CHECK(e.st.nzc == reference.st.nzc);
+		CHECK(e.st.previous_slope == reference.st.previous_slope);
+		CHECK(e.st.previous_sign == reference.st.previous_sign);
+		CHECK(e.st.flat_counter == reference.st.flat_counter);
+		if (e.st.nmax == reference.st.nmax) {
+			const size_t n = e.st.nmax;
+			CHECK(same_positions(e.maxx, reference.maxx, n));
+			CHECK(memcmp(e.maxy, reference.maxy, n*sizeof(double)) == 0);
+		}
+		if (e.st.nmin == reference.st.nmin) {
+			const size_t n = e.st.nmin;
+			CHECK(same_positions(e.minx, reference.minx, n));
+			CHECK(memcmp(e.miny, reference.miny, n*sizeof(double)) == 0);
+		}
+	}
+	free(xf);
+	free(xd);
+	extrema_free(&e);
+	extrema_free(&reference);
+}
+
+// Compare scan, or if it is NULL float_scan, with the scalar version for all
+// test signals
+static void compare_signals(extrema_scanner scan, float_extrema_scanner float_scan,
+		bool wide) {
+	const size_t N = 5000;
+	double* x = malloc(N*sizeof(double));
+	uint64_t state = 3;
+	for (unsigned int s=0; s<3; s++) {
+		test_signal(x, N, s);
+		compare(scan, float_scan, x, N, wide);
+	}
+	// White noise changes direction at about every other point
+	for (size_t i=0; i<N; i++) {
+		state = state*6364136223846793005u + 1442695040888963407u;
+		x[i] = (double)(state >> 11)/9007199254740992.0 - 0.5;
+	}
+	compare(scan, float_scan, x, N, wide);
+	// Small integers have flat regions of all lengths and exact zeros
+	for (size_t i=0; i<N; i++) {
+		state = state*6364136223846793005u + 1442695040888963407u;
+		x[i] = (double)((state >> 33) % 5) - 2;
+	}
+	compare(scan, float_scan, x, N, wide);
+	// Long flat regions, some of them at the ends and at zero
+	for (size_t i=0; i<N; i++) {
+		x[i] = (i < 20 || i > N-30)? 0 : round(3*sin(0.01*i));
+	}
+	compare(scan, float_scan, x, N, wide);
+	// Short signals with no complete SIMD block
+	for (size_t n=2; n<20; n++) {
+		test_signal(x, n, 0);
+		compare(scan, float_scan, x, n, wide);
+	}
+	free(x);
+}
+
+static void compare_all(extrema_scanner scan, float_extrema_scanner float_scan) {
+	compare_signals(scan, float_scan, true);
+	compare_signals(scan, float_scan, false);
+}
+
+int main(void) {
+	// Positions are wide only if the doubled positions do not fit in 32 bits
+	CHECK(!_knots_wide(UINT32_MAX/2));
+	CHECK(_knots_wide((size_t)UINT32_MAX/2 + 1));
+	#if EEMD_X86_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		compare_all(_extrema_scan_avx2, NULL);
+		compare_all(NULL, _extrema_scan_float_avx2);
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		compare_all(_extrema_scan_avx512, NULL);
+	}
+	#endif
+	compare_all(NULL, _extrema_scan_float_generic);
+	// The dispatching versions
+	compare_all(_extrema_scan, NULL);
+	compare_all(NULL, _extrema_scan_float);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
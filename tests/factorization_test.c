@@ -0,0 +1,98 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Spline coefficients computed with a reused factorization of the linear
+// system compared with solving the system from scratch, which must give
+// identical coefficients, and a check that sifting actually reuses
+// factorizations. The source of libeemd is included to reach its internal
+// functions.
+
+#include "eemd.c"
+#include "check.h"
+
+// Random number in [0, 1) from a linear congruential generator
+static double uniform(uint64_t* state) {
+	*state = *state*6364136223846793005u + 1442695040888963407u;
+	return (double)(*state >> 11)/9007199254740992.0;
+}
+
+int main(void) {
+	gsl_set_error_handler_off();
+	uint64_t state = 5;
+	const size_t max_N = 200;
+	const size_t num_values = 5;
+	knot_pos* p = malloc(max_N*sizeof(knot_pos));
+	const knot_array knots = {p, true};
+	double* x = malloc(max_N*sizeof(double));
+	double* y = malloc(max_N*sizeof(double));
+	double* fresh = malloc(5*max_N*sizeof(double));
+	double* factored = malloc(6*max_N*sizeof(double));
+	for (size_t N=4; N<=max_N; N++) {
+		// Knots at integer and half-integer points as found by the extrema
+		// search, with several sets of values at the same knots
+		p[0] = 0;
+		for (size_t i=1; i<N; i++) {
+			p[i] = p[i-1] + 1 + (knot_pos)(20*uniform(&state));
+		}
+		for (size_t i=0; i<N; i++) {
+			x[i] = _knot_x(p[i]);
+		}
+		for (size_t k=0; k<num_values; k++) {
+			for (size_t i=0; i<N; i++) {
+				y[i] = uniform(&state) - 0.5;
+			}
+			CHECK(_spline_coefficients(x, y, N, fresh) == EMD_SUCCESS);
+			CHECK(_spline_coefficients_factored(knots, y, N, factored, k > 0) == EMD_SUCCESS);
+			// c, b and d are at the start of the workspace of
+			// _spline_coefficients, and the factorization is between c and
+			// b in the workspace of _spline_coefficients_factored
+			const size_t n = N-1;
+			double const* const c = factored;
+			double const* const b = factored + N + (N-2) + 2*(N-3);
+			double const* const d = b+n;
+			CHECK(memcmp(c, fresh, N*sizeof(double)) == 0);
+			CHECK(memcmp(b, fresh+N, n*sizeof(double)) == 0);
+			CHECK(memcmp(d, fresh+N+n, n*sizeof(double)) == 0);
+		}
+	}
+	// Sifting a smooth signal reuses factorizations, since the extrema stay
+	// in place between iterations
+	const size_t N = 2000;
+	double* signal = malloc(N*sizeof(double));
+	test_signal(signal, N, 0);
+	const size_t M = emd_num_imfs(N);
+	double* output = malloc(M*N*sizeof(double));
+	emd_plan* plan = emd_plan_create(EMD_VARIANT_EEMD, N, M, 1, 1);
+	CHECK(plan != NULL);
+	if (plan != NULL) {
+		CHECK(emd_plan_execute(plan, signal, output, 0, 0, 20, 0) == EMD_SUCCESS);
+		emd_plan_stats stats;
+		emd_plan_get_stats(plan, &stats);
+		CHECK(stats.envelopes > 0);
+		CHECK(stats.reused_factorizations > 0);
+		emd_plan_destroy(plan);
+	}
+	free(output);
+	free(signal);
+	free(factored);
+	free(fresh);
+	free(y);
+	free(x);
+	free(p);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
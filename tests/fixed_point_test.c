@@ -0,0 +1,87 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Decomposing int16 and int32 samples compared with converting them to
+// doubles first. Without noise the results must be identical. With noise
+// only the standard deviation of the signal, and hence the scale of the
+// noise, may differ by rounding, so the IMFs of the signals, which are of
+// order one, must agree to within 1e-15.
+
+#include <stdint.h>
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 2000;
+const unsigned int ensemble_size = 8;
+const unsigned int num_siftings = 10;
+const unsigned long int rng_seed = 5;
+
+static void compare(emd_variant variant, unsigned int E, double noise_strength,
+		int16_t const* samples16, int32_t const* samples32,
+		double const* signal16, double const* signal32, double scale16,
+		double scale32) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	double* output = malloc(M*N*sizeof(double));
+	emd_plan* plan = emd_plan_create(variant, N, M, E, 2);
+	CHECK(plan != NULL);
+	if (plan != NULL) {
+		const double tolerance = (noise_strength == 0)? 0 : 1e-15;
+		CHECK(emd_plan_execute(plan, signal16, reference, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(emd_plan_execute_int16(plan, samples16, scale16, output,
+					noise_strength, 0, num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(max_abs_diff(output, reference, M*N) <= tolerance);
+		CHECK(emd_plan_execute(plan, signal32, reference, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(emd_plan_execute_int32(plan, samples32, scale32, output,
+					noise_strength, 0, num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(max_abs_diff(output, reference, M*N) <= tolerance);
+		emd_plan_destroy(plan);
+	}
+	free(output);
+	free(reference);
+}
+
+int main(void) {
+	double* x = malloc(N*sizeof(double));
+	int16_t* samples16 = malloc(N*sizeof(int16_t));
+	int32_t* samples32 = malloc(N*sizeof(int32_t));
+	double* signal16 = malloc(N*sizeof(double));
+	double* signal32 = malloc(N*sizeof(double));
+	// Samples of an ADC spanning most of the range of each type, and scales
+	// that are not powers of two
+	test_signal(x, N, 0);
+	const double scale16 = 1e-4;
+	const double scale32 = 3e-9;
+	for (size_t i=0; i<N; i++) {
+		samples16[i] = (int16_t)lround(10000*x[i]);
+		samples32[i] = (int32_t)lround(6e8*x[i]);
+		signal16[i] = scale16*samples16[i];
+		signal32[i] = scale32*samples32[i];
+	}
+	compare(EMD_VARIANT_EEMD, 1, 0, samples16, samples32, signal16, signal32, scale16, scale32);
+	compare(EMD_VARIANT_EEMD, ensemble_size, 0.2, samples16, samples32, signal16, signal32, scale16, scale32);
+	compare(EMD_VARIANT_CEEMDAN, ensemble_size, 0.2, samples16, samples32, signal16, signal32, scale16, scale32);
+	free(signal32);
+	free(signal16);
+	free(samples32);
+	free(samples16);
+	free(x);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
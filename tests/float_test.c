@@ -0,0 +1,119 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The single-precision path compared with decomposing the same signal,
+// rounded to floats, in double precision. The signal is of order one, so
+// sifting it as floats must change the first IMF by less than 1e-6, also when
+// the IMFs of the ensemble members are summed as floats. Plans for one
+// precision must refuse data of the other.
+
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 2000;
+const unsigned int ensemble_size = 8;
+const unsigned int num_siftings = 10;
+const unsigned long int rng_seed = 5;
+const double noise_strength = 0.2;
+
+// Largest difference of the first IMF of float output and double reference
+static double first_imf_diff(float const* output, double const* reference) {
+	double diff = 0;
+	for (size_t i=0; i<N; i++) {
+		diff = fmax(diff, fabs(output[i] - reference[i]));
+	}
+	return diff;
+}
+
+// Decompose xf with a float plan summing in sum_precision and compare with
+// the double plan of the same options on x
+static void compare_plan(emd_variant variant, emd_precision sum_precision,
+		double const* x, float const* xf) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	float* output = malloc(M*N*sizeof(float));
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.threading = EMD_THREADS_OPENMP;
+	emd_plan* double_plan = emd_plan_create_with_options(variant, N, M,
+			ensemble_size, 2, &options);
+	options.precision = EMD_PRECISION_FLOAT;
+	options.sum_precision = sum_precision;
+	emd_plan* float_plan = emd_plan_create_with_options(variant, N, M,
+			ensemble_size, 2, &options);
+	CHECK(double_plan != NULL);
+	CHECK(float_plan != NULL);
+	if (double_plan != NULL && float_plan != NULL) {
+		CHECK(emd_plan_execute(double_plan, x, reference, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(emd_plan_execute_float(float_plan, xf, output, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(first_imf_diff(output, reference) <= 1e-6);
+		// Data of the wrong precision is refused
+		CHECK(emd_plan_execute(float_plan, x, reference, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_PRECISION_MISMATCH);
+		CHECK(emd_plan_execute_float(double_plan, xf, output, noise_strength,
+					0, num_siftings, rng_seed) == EMD_PRECISION_MISMATCH);
+	}
+	emd_plan_destroy(float_plan);
+	emd_plan_destroy(double_plan);
+	free(output);
+	free(reference);
+}
+
+// Compare eemdf or ceemdanf with eemd or ceemdan
+static void compare_routine(emd_variant variant, double const* x,
+		float const* xf) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	float* output = malloc(M*N*sizeof(float));
+	if (variant == EMD_VARIANT_EEMD) {
+		CHECK(eemd(x, N, reference, M, ensemble_size, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(eemdf(xf, N, output, M, ensemble_size, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+	}
+	else {
+		CHECK(ceemdan(x, N, reference, M, ensemble_size, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(ceemdanf(xf, N, output, M, ensemble_size, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+	}
+	CHECK(first_imf_diff(output, reference) <= 1e-6);
+	free(output);
+	free(reference);
+}
+
+int main(void) {
+	double* x = malloc(N*sizeof(double));
+	float* xf = malloc(N*sizeof(float));
+	test_signal(x, N, 0);
+	for (size_t i=0; i<N; i++) {
+		xf[i] = (float)x[i];
+		x[i] = xf[i];
+	}
+	compare_routine(EMD_VARIANT_EEMD, x, xf);
+	compare_routine(EMD_VARIANT_CEEMDAN, x, xf);
+	compare_plan(EMD_VARIANT_EEMD, EMD_PRECISION_DOUBLE, x, xf);
+	compare_plan(EMD_VARIANT_EEMD, EMD_PRECISION_FLOAT, x, xf);
+	compare_plan(EMD_VARIANT_CEEMDAN, EMD_PRECISION_DOUBLE, x, xf);
+	compare_plan(EMD_VARIANT_CEEMDAN, EMD_PRECISION_FLOAT, x, xf);
+	free(xf);
+	free(x);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Decomposing interleaved channels to IMFs stored sample by sample, and
+// padded signals to padded IMFs, with emd_plan_execute_strided, compared with
+// contiguous data decomposed with emd_plan_execute_batch by the same plan.
+// The results must agree to within 1e-15 for EMD, EEMD and CEEMDAN, with both
+// the OpenMP threads and the thread pool, whichever of them libeemd was built
+// with.
+
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 1500;
+const size_t num_signals = 3;
+const unsigned int num_siftings = 10;
+const unsigned long int rng_seed = 9;
+const size_t padding = 5;
+
+static void compare(emd_variant variant, unsigned int ensemble_size,
+		double noise_strength, emd_threading threading, unsigned int num_threads) {
+	const size_t M = emd_num_imfs(N);
+	const size_t size = num_signals*M*N;
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.threading = threading;
+	emd_plan* plan = emd_plan_create_with_options(variant, N, M, ensemble_size,
+			num_threads, &options);
+	if (plan == NULL) {
+		// libeemd was built without this backend
+		return;
+	}
+	double* input = malloc(num_signals*N*sizeof(double));
+	double* interleaved = malloc(num_signals*N*sizeof(double));
+	double* padded = malloc(num_signals*(N+padding)*sizeof(double));
+	double* reference = malloc(size*sizeof(double));
+	double* output = malloc(num_signals*M*(N+padding)*sizeof(double));
+	double* transposed = malloc(size*sizeof(double));
+	for (size_t s=0; s<num_signals; s++) {
+		test_signal(input+s*N, N, (unsigned int)s);
+		for (size_t j=0; j<N; j++) {
+			interleaved[j*num_signals+s] = input[s*N+j];
+			padded[s*(N+padding)+j] = input[s*N+j];
+		}
+	}
+	CHECK(emd_plan_execute_batch(plan, input, num_signals, N, reference, M*N,
+				noise_strength, 0, num_siftings, rng_seed) == EMD_SUCCESS);
+	// Channels interleaved sample by sample, with the IMFs of each channel
+	// stored sample by sample
+	const emd_input_layout channels = {num_signals, 1};
+	const emd_output_layout samples = {M, 1, M*N};
+	CHECK(emd_plan_execute_strided(plan, interleaved, &channels, num_signals,
+				output, &samples, noise_strength, 0, num_siftings, rng_seed) == EMD_SUCCESS);
+	for (size_t s=0; s<num_signals; s++) {
+		for (size_t m=0; m<M; m++) {
+			for (size_t j=0; j<N; j++) {
+				transposed[(s*M+m)*N+j] = output[s*M*N+j*M+m];
+			}
+		}
+	}
+	CHECK(max_abs_diff(transposed, reference, size) <= 1e-15);
+	// Padded signals and IMFs
+	const emd_input_layout padded_input = {1, N+padding};
+	const emd_output_layout padded_output = {1, N+padding, M*(N+padding)};
+	CHECK(emd_plan_execute_strided(plan, padded, &padded_input, num_signals,
+				output, &padded_output, noise_strength, 0, num_siftings, rng_seed) == EMD_SUCCESS);
+	for (size_t s=0; s<num_signals; s++) {
+		for (size_t m=0; m<M; m++) {
+			for (size_t j=0; j<N; j++) {
+				transposed[(s*M+m)*N+j] = output[(s*M+m)*(N+padding)+j];
+			}
+		}
+	}
+	CHECK(max_abs_diff(transposed, reference, size) <= 1e-15);
+	// NULL layouts mean contiguous data
+	CHECK(emd_plan_execute_strided(plan, input, NULL, num_signals, output, NULL,
+				noise_strength, 0, num_siftings, rng_seed) == EMD_SUCCESS);
+	CHECK(max_abs_diff(output, reference, size) <= 1e-15);
+	free(transposed);
+	free(output);
+	free(reference);
+	free(padded);
+	free(interleaved);
+	free(input);
+	emd_plan_destroy(plan);
+}
+
+int main(void) {
+	const emd_threading backends[] = {EMD_THREADS_OPENMP, EMD_THREADS_POOL};
+	const unsigned int thread_counts[] = {1, 3};
+	for (size_t b=0; b<2; b++) {
+		for (size_t t=0; t<sizeof(thread_counts)/sizeof(thread_counts[0]); t++) {
+			compare(EMD_VARIANT_EEMD, 1, 0, backends[b], thread_counts[t]);
+			compare(EMD_VARIANT_EEMD, 8, 0.2, backends[b], thread_counts[t]);
+			compare(EMD_VARIANT_CEEMDAN, 8, 0.2, backends[b], thread_counts[t]);
+		}
+	}
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,93 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The routines of libeemd in a build without OpenMP, where the thread pool is
+// the default backend if it is built. The source of libeemd is included and
+// compiled without OpenMP, whatever libeemd itself was built with. The first
+// IMF of eemdf and ceemdanf is compared with eemd and ceemdan of the same
+// signal rounded to floats. The signal is of order one, so storing it as
+// floats while sifting changes the IMF by less than 1e-6.
+
+#include "eemd.c"
+#include "check.h"
+
+#ifdef _OPENMP
+#error "This test must be compiled without OpenMP"
+#endif
+
+const size_t N = 2000;
+const unsigned int ensemble_size = 8;
+const unsigned int num_siftings = 10;
+const unsigned long int rng_seed = 5;
+
+static void compare(emd_variant variant, double const* x, float const* xf) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	float* output = malloc(M*N*sizeof(float));
+	double* first = malloc(N*sizeof(double));
+	libeemd_error_code err;
+	if (variant == EMD_VARIANT_EEMD) {
+		CHECK(eemd(x, N, reference, M, ensemble_size, 0.2, 0, num_siftings,
+					rng_seed) == EMD_SUCCESS);
+		err = eemdf(xf, N, output, M, ensemble_size, 0.2, 0, num_siftings, rng_seed);
+	}
+	else {
+		CHECK(ceemdan(x, N, reference, M, ensemble_size, 0.2, 0, num_siftings,
+					rng_seed) == EMD_SUCCESS);
+		err = ceemdanf(xf, N, output, M, ensemble_size, 0.2, 0, num_siftings, rng_seed);
+	}
+	CHECK(err == EMD_SUCCESS);
+	if (err == EMD_SUCCESS) {
+		for (size_t i=0; i<N; i++) {
+			first[i] = output[i];
+		}
+		CHECK(max_abs_diff(first, reference, N) <= 1e-6);
+	}
+	free(first);
+	free(output);
+	free(reference);
+}
+
+int main(void) {
+	double* x = malloc(N*sizeof(double));
+	float* xf = malloc(N*sizeof(float));
+	test_signal(x, N, 0);
+	for (size_t i=0; i<N; i++) {
+		xf[i] = (float)x[i];
+		x[i] = xf[i];
+	}
+	// The pool is the default if it was built
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	CHECK(options.threading == (EEMD_THREAD_POOL? EMD_THREADS_POOL : EMD_THREADS_OPENMP));
+	compare(EMD_VARIANT_EEMD, x, xf);
+	compare(EMD_VARIANT_CEEMDAN, x, xf);
+	// A float plan with the OpenMP backend runs on a single thread
+	options.precision = EMD_PRECISION_FLOAT;
+	options.threading = EMD_THREADS_OPENMP;
+	emd_plan* plan = emd_plan_create_with_options(EMD_VARIANT_EEMD, N, 0,
+			ensemble_size, 0, &options);
+	CHECK(plan != NULL);
+	if (plan != NULL) {
+		CHECK(plan->num_threads == 1);
+		emd_plan_destroy(plan);
+	}
+	free(xf);
+	free(x);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
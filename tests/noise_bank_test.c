@@ -0,0 +1,121 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// CEEMDAN with a noise bank compared with a plan sifting the noise itself,
+// with both random number generators. The results must be identical, also
+// for a plan with hardly any memory for noise, for a bank saved to a file and
+// loaded back, and for every signal of a batch, which all use the same noise.
+
+#include <stdio.h>
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 1500;
+const unsigned int ensemble_size = 8;
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 11;
+const char* const filename = "noise_bank_test.bank";
+
+static emd_plan* create_plan(size_t M, emd_rng_type rng,
+		size_t noise_memory_limit, unsigned int num_threads) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.rng = rng;
+	options.noise_memory_limit = noise_memory_limit;
+	emd_plan* plan = emd_plan_create_with_options(EMD_VARIANT_CEEMDAN, N, M,
+			ensemble_size, num_threads, &options);
+	CHECK(plan != NULL);
+	return plan;
+}
+
+int main(void) {
+	const size_t M = emd_num_imfs(N);
+	const size_t num_signals = 3;
+	double* input = malloc(num_signals*N*sizeof(double));
+	double* reference = malloc(M*N*sizeof(double));
+	double* output = malloc(num_signals*M*N*sizeof(double));
+	for (size_t s=0; s<num_signals; s++) {
+		test_signal(input+s*N, N, (unsigned int)s);
+	}
+	const emd_rng_type rngs[] = {EMD_RNG_PHILOX, EMD_RNG_MT19937};
+	const unsigned int thread_counts[] = {1, 3};
+	for (size_t r=0; r<2; r++) {
+		emd_noise_bank* bank = emd_noise_bank_create(N, M, ensemble_size, 0,
+				num_siftings, rng_seed, rngs[r], 2);
+		CHECK(bank != NULL);
+		if (bank == NULL) {
+			continue;
+		}
+		CHECK(emd_noise_bank_save(bank, filename) == EMD_SUCCESS);
+		emd_noise_bank* loaded = emd_noise_bank_load(filename);
+		CHECK(loaded != NULL);
+		remove(filename);
+		for (size_t t=0; t<sizeof(thread_counts)/sizeof(thread_counts[0]); t++) {
+			emd_plan* plan = create_plan(M, rngs[r], 0, thread_counts[t]);
+			emd_plan* small_plan = create_plan(M, rngs[r], 1, thread_counts[t]);
+			if (plan == NULL || small_plan == NULL) {
+				emd_plan_destroy(plan);
+				emd_plan_destroy(small_plan);
+				continue;
+			}
+			for (size_t s=0; s<num_signals; s++) {
+				double const* signal = input+s*N;
+				CHECK(emd_plan_execute(plan, signal, reference, noise_strength, 0,
+							num_siftings, rng_seed) == EMD_SUCCESS);
+				CHECK(emd_plan_execute_with_noise_bank(plan, bank, signal, output,
+							noise_strength) == EMD_SUCCESS);
+				CHECK(max_abs_diff(output, reference, M*N) == 0);
+				CHECK(emd_plan_execute_with_noise_bank(small_plan, bank, signal,
+							output, noise_strength) == EMD_SUCCESS);
+				CHECK(max_abs_diff(output, reference, M*N) == 0);
+				if (loaded != NULL) {
+					CHECK(emd_plan_execute_with_noise_bank(plan, loaded, signal,
+								output, noise_strength) == EMD_SUCCESS);
+					CHECK(max_abs_diff(output, reference, M*N) == 0);
+				}
+			}
+			// Every signal of a batch uses the same noise, so each one gets
+			// the result of executing the plan with the bank alone
+			CHECK(emd_plan_execute_batch_with_noise_bank(small_plan, bank, input,
+						num_signals, N, output, M*N, noise_strength) == EMD_SUCCESS);
+			for (size_t s=0; s<num_signals; s++) {
+				CHECK(emd_plan_execute(plan, input+s*N, reference, noise_strength, 0,
+							num_siftings, rng_seed) == EMD_SUCCESS);
+				CHECK(max_abs_diff(output+s*M*N, reference, M*N) == 0);
+			}
+			emd_plan_destroy(small_plan);
+			emd_plan_destroy(plan);
+		}
+		// A bank for signals of another length does not match the plan
+		emd_plan* other_plan = emd_plan_create(EMD_VARIANT_CEEMDAN, N+1, M,
+				ensemble_size, 1);
+		CHECK(other_plan != NULL);
+		if (other_plan != NULL) {
+			CHECK(emd_plan_execute_with_noise_bank(other_plan, bank, input,
+						output, noise_strength) == EMD_INCOMPATIBLE_NOISE_BANK);
+			emd_plan_destroy(other_plan);
+		}
+		emd_noise_bank_destroy(loaded);
+		emd_noise_bank_destroy(bank);
+	}
+	free(output);
+	free(reference);
+	free(input);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,88 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// CEEMDAN with a noise memory limit, which regenerates the noise of the
+// members that do not fit, compared with keeping all noise in memory. The
+// results must be identical for single signals and batches, with both the
+// OpenMP threads and the thread pool, whichever of them libeemd was built
+// with.
+
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 1500;
+const unsigned int ensemble_size = 8;
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 3;
+
+// Returns false if the plan could not be created because libeemd was built
+// without the threading backend
+static bool decompose(double const* input, size_t num_signals, double* output,
+		size_t M, size_t noise_memory_limit, emd_threading threading,
+		unsigned int num_threads) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.noise_memory_limit = noise_memory_limit;
+	options.threading = threading;
+	emd_plan* plan = emd_plan_create_with_options(EMD_VARIANT_CEEMDAN, N, M,
+			ensemble_size, num_threads, &options);
+	if (plan == NULL) {
+		return false;
+	}
+	libeemd_error_code err = emd_plan_execute_batch(plan, input, num_signals, N,
+			output, M*N, noise_strength, 0, num_siftings, rng_seed);
+	CHECK(err == EMD_SUCCESS);
+	emd_plan_destroy(plan);
+	return true;
+}
+
+int main(void) {
+	const size_t M = emd_num_imfs(N);
+	const size_t max_signals = 3;
+	const size_t size = max_signals*M*N;
+	const size_t member_size = 3*N*sizeof(double);
+	double* input = malloc(max_signals*N*sizeof(double));
+	double* reference = malloc(size*sizeof(double));
+	double* output = malloc(size*sizeof(double));
+	for (size_t s=0; s<max_signals; s++) {
+		test_signal(input+s*N, N, (unsigned int)s);
+	}
+	const emd_threading backends[] = {EMD_THREADS_OPENMP, EMD_THREADS_POOL};
+	const unsigned int thread_counts[] = {1, 2, 3, 9};
+	const size_t num_resident[] = {0, 1, 5, 7};
+	for (size_t b=0; b<2; b++) {
+		for (size_t t=0; t<sizeof(thread_counts)/sizeof(thread_counts[0]); t++) {
+			for (size_t num_signals=1; num_signals<=max_signals; num_signals+=2) {
+				if (!decompose(input, num_signals, reference, M, 0, backends[b], thread_counts[t])) {
+					break;
+				}
+				for (size_t r=0; r<sizeof(num_resident)/sizeof(num_resident[0]); r++) {
+					// Zero means no limit, so the smallest limit is a byte
+					const size_t limit = (num_resident[r] == 0)? 1 : num_resident[r]*member_size;
+					decompose(input, num_signals, output, M, limit, backends[b], thread_counts[t]);
+					CHECK(max_abs_diff(output, reference, num_signals*M*N) == 0);
+				}
+			}
+		}
+	}
+	free(output);
+	free(reference);
+	free(input);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,98 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The Philox noise generator: the known-answer tests of the Random123
+// library for Philox4x32-10, the SIMD versions of the Gaussian noise
+// compared with the scalar version, which they must agree with exactly, and
+// the mean and variance of the noise. The versions that the processor does
+// not support are skipped. The source of libeemd is included to reach its
+// internal functions.
+
+#include "eemd.c"
+#include "check.h"
+
+typedef size_t (*noise_filler)(uint64_t stream, double sigma,
+		double const* restrict base, double* restrict out, size_t N);
+
+static void check_philox(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3,
+		uint32_t key0, uint32_t key1, uint32_t r0, uint32_t r1, uint32_t r2,
+		uint32_t r3) {
+	uint32_t ctr[4] = {c0, c1, c2, c3};
+	_philox4x32_10(ctr, key0, key1);
+	CHECK(ctr[0] == r0 && ctr[1] == r1 && ctr[2] == r2 && ctr[3] == r3);
+}
+
+// Generate noise of lengths up to 100 and a few longer ones with fill,
+// completed by the scalar version, and compare with the scalar version alone
+static void compare(noise_filler fill) {
+	const size_t max_N = 1000;
+	double* base = malloc(max_N*sizeof(double));
+	double* reference = malloc(max_N*sizeof(double));
+	double* out = malloc(max_N*sizeof(double));
+	test_signal(base, max_N, 0);
+	const uint64_t streams[] = {0, 1, 12345, 0xffffffffu, 0x123456789abcdefu};
+	for (size_t k=0; k<sizeof(streams)/sizeof(streams[0]); k++) {
+		for (size_t N=0; N<=max_N; N=(N < 100)? N+1 : N+299) {
+			for (int with_base=0; with_base<2; with_base++) {
+				double const* b = with_base? base : NULL;
+				_philox_gaussian_fill_scalar(streams[k], 0.7, b, reference, 0, N);
+				const size_t done = fill(streams[k], 0.7, b, out, N);
+				CHECK(done <= N && done%16 == 0);
+				_philox_gaussian_fill_scalar(streams[k], 0.7, b, out, done, N);
+				CHECK(memcmp(out, reference, N*sizeof(double)) == 0);
+			}
+		}
+	}
+	free(out);
+	free(reference);
+	free(base);
+}
+
+int main(void) {
+	check_philox(0, 0, 0, 0, 0, 0,
+			0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8);
+	check_philox(0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+			0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd);
+	check_philox(0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+			0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1);
+	#if EEMD_X86_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		compare(_philox_gaussian_fill_avx2);
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		compare(_philox_gaussian_fill_avx512);
+	}
+	#endif
+	// The noise generated by the dispatching version has zero mean and unit
+	// variance within a few standard errors
+	const size_t N = 1000000;
+	double* noise = malloc(N*sizeof(double));
+	_generate_noise(NULL, EMD_RNG_PHILOX, 5, 1.0, NULL, noise, N);
+	double sum = 0;
+	double sum_of_squares = 0;
+	for (size_t i=0; i<N; i++) {
+		sum += noise[i];
+		sum_of_squares += noise[i]*noise[i];
+	}
+	const double mean = sum/N;
+	const double variance = sum_of_squares/N - mean*mean;
+	CHECK(fabs(mean) < 5/sqrt(N));
+	CHECK(fabs(variance - 1) < 5*sqrt(2.0/N));
+	free(noise);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,132 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Batches of tridiagonal systems of mixed sizes, some to be factorized and
+// some already factorized, solved with _spline_batch_solve and compared with
+// solving each of them with _factor_tridiag and _solve_factored_tridiag. The
+// solutions and factorizations must be identical. Batches of more systems
+// than lanes are solved in groups sorted by size. The source of libeemd is
+// included to reach its internal functions.
+
+#include "eemd.c"
+#include "check.h"
+
+// Random number in [0, 1) from a linear congruential generator
+static double uniform(uint64_t* state) {
+	*state = *state*6364136223846793005u + 1442695040888963407u;
+	return (double)(*state >> 11)/9007199254740992.0;
+}
+
+// A system and its reference solution: diag, supdiag, mult, g and x for the
+// batch and the same for the reference, max_n doubles each
+typedef struct {
+	size_t n;
+	bool factor;
+	double* arrays;
+} test_system;
+
+// Solve num_systems random systems of sizes up to max_n in a batch and
+// compare with the reference. If singular is less than num_systems, that
+// system is made singular, and the rest must still be solved.
+static void compare(size_t num_systems, size_t max_n, size_t singular,
+		uint64_t* state) {
+	test_system* systems = malloc(num_systems*sizeof(test_system));
+	arena measure = {NULL, 0};
+	_carve_spline_batch(&measure, num_systems, max_n);
+	arena a = {malloc(measure.used), 0};
+	spline_batch* batch = _carve_spline_batch(&a, num_systems, max_n);
+	for (size_t k=0; k<num_systems; k++) {
+		test_system* const sys = &systems[k];
+		sys->n = 1 + (size_t)(max_n*uniform(state));
+		if (sys->n > max_n) {
+			sys->n = max_n;
+		}
+		sys->factor = (uniform(state) < 0.5);
+		sys->arrays = malloc(10*max_n*sizeof(double));
+		double* const diag = sys->arrays;
+		double* const supdiag = diag + max_n;
+		double* const mult = supdiag + max_n;
+		double* const g = mult + max_n;
+		double* const ref = sys->arrays + 5*max_n;
+		for (size_t i=0; i<sys->n; i++) {
+			diag[i] = 2.5 + uniform(state);
+			supdiag[i] = 2*uniform(state) - 1;
+			mult[i] = 2*uniform(state) - 1;
+			g[i] = 10*(uniform(state) - 0.5);
+		}
+		if (k == singular) {
+			diag[sys->n-1] = 0;
+			if (sys->n > 1) {
+				mult[sys->n-2] = 0;
+			}
+		}
+		if (!sys->factor && k != singular) {
+			CHECK(_factor_tridiag(diag, supdiag, mult, sys->n) == EMD_SUCCESS);
+		}
+		// The reference keeps its own copy of the system
+		memcpy(ref, sys->arrays, 4*max_n*sizeof(double));
+		double* const ref_diag = ref;
+		double* const ref_supdiag = ref + max_n;
+		double* const ref_mult = ref + 2*max_n;
+		double* const ref_g = ref + 3*max_n;
+		double* const ref_x = ref + 4*max_n;
+		if (k != singular) {
+			if (sys->factor) {
+				CHECK(_factor_tridiag(ref_diag, ref_supdiag, ref_mult, sys->n) == EMD_SUCCESS);
+			}
+			_solve_factored_tridiag(ref_diag, ref_supdiag, ref_mult, ref_g, ref_x, sys->n);
+		}
+		double* const x = g + max_n;
+		_spline_batch_add(batch, diag, supdiag, mult, g, x, sys->n,
+				sys->factor || k == singular);
+	}
+	const libeemd_error_code expected = (singular < num_systems)?
+		EMD_SINGULAR_SPLINE_SYSTEM : EMD_SUCCESS;
+	CHECK(_spline_batch_solve(batch) == expected);
+	for (size_t k=0; k<num_systems; k++) {
+		test_system* const sys = &systems[k];
+		if (k != singular) {
+			double const* const batch_diag = sys->arrays;
+			double const* const batch_mult = sys->arrays + 2*max_n;
+			double const* const batch_x = sys->arrays + 4*max_n;
+			double const* const ref = sys->arrays + 5*max_n;
+			CHECK(memcmp(batch_x, ref + 4*max_n, sys->n*sizeof(double)) == 0);
+			CHECK(memcmp(batch_diag, ref, sys->n*sizeof(double)) == 0);
+			CHECK(memcmp(batch_mult, ref + 2*max_n, (sys->n-1)*sizeof(double)) == 0);
+		}
+		free(sys->arrays);
+	}
+	free(a.base);
+	free(systems);
+}
+
+int main(void) {
+	uint64_t state = 9;
+	const size_t max_n = 200;
+	const size_t num_rounds = 20;
+	for (size_t num_systems=1; num_systems<=3*EEMD_SPLINE_BATCH_LANES+1; num_systems++) {
+		for (size_t r=0; r<num_rounds; r++) {
+			compare(num_systems, max_n, num_systems, &state);
+		}
+		// A singular system in any position of the batch
+		for (size_t singular=0; singular<num_systems; singular++) {
+			compare(num_systems, max_n, singular, &state);
+		}
+	}
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
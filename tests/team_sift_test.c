@@ -0,0 +1,74 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Sifting a signal with the whole OpenMP thread team compared with sifting
+// it with a single thread. Without the partitioned spline solver the results
+// must be identical for EMD, EEMD and CEEMDAN, also when CEEMDAN keeps only
+// part of its noise in memory. Without OpenMP both plans use one thread.
+
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 30000;
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 7;
+
+static void decompose(emd_variant variant, unsigned int ensemble_size,
+		double const* input, double* output, size_t M,
+		size_t noise_memory_limit, unsigned int num_threads) {
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.threading = EMD_THREADS_OPENMP;
+	options.parallel_sift_min_length = 1000;
+	options.parallel_solve_min_knots = 0;
+	options.noise_memory_limit = noise_memory_limit;
+	emd_plan* plan = emd_plan_create_with_options(variant, N, M, ensemble_size,
+			num_threads, &options);
+	CHECK(plan != NULL);
+	if (plan != NULL) {
+		const double strength = (ensemble_size == 1)? 0 : noise_strength;
+		CHECK(emd_plan_execute(plan, input, output, strength, 0, num_siftings,
+					rng_seed) == EMD_SUCCESS);
+		emd_plan_destroy(plan);
+	}
+}
+
+static void compare(emd_variant variant, unsigned int ensemble_size,
+		double const* input, size_t noise_memory_limit) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	double* output = malloc(M*N*sizeof(double));
+	decompose(variant, ensemble_size, input, reference, M, 0, 1);
+	decompose(variant, ensemble_size, input, output, M, noise_memory_limit, 4);
+	CHECK(max_abs_diff(output, reference, M*N) == 0);
+	free(output);
+	free(reference);
+}
+
+int main(void) {
+	double* input = malloc(N*sizeof(double));
+	test_signal(input, N, 0);
+	const size_t member_size = 3*N*sizeof(double);
+	compare(EMD_VARIANT_EEMD, 1, input, 0);
+	compare(EMD_VARIANT_EEMD, 2, input, 0);
+	compare(EMD_VARIANT_CEEMDAN, 2, input, 0);
+	compare(EMD_VARIANT_CEEMDAN, 2, input, member_size);
+	free(input);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,206 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The tridiagonal solver of libeemd compared with gsl_linalg_solve_tridiag
+// for spline systems of random knots and for random diagonally dominant
+// systems. The partitioned solver of a team of threads is compared with
+// it for systems of several partitions, and must detect a singular partition.
+// The routines such as eemd must not use the partitioned solver.
+// The source of libeemd is included to reach its internal functions.
+
+#include "eemd.c"
+#include "check.h"
+
+// Random number in [0, 1) from a linear congruential generator
+static double uniform(uint64_t* state) {
+	*state = *state*6364136223846793005u + 1442695040888963407u;
+	return (double)(*state >> 11)/9007199254740992.0;
+}
+
+// Solve the system of size n with both solvers and compare the solutions
+static void compare(double* diag, double* supdiag, double* subdiag, double* g,
+		size_t n) {
+	double* work = malloc(4*n*sizeof(double));
+	double* const x = work;
+	double* const x_gsl = work+n;
+	double* const diag_copy = work+2*n;
+	double* const g_copy = work+3*n;
+	memcpy(diag_copy, diag, n*sizeof(double));
+	memcpy(g_copy, g, n*sizeof(double));
+	CHECK(_solve_tridiag(diag_copy, supdiag, subdiag, g_copy, x, n) == EMD_SUCCESS);
+	gsl_vector_view diag_vec = gsl_vector_view_array(diag, n);
+	gsl_vector_view supdiag_vec = gsl_vector_view_array(supdiag, n-1);
+	gsl_vector_view subdiag_vec = gsl_vector_view_array(subdiag, n-1);
+	gsl_vector_view g_vec = gsl_vector_view_array(g, n);
+	gsl_vector_view x_vec = gsl_vector_view_array(x_gsl, n);
+	CHECK(gsl_linalg_solve_tridiag(&diag_vec.vector, &supdiag_vec.vector,
+				&subdiag_vec.vector, &g_vec.vector, &x_vec.vector) == GSL_SUCCESS);
+	// The operations are the same, so only contracting them to fused
+	// multiply-adds can make a difference
+	double scale = 0;
+	for (size_t i=0; i<n; i++) {
+		scale = fmax(scale, fabs(x_gsl[i]));
+	}
+	CHECK(max_abs_diff(x, x_gsl, n) <= 1e-13*scale);
+	free(work);
+}
+
+// Solve the system of size n with the partitioned solver of a team of
+// num_threads threads and compare with _solve_tridiag if both succeed.
+// Returns the error of the partitioned solver.
+static libeemd_error_code compare_team(double const* diag, double const* supdiag,
+		double const* subdiag, double const* g, size_t n, int num_threads) {
+	// The team is sized for a signal with at least n extrema
+	arena measure = {NULL, 0};
+	_carve_sifting_team(&measure, 2*n, (size_t)num_threads, 1);
+	arena a = {malloc(measure.used), 0};
+	sifting_team* team = _carve_sifting_team(&a, 2*n, (size_t)num_threads, 1);
+	double* work = malloc(6*n*sizeof(double));
+	double* const x = work;
+	double* const x_team = work+n;
+	double* const diag_copy = work+2*n;
+	double* const g_copy = work+3*n;
+	double* const diag_team = work+4*n;
+	double* const g_team = work+5*n;
+	memcpy(diag_copy, diag, n*sizeof(double));
+	memcpy(g_copy, g, n*sizeof(double));
+	memcpy(diag_team, diag, n*sizeof(double));
+	memcpy(g_team, g, n*sizeof(double));
+	const libeemd_error_code err = _solve_tridiag(diag_copy, supdiag, subdiag,
+			g_copy, x, n);
+	libeemd_error_code team_err = EMD_SUCCESS;
+	#pragma omp parallel num_threads(num_threads)
+	{
+		const libeemd_error_code thread_err = _solve_tridiag_team(diag_team,
+				supdiag, subdiag, g_team, x_team, n, team);
+		#pragma omp master
+		team_err = thread_err;
+	}
+	if (err == EMD_SUCCESS && team_err == EMD_SUCCESS) {
+		double scale = 0;
+		for (size_t i=0; i<n; i++) {
+			scale = fmax(scale, fabs(x[i]));
+		}
+		CHECK(max_abs_diff(x, x_team, n) <= 1e-13*scale);
+	}
+	free(work);
+	free(a.base);
+	return team_err;
+}
+
+int main(void) {
+	gsl_set_error_handler_off();
+	uint64_t state = 1;
+	const size_t max_n = 300;
+	double* diag = malloc(max_n*sizeof(double));
+	double* supdiag = malloc(max_n*sizeof(double));
+	double* subdiag = malloc(max_n*sizeof(double));
+	double* g = malloc(max_n*sizeof(double));
+	double* x = malloc((max_n+2)*sizeof(double));
+	double* y = malloc((max_n+2)*sizeof(double));
+	for (size_t n=2; n<=max_n; n++) {
+		// The not-a-knot spline system through n+2 random knots
+		const size_t N = n+2;
+		x[0] = 0;
+		for (size_t i=1; i<N; i++) {
+			x[i] = x[i-1] + 0.5 + 10*uniform(&state);
+		}
+		for (size_t i=0; i<N; i++) {
+			y[i] = uniform(&state) - 0.5;
+		}
+		_spline_matrix(x, N, diag, supdiag, subdiag);
+		_spline_rhs(x, y, N, g);
+		compare(diag, supdiag, subdiag, g, n);
+		// A random diagonally dominant system
+		for (size_t i=0; i<n; i++) {
+			diag[i] = 2.5 + uniform(&state);
+			g[i] = 10*(uniform(&state) - 0.5);
+		}
+		for (size_t i=0; i<n-1; i++) {
+			supdiag[i] = 2*uniform(&state) - 1;
+			subdiag[i] = 2*uniform(&state) - 1;
+		}
+		compare(diag, supdiag, subdiag, g, n);
+	}
+	// A singular system is detected
+	diag[0] = 0;
+	CHECK(_solve_tridiag(diag, supdiag, subdiag, g, x, 10) == EMD_SINGULAR_SPLINE_SYSTEM);
+	// Systems of several partitions for the partitioned solver
+	const size_t team_sizes[] = {2*_MIN_PARTITION_SIZE, 5000, 3*_MIN_PARTITION_SIZE+1};
+	const size_t max_team_n = 5000;
+	double* team_diag = malloc(max_team_n*sizeof(double));
+	double* team_supdiag = malloc(max_team_n*sizeof(double));
+	double* team_subdiag = malloc(max_team_n*sizeof(double));
+	double* team_g = malloc(max_team_n*sizeof(double));
+	double* knots = malloc((max_team_n+2)*sizeof(double));
+	double* values = malloc((max_team_n+2)*sizeof(double));
+	for (int num_threads=2; num_threads<=4; num_threads++) {
+		for (size_t t=0; t<sizeof(team_sizes)/sizeof(team_sizes[0]); t++) {
+			const size_t n = team_sizes[t];
+			const size_t N = n+2;
+			knots[0] = 0;
+			for (size_t i=1; i<N; i++) {
+				knots[i] = knots[i-1] + 0.5 + 10*uniform(&state);
+			}
+			for (size_t i=0; i<N; i++) {
+				values[i] = uniform(&state) - 0.5;
+			}
+			_spline_matrix(knots, N, team_diag, team_supdiag, team_subdiag);
+			_spline_rhs(knots, values, N, team_g);
+			CHECK(compare_team(team_diag, team_supdiag, team_subdiag, team_g, n,
+						num_threads) == EMD_SUCCESS);
+			// A row of zeros in the middle of a partition, and at the start
+			// of the second partition, makes the system singular
+			size_t num_parts = n/_MIN_PARTITION_SIZE;
+			if (num_parts > (size_t)num_threads) {
+				num_parts = (size_t)num_threads;
+			}
+			const size_t zero_rows[] = {n - n/(2*num_parts), _chunk_start(n, num_parts, 1)};
+			for (size_t z=0; z<2; z++) {
+				const size_t i = zero_rows[z];
+				const double saved[3] = {team_diag[i], team_supdiag[i], team_subdiag[i-1]};
+				team_diag[i] = 0;
+				team_supdiag[i] = 0;
+				team_subdiag[i-1] = 0;
+				CHECK(compare_team(team_diag, team_supdiag, team_subdiag, team_g, n,
+							num_threads) == EMD_SINGULAR_SPLINE_SYSTEM);
+				team_diag[i] = saved[0];
+				team_supdiag[i] = saved[1];
+				team_subdiag[i-1] = saved[2];
+			}
+		}
+	}
+	// The routines never use the partitioned solver
+	emd_plan* plan = _create_routine_plan(EMD_VARIANT_EEMD, 1000, 0, 1, 0,
+			EMD_PRECISION_DOUBLE);
+	CHECK(plan != NULL && plan->parallel_solve_min_knots == 0);
+	emd_plan_destroy(plan);
+	free(values);
+	free(knots);
+	free(team_g);
+	free(team_subdiag);
+	free(team_supdiag);
+	free(team_diag);
+	free(y);
+	free(x);
+	free(g);
+	free(subdiag);
+	free(supdiag);
+	free(diag);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,187 @@
+/* Copyright 2013 Perttu Luukko
+
+ * This file is part of libeemd.
+
+ * libeemd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libeemd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Plans carved from a workspace given by the caller and from a block
+// allocated by a callback, compared with plans allocating their own memory.
+// The memory is filled with garbage first. The results of CEEMDAN must be
+// identical. EEMD with two threads sums the ensemble members in the order
+// they finish, which changes its results by rounding. A workspace smaller
+// than emd_plan_workspace_size or misaligned must be refused, the allocator
+// must be called once for the whole block and the deallocator when the plan
+// is destroyed. Invalid options must give no plan and a workspace size of
+// zero. A plan placing memory on NUMA nodes, if libeemd was built with them,
+// must refuse a workspace that is not aligned to a page.
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "eemd.h"
+#include "check.h"
+
+const size_t N = 2000;
+const unsigned int ensemble_size = 4;
+const unsigned int num_threads = 2;
+const unsigned int num_siftings = 10;
+const double noise_strength = 0.2;
+const unsigned long int rng_seed = 11;
+
+// Allocator that counts its calls and remembers the last block
+typedef struct {
+	unsigned int num_allocations;
+	unsigned int num_deallocations;
+	size_t size;
+	void* block;
+} allocator_log;
+
+static void* logged_allocate(size_t size, void* context) {
+	allocator_log* log = context;
+	log->num_allocations++;
+	log->size = size;
+	log->block = malloc(size);
+	if (log->block != NULL) {
+		memset(log->block, 0xff, size);
+	}
+	return log->block;
+}
+
+static void logged_deallocate(void* ptr, void* context) {
+	allocator_log* log = context;
+	log->num_deallocations++;
+	CHECK(ptr == log->block);
+	free(ptr);
+}
+
+// Create a plan with options, decompose input with it to output and destroy
+// it. Returns false if the plan could not be created.
+static bool decompose(emd_variant variant, emd_plan_options const* options,
+		double const* input, double* output, size_t M) {
+	emd_plan* plan = emd_plan_create_with_options(variant, N, M, ensemble_size,
+			num_threads, options);
+	if (plan == NULL) {
+		return false;
+	}
+	CHECK(emd_plan_execute(plan, input, output, noise_strength, 0,
+				num_siftings, rng_seed) == EMD_SUCCESS);
+	emd_plan_destroy(plan);
+	return true;
+}
+
+static void compare(emd_variant variant, double const* input) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	double* output = malloc(M*N*sizeof(double));
+	const double tolerance = (variant == EMD_VARIANT_EEMD)? 1e-14 : 0;
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	CHECK(decompose(variant, &options, input, reference, M));
+	const size_t size = emd_plan_workspace_size(variant, N, M, ensemble_size,
+			num_threads, &options);
+	CHECK(size > 0);
+	// A workspace of exactly the right size
+	char* memory = malloc(size + 2*EMD_WORKSPACE_ALIGNMENT);
+	memset(memory, 0xff, size + 2*EMD_WORKSPACE_ALIGNMENT);
+	char* const workspace = memory + (EMD_WORKSPACE_ALIGNMENT
+			- (uintptr_t)memory%EMD_WORKSPACE_ALIGNMENT)%EMD_WORKSPACE_ALIGNMENT;
+	options.workspace = workspace;
+	options.workspace_size = size;
+	CHECK(decompose(variant, &options, input, output, M));
+	CHECK(max_abs_diff(output, reference, M*N) <= tolerance);
+	// Too small and misaligned workspaces
+	options.workspace_size = size-1;
+	CHECK(emd_plan_create_with_options(variant, N, M, ensemble_size,
+				num_threads, &options) == NULL);
+	options.workspace = workspace + sizeof(double);
+	options.workspace_size = size + EMD_WORKSPACE_ALIGNMENT;
+	CHECK(emd_plan_create_with_options(variant, N, M, ensemble_size,
+				num_threads, &options) == NULL);
+	free(memory);
+	// A block from the allocator of the caller
+	allocator_log log = {0, 0, 0, NULL};
+	options.workspace = NULL;
+	options.workspace_size = 0;
+	options.allocate = logged_allocate;
+	options.deallocate = logged_deallocate;
+	options.allocator_context = &log;
+	emd_plan* plan = emd_plan_create_with_options(variant, N, M, ensemble_size,
+			num_threads, &options);
+	CHECK(plan != NULL);
+	CHECK(log.num_allocations == 1);
+	CHECK(log.size == size + EMD_WORKSPACE_ALIGNMENT - 1);
+	CHECK(log.num_deallocations == 0);
+	if (plan != NULL) {
+		CHECK(emd_plan_execute(plan, input, output, noise_strength, 0,
+					num_siftings, rng_seed) == EMD_SUCCESS);
+		CHECK(max_abs_diff(output, reference, M*N) <= tolerance);
+		emd_plan_destroy(plan);
+	}
+	CHECK(log.num_allocations == 1);
+	CHECK(log.num_deallocations == 1);
+	// Invalid options
+	emd_plan_options_init(&options);
+	options.accumulation = (emd_accumulation_mode)2;
+	CHECK(emd_plan_workspace_size(variant, N, M, ensemble_size, num_threads,
+				&options) == 0);
+	CHECK(emd_plan_create_with_options(variant, N, M, ensemble_size,
+				num_threads, &options) == NULL);
+	free(output);
+	free(reference);
+}
+
+static void compare_numa(double const* input) {
+	const size_t M = emd_num_imfs(N);
+	double* reference = malloc(M*N*sizeof(double));
+	double* output = malloc(M*N*sizeof(double));
+	emd_plan_options options;
+	emd_plan_options_init(&options);
+	options.threading = EMD_THREADS_POOL;
+	options.numa = EMD_NUMA_LOCAL;
+	if (!decompose(EMD_VARIANT_EEMD, &options, input, reference, M)) {
+		// Built without the pool or NUMA placement
+		free(output);
+		free(reference);
+		return;
+	}
+	const size_t size = emd_plan_workspace_size(EMD_VARIANT_EEMD, N, M,
+			ensemble_size, num_threads, &options);
+	const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	char* memory = malloc(size + 2*page_size);
+	char* const workspace = memory + (page_size
+			- (uintptr_t)memory%page_size)%page_size;
+	options.workspace = workspace;
+	options.workspace_size = size;
+	CHECK(decompose(EMD_VARIANT_EEMD, &options, input, output, M));
+	CHECK(max_abs_diff(output, reference, M*N) <= 1e-14);
+	if (page_size > EMD_WORKSPACE_ALIGNMENT) {
+		options.workspace = workspace + EMD_WORKSPACE_ALIGNMENT;
+		CHECK(emd_plan_create_with_options(EMD_VARIANT_EEMD, N, M,
+					ensemble_size, num_threads, &options) == NULL);
+	}
+	free(memory);
+	free(output);
+	free(reference);
+}
+
+int main(void) {
+	double* input = malloc(N*sizeof(double));
+	test_signal(input, N, 0);
+	compare(EMD_VARIANT_EEMD, input);
+	compare(EMD_VARIANT_CEEMDAN, input);
+	compare_numa(input);
+	free(input);
+	return (num_failures == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+}